@@ -5,6 +5,7 @@
 #include <ucontext.h>
 #include "co.h"
 #include "co_pqueue.h"
+#include "tracing.h"
 
 
 pthread_key_t co_sched_key = 0;
@@ -89,7 +90,9 @@ void *co_schedule_loop(sched_t s)
                    (unsigned long)s->co_current, s->co_current->name);
 
             /* ** ENTERING THREAD ** - by switching the machine context */
+            unsigned long long span = wpr_span_begin();
             swapcontext(&s->sched_mctx, &s->co_current->mctx);
+            wpr_span_end("co_run", "co", span, "co", s->co_current->name);
 
             printf("co_scheduler: cameback from thread 0x%lx (\"%s\")\n",
                    (unsigned long)s->co_current, s->co_current->name);
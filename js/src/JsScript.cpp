@@ -1,6 +1,7 @@
 #include "JsScript.h"
 #include "JsScriptObjectActivation.h"
 #include "JsScriptParser.h"
+#include "tracing.h"
 
 static const std::string InitC("<init>");
 
@@ -48,12 +49,16 @@ ScriptValue
 Script::execute(
    ScriptExecutionContext* theExecutionContext)
 {
+   wpr_tracing::TraceSpan span("Script::execute", "js");
+   span.arg("file", filenameM.c_str());
    theExecutionContext->resetNumberOfExecutedNodes();
    Time startTime(Time::getUtcTime());
    ScriptValue result;
    if (codeM != 0)
    {
       result = codeM->execute(theExecutionContext);
+      // Do not leave a 'return' or 'break' of the script pending
+      result.resetCommand();
    }
    statisticsM.countFunctionCall(
       InitC, 
@@ -70,6 +75,8 @@ Script::executeFunction(
    const std::string&           theFunctionName,
    const ScriptValueArray& theArguments)
 {
+   wpr_tracing::TraceSpan span("Script::executeFunction", "js");
+   span.arg("function", theFunctionName.c_str());
    theExecutionContext->traceFunctionCall(0, theFunctionName, theArguments);
 
    ScriptValue fctRef(theExecutionContext->getIdentifier(theFunctionName));
@@ -0,0 +1,103 @@
+#include "JsScriptAtom.h"
+#include "JsScriptMutex.h"
+#include <map>
+
+using namespace Js;
+
+// The interned names and the entries of their atoms
+struct ScriptAtom::Table
+{
+   ScriptMutex                     lockM;
+   std::map<std::string, Entry*>   entriesM;
+};
+
+// ----------------------------------------------------------------------------
+
+ScriptAtom::Table&
+ScriptAtom::getTable()
+{
+   // Never deleted, static atoms are released when the process exits
+   static Table* table = new Table;
+   return *table;
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptAtom
+ScriptAtom::intern(
+   const std::string& theName)
+{
+   Table& table = getTable();
+   table.lockM.lock();
+   Entry* entry;
+   std::map<std::string, Entry*>::iterator iter = 
+      table.entriesM.find(theName);
+   if (iter != table.entriesM.end())
+   {
+      entry = (*iter).second;
+#ifdef WIN32
+      InterlockedIncrement(&entry->referencesM);
+#else
+      __sync_add_and_fetch(&entry->referencesM, 1);
+#endif
+   }
+   else
+   {
+      entry = new Entry;
+      entry->nameM = theName;
+      entry->referencesM = 1;
+      table.entriesM.insert(std::make_pair(theName, entry));
+   }
+   table.lockM.unlock();
+   return ScriptAtom(entry);
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptAtom::removeReference()
+{
+   if (entryM == 0)
+   {
+      return;
+   }
+   // Only the last reference is removed under the lock of the table, so
+   // that intern() can't find an entry that is being deleted
+   for (;;)
+   {
+      long references = entryM->referencesM;
+      if (references == 1)
+      {
+         break;
+      }
+#ifdef WIN32
+      if (InterlockedCompareExchange(&entryM->referencesM,
+                                     references - 1,
+                                     references) == references)
+#else
+      if (__sync_bool_compare_and_swap(&entryM->referencesM,
+                                       (int)references,
+                                       (int)references - 1) == true)
+#endif
+      {
+         return;
+      }
+   }
+
+   Table& table = getTable();
+   table.lockM.lock();
+#ifdef WIN32
+   bool isLast = InterlockedDecrement(&entryM->referencesM) == 0;
+#else
+   bool isLast = __sync_sub_and_fetch(&entryM->referencesM, 1) == 0;
+#endif
+   if (isLast == true)
+   {
+      table.entriesM.erase(entryM->nameM);
+      delete entryM;
+   }
+   table.lockM.unlock();
+   entryM = 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,225 @@
+#ifndef PALSCRIPTATOM_H
+#define PALSCRIPTATOM_H
+
+#ifdef WIN32
+#   include "JsWinInclude.h"
+#endif
+
+#include <string>
+
+namespace Js
+{
+   /** \class ScriptAtom ScriptAtom.h "ScriptAtom.h"
+    * \ingroup PALSCRIPT
+    * Interned name of an identifier or a property.
+    * Equal names are interned to the same atom, so atoms are compared
+    * and ordered by their address instead of by their characters.
+    * Only the names in the source of a script and a few predefined names
+    * are interned; names computed at run time are used as strings.
+    * An atom is removed from the table when its last copy is destroyed.
+    */
+   class ScriptAtom
+   {
+   public:
+
+      /**
+       * Create the null atom, which is the name of no property.
+       */
+      ScriptAtom();
+
+      ScriptAtom(
+         const ScriptAtom& theOther);
+
+      ~ScriptAtom();
+
+      ScriptAtom&
+      operator=(
+         const ScriptAtom& theOther);
+
+      bool
+      operator==(
+         const ScriptAtom& theOther) const;
+
+      bool
+      operator!=(
+         const ScriptAtom& theOther) const;
+
+      /**
+       * Order atoms by their address.
+       * The order is stable but unrelated to the order of the names.
+       */
+      bool
+      operator<(
+         const ScriptAtom& theOther) const;
+
+      /**
+       * Get the name of the atom.
+       */
+      const std::string&
+      getName() const;
+
+      /**
+       * Get the atom of a name, the name is interned if necessary.
+       * The table of the atoms is locked, so this should only be done
+       * when a script is parsed.
+       */
+      static
+      ScriptAtom
+      intern(
+         const std::string& theName);
+
+      bool
+      isNull() const;
+
+   private:
+
+      struct Entry
+      {
+         std::string   nameM;
+#ifdef WIN32
+         volatile long referencesM;
+#else
+         volatile int  referencesM;
+#endif
+      };
+
+      struct Table;
+
+      explicit
+      ScriptAtom(
+         Entry* theEntry);
+
+      static
+      Table&
+      getTable();
+
+      void
+      addReference();
+
+      void
+      removeReference();
+
+      Entry* entryM;      // entry of the atom table, 0 for the null atom
+   };
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptAtom::ScriptAtom()
+   :  entryM(0)
+   {
+      // Empty
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptAtom::ScriptAtom(
+      Entry* theEntry)
+   :  entryM(theEntry)
+   {
+      // The reference has been counted by the table
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptAtom::ScriptAtom(
+      const ScriptAtom& theOther)
+   :  entryM(theOther.entryM)
+   {
+      addReference();
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptAtom::~ScriptAtom()
+   {
+      removeReference();
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptAtom&
+   ScriptAtom::operator=(
+      const ScriptAtom& theOther)
+   {
+      if (entryM != theOther.entryM)
+      {
+         removeReference();
+         entryM = theOther.entryM;
+         addReference();
+      }
+      return *this;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   bool
+   ScriptAtom::operator==(
+      const ScriptAtom& theOther) const
+   {
+      return entryM == theOther.entryM;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   bool
+   ScriptAtom::operator!=(
+      const ScriptAtom& theOther) const
+   {
+      return entryM != theOther.entryM;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   bool
+   ScriptAtom::operator<(
+      const ScriptAtom& theOther) const
+   {
+      return entryM < theOther.entryM;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   void
+   ScriptAtom::addReference()
+   {
+      // A copy is made of an existing atom, so the count is not 0 and
+      // no lock is needed
+      if (entryM != 0)
+      {
+#ifdef WIN32
+         InterlockedIncrement(&entryM->referencesM);
+#else
+         __sync_add_and_fetch(&entryM->referencesM, 1);
+#endif
+      }
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   const std::string&
+   ScriptAtom::getName() const
+   {
+      return entryM->nameM;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   bool
+   ScriptAtom::isNull() const
+   {
+      return entryM == 0;
+   }
+}
+
+#endif
@@ -121,6 +121,24 @@ ScriptExecutionContext::getIdentifier(
 
 // ----------------------------------------------------------------------------
 
+ScriptValue
+ScriptExecutionContext::getIdentifier(
+   const ScriptAtom& theName)
+{
+   for (ObjectList::iterator iter = scopeChainM.begin();
+        iter != scopeChainM.end();
+        iter++)
+   {
+      if ((*iter)->hasProperty(theName) != 0)
+      {
+         return ScriptValue(*iter, theName);
+      }
+   }
+   return ScriptValue(0, theName);
+}
+
+// ----------------------------------------------------------------------------
+
 void
 ScriptExecutionContext::getPropertyNames(
    std::vector<std::string>& thePropertyNames) const
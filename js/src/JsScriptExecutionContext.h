@@ -101,6 +101,15 @@ namespace Js
       getIdentifier(
          const std::string& theName);
 
+      /**
+       * Return the value of the specified identifier.
+       * @param theName the atom of the name of the identifier.
+       * @return The value of the identifier.
+       */
+      ScriptValue
+      getIdentifier(
+         const ScriptAtom& theName);
+
       /**
        * Get the identifier of the subscriber specific trace log.
        * @return the identifier of the subscriber specific trace log.
@@ -188,6 +197,11 @@ namespace Js
          const std::string&      thePropertyName,
          const ScriptValue& theValue);
 
+      void
+      putPropertyNoCheck(
+         const ScriptAtom&  thePropertyName,
+         const ScriptValue& theValue);
+
       int
       registerAsyncRespReceiver(
          ScriptAsyncRespInterface* theAsyncRespReceiver);
@@ -469,6 +483,17 @@ namespace Js
    
    // -------------------------------------------------------------------------
 
+   inline
+   void
+   ScriptExecutionContext::putPropertyNoCheck(
+      const ScriptAtom&  thePropertyName,
+      const ScriptValue& theValue)
+   {
+      scopeChainM.front()->putPropertyNoCheck(thePropertyName, theValue);
+   }
+   
+   // -------------------------------------------------------------------------
+
    inline
    int
    ScriptExecutionContext::registerAsyncRespReceiver(
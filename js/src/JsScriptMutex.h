@@ -0,0 +1,99 @@
+#ifndef PALSCRIPTMUTEX_H
+#define PALSCRIPTMUTEX_H
+
+#ifdef WIN32
+#   include "JsWinInclude.h"
+#else
+#   include <pthread.h>
+#endif
+
+namespace Js
+{
+   /** \class ScriptMutex ScriptMutex.h "ScriptMutex.h"
+    * \ingroup PALSCRIPT
+    * Mutex protecting tables that are shared by all scripts.
+    */
+   class ScriptMutex
+   {
+   public:
+
+      ScriptMutex();
+
+      ~ScriptMutex();
+
+      void
+      lock();
+
+      void
+      unlock();
+
+   private:
+
+      // Not implemented
+      ScriptMutex(
+         const ScriptMutex& theOther);
+
+      // Not implemented
+      ScriptMutex&
+      operator=(
+         const ScriptMutex& theOther);
+
+#ifdef WIN32
+      CRITICAL_SECTION lockM;
+#else
+      pthread_mutex_t  lockM;
+#endif
+   };
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptMutex::ScriptMutex()
+   {
+#ifdef WIN32
+      InitializeCriticalSection(&lockM);
+#else
+      pthread_mutex_init(&lockM, 0);
+#endif
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptMutex::~ScriptMutex()
+   {
+#ifdef WIN32
+      DeleteCriticalSection(&lockM);
+#else
+      pthread_mutex_destroy(&lockM);
+#endif
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   void
+   ScriptMutex::lock()
+   {
+#ifdef WIN32
+      EnterCriticalSection(&lockM);
+#else
+      pthread_mutex_lock(&lockM);
+#endif
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   void
+   ScriptMutex::unlock()
+   {
+#ifdef WIN32
+      LeaveCriticalSection(&lockM);
+#else
+      pthread_mutex_unlock(&lockM);
+#endif
+   }
+}
+
+#endif
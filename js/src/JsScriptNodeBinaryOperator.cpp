@@ -18,9 +18,13 @@ ScriptNodeBinaryOperator::ScriptNodeBinaryOperator(
 :  ScriptNode(theFile, theLine, theIsLeftHandSideExpression),
    op1M(theOperand1),
    op2M(theOperand2),
-   operatorM(theOperator)
+   operatorM(theOperator),
+   cacheM(0)
 {
-   // Empty
+   if (operatorM == ScriptScanner::LeftBracketE)
+   {
+      cacheM = new ScriptPropertyCache;
+   }
 }
 
 // ----------------------------------------------------------------------------
@@ -31,6 +35,8 @@ ScriptNodeBinaryOperator::~ScriptNodeBinaryOperator()
    op1M = 0;
    delete op2M;
    op2M = 0;
+   delete cacheM;
+   cacheM = 0;
 }
 
 // ----------------------------------------------------------------------------
@@ -396,15 +402,15 @@ ScriptNodeBinaryOperator::execute(
             {
                result = op1M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
             }
             while (op2M->execute(theContext).getValue() == true);        
             result.resetCommand();
@@ -425,7 +431,7 @@ ScriptNodeBinaryOperator::execute(
                op2 = op2.getReferenceValue();
             }
      
-            return ScriptValue(op1, op2);
+            return ScriptValue(op1, op2, cacheM);
          }
          case ScriptScanner::EqualityE:
          {
@@ -454,15 +460,15 @@ ScriptNodeBinaryOperator::execute(
             {
                result = op2M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
                op1M->execute(theContext);
             }
             result.resetCommand();
@@ -477,15 +483,15 @@ ScriptNodeBinaryOperator::execute(
             {
                result = op2M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
             }
             result.resetCommand();
             return ScriptValue::UndefinedC;
@@ -510,15 +516,15 @@ ScriptNodeBinaryOperator::execute(
             {
                result = op2M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
             }
             result.resetCommand();
             return result;
@@ -541,19 +547,25 @@ ScriptNodeBinaryOperator::execute(
             ScriptValue op2(op2M->execute(theContext).getValue());
             ScriptObject* object = op2.toObject();
             
-            std::string propertyName;
-            if (object->getNameOfFirstProperty(propertyName) == false)
+            // Enumerate a snapshot, the properties may change in the loop
+            std::vector<std::string> propertyNames;
+            object->getNamesOfProperties(propertyNames);
+            if (propertyNames.empty() == true)
             {
                // There is no first property
                return ScriptValue::UndefinedC;
             }
 
             ScriptValue op1Ref(op1M->execute(theContext));
-            do
+            for (size_t i = 0; i < propertyNames.size(); i++)
             {
-               op1Ref.putValue(propertyName);
+               if (object->hasProperty(propertyNames[i]) == false)
+               {
+                  // Deleted before it was visited (ECMA-262 12.6.4)
+                  continue;
+               }
+               op1Ref.putValue(propertyNames[i]);
             }
-            while (object->getNameOfNextProperty(propertyName) == true);
             return ScriptValue::UndefinedC;            
          }
          case ScriptScanner::IfE:
@@ -645,7 +657,7 @@ ScriptNodeBinaryOperator::execute(
                op2 = op2.getReferenceValue();
             }
          
-            return ScriptValue(op1, op2);
+            return ScriptValue(op1, op2, cacheM);
          }
          case ScriptScanner::LogicalAndE:
          {
@@ -829,7 +841,11 @@ ScriptNodeBinaryOperator::execute(
                result = op1M->execute(theContext);
                if (op2M != 0)
                {
+                  // The finally block does not change how op1 completed
+                  ScriptValue::Command command = result.getCommand();
+                  result.resetCommand();
                   op2M->execute(theContext);
+                  result.setCommand(command);
                }
                return result;
             }
@@ -838,6 +854,7 @@ ScriptNodeBinaryOperator::execute(
                if (op2M != 0)
                {
                   op2M->execute(theContext);
+                  result.resetCommand();
                }
                throw;
             }
@@ -871,15 +888,15 @@ ScriptNodeBinaryOperator::execute(
             {
                result = op2M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
             }
             result.resetCommand();
             return result;
@@ -2,6 +2,7 @@
 #define PALSCRIPTNODEBINARYOPERATOR_H
 
 #include "JsScriptNode.h"
+#include "JsScriptPropertyCache.h"
 #include "JsScriptScanner.h"
 
 namespace Js
@@ -110,6 +111,7 @@ namespace Js
       ScriptNode*          op1M;
       ScriptNode*          op2M;
       ScriptScanner::Token operatorM;
+      ScriptPropertyCache* cacheM;      // only used by subscripts
    };
 
    // -------------------------------------------------------------------------
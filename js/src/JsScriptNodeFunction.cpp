@@ -16,7 +16,10 @@ ScriptNodeFunction::ScriptNodeFunction(
    nameM(theName),
    nameIsVisibleM(theNameIsVisible)
 {
-   // Empty
+   if (nameM.empty() == false)
+   {
+      atomM = ScriptAtom::intern(nameM);
+   }
 }
 
 // ----------------------------------------------------------------------------
@@ -37,7 +40,7 @@ void
 ScriptNodeFunction::addParameter(
    const std::string& theParameterName)
 {
-   parameterListM.push_back(theParameterName);
+   parameterListM.push_back(ScriptAtom::intern(theParameterName));
 }
 
 // ----------------------------------------------------------------------------
@@ -82,12 +85,13 @@ ScriptNodeFunction::call(
       argumentArray->putPropertyNoCheck(i, theArguments[i]);
    }
    
-   theContext->putPropertyNoCheck(ArgumentsC, argumentArray);
+   static const ScriptAtom argumentsAtom(ScriptAtom::intern(ArgumentsC));
+   theContext->putPropertyNoCheck(argumentsAtom, argumentArray);
 
    if (nameIsVisibleM == false && nameM.empty() == false)
    {
       ScriptValue functionObject(new ScriptObjectFunction(this));
-      theContext->putPropertyNoCheck(nameM, functionObject);
+      theContext->putPropertyNoCheck(atomM, functionObject);
    }
 
    // Execute all statements of the function
@@ -97,9 +101,10 @@ ScriptNodeFunction::call(
         iter2++)
    {
       result = (*iter2)->execute(theContext);
-      if (result.getCommand() == ScriptValue::ReturnE)
+      ScriptValue::Command command = result.getCommand();
+      result.resetCommand();
+      if (command == ScriptValue::ReturnE)
       {
-         result.resetCommand();
          return result;
       }
    }
@@ -116,7 +121,7 @@ ScriptNodeFunction::execute(
    ScriptValue functionObject(new ScriptObjectFunction(this));
    if (nameIsVisibleM == true)
    {
-      theExecutionContext->putPropertyNoCheck(nameM, functionObject);
+      theExecutionContext->putPropertyNoCheck(atomM, functionObject);
    }
    return functionObject;
 }
@@ -156,7 +161,7 @@ ScriptNodeFunction::print(
         iter1 != parameterListM.end();
         iter1 = next1)
    {
-      theOutputString += *iter1;
+      theOutputString += (*iter1).getName();
       next1 = iter1;
       next1++;
       if (next1 != parameterListM.end())
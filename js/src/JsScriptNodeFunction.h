@@ -12,7 +12,7 @@ namespace Js
    {
    public:
 
-      typedef std::list<std::string>      ParameterList;
+      typedef std::list<ScriptAtom>  ParameterList;
       typedef std::list<ScriptNode*> StatementList;
 
       ScriptNodeFunction(
@@ -121,6 +121,7 @@ namespace Js
    private:
 
       std::string        nameM;
+      ScriptAtom    atomM;           // null if the function is anonymous
       bool          nameIsVisibleM;
       ParameterList parameterListM;
       StatementList statementListM;
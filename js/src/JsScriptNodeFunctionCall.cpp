@@ -7,8 +7,8 @@
 
 using namespace Js;
 
-static const std::string PrototypeC("prototype");
-static const std::string ThisC("this");
+static const ScriptAtom PrototypeC(ScriptAtom::intern("prototype"));
+static const ScriptAtom ThisC(ScriptAtom::intern("this"));
 
 ScriptNodeFunctionCall::ScriptNodeFunctionCall(
    const ScriptString* theFile,
@@ -10,8 +10,8 @@ ScriptNodeIdDotLiteral::ScriptNodeIdDotLiteral(
    const std::string&       theIdentifier,
    const std::string&       theLiteral)
 :  ScriptNode(theFile, theLine, true),
-   identifierM(theIdentifier),
-   literalM(theLiteral)
+   identifierM(ScriptAtom::intern(theIdentifier)),
+   literalM(ScriptAtom::intern(theLiteral))
 {
    // Empty
 }
@@ -28,7 +28,7 @@ ScriptNodeIdDotLiteral::execute(
    {
       op1 = op1.getReferenceValue();
    }
-   return ScriptValue(op1.toObject(), literalM);
+   return ScriptValue(op1.toObject(), literalM, &cacheM);
 }
 
 // ----------------------------------------------------------------------------
@@ -51,7 +51,7 @@ ScriptNodeIdDotLiteral::print(
    { 
       printFileAndLine(theOutputString, theMaxFilenameLength);
    }
-   theOutputString += identifierM + " . " + literalM + "'\n";
+   theOutputString += getIdentifier() + " . " + getLiteral() + "'\n";
 }
 
 
@@ -2,6 +2,7 @@
 #define PALSCRIPTNODEIDDOTLITERAL_H
 
 #include "JsScriptNode.h"
+#include "JsScriptPropertyCache.h"
 #include "JsScriptValue.h"
 
 namespace Js
@@ -75,8 +76,9 @@ namespace Js
       ScriptNodeIdDotLiteral(
          const ScriptNodeIdDotLiteral& theOther);
 
-      std::string identifierM;   
-      std::string literalM;   
+      ScriptAtom  identifierM;   // interned when the script is parsed
+      ScriptAtom  literalM;   
+      ScriptPropertyCache cacheM;
    };
 
    // -------------------------------------------------------------------------
@@ -85,7 +87,7 @@ namespace Js
    const std::string&
    ScriptNodeIdDotLiteral::getIdentifier() const
    {
-      return identifierM;
+      return identifierM.getName();
    }
 
    // -------------------------------------------------------------------------
@@ -94,7 +96,7 @@ namespace Js
    const std::string&
    ScriptNodeIdDotLiteral::getLiteral() const
    {
-      return literalM;
+      return literalM.getName();
    }
 }
 
@@ -9,7 +9,7 @@ ScriptNodeIdentifier::ScriptNodeIdentifier(
    int                 theLine,
    const std::string&       theIdentifier)
 :  ScriptNode(theFile, theLine, true),
-   identifierM(theIdentifier)
+   identifierM(ScriptAtom::intern(theIdentifier))
 {
    // Empty
 }
@@ -37,7 +37,7 @@ ScriptNodeIdentifier::getType() const
 ScriptValue
 ScriptNodeIdentifier::getValue() const
 {
-   return ScriptValue(identifierM);
+   return ScriptValue(identifierM.getName());
 }
 
 // ----------------------------------------------------------------------------
@@ -53,7 +53,7 @@ ScriptNodeIdentifier::print(
       printFileAndLine(theOutputString, theMaxFilenameLength);
    }
    theOutputString += "Identifier '";
-   theOutputString += identifierM + "'\n";
+   theOutputString += identifierM.getName() + "'\n";
 }
 
 
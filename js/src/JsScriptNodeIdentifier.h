@@ -73,7 +73,7 @@ namespace Js
       ScriptNodeIdentifier(
          const ScriptNodeIdentifier& theOther);
 
-      std::string identifierM;   
+      ScriptAtom  identifierM;   // interned when the script is parsed
    };
 
    // -------------------------------------------------------------------------
@@ -82,7 +82,7 @@ namespace Js
    const std::string&
    ScriptNodeIdentifier::getIdentifier() const
    {
-      return identifierM;
+      return identifierM.getName();
    }
 }
 
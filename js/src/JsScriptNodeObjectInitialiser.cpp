@@ -24,7 +24,7 @@ ScriptNodeObjectInitialiser::~ScriptNodeObjectInitialiser()
         iter != objectInitialiserMapM.end();
         iter++)
    {
-      delete (*iter).second;
+      delete (*iter).second.nodeM;
    }
    objectInitialiserMapM.clear();
 }
@@ -36,9 +36,11 @@ ScriptNodeObjectInitialiser::addElement(
    const std::string& thePropertyName,
    ScriptNode*   theAssignmentExpression)
 {
+   Element element;
+   element.atomM = ScriptAtom::intern(thePropertyName);
+   element.nodeM = theAssignmentExpression;
    objectInitialiserMapM.insert(
-      ObjectInitialiserMap::value_type(thePropertyName, 
-                                      theAssignmentExpression));
+      ObjectInitialiserMap::value_type(thePropertyName, element));
 }
 
 // ----------------------------------------------------------------------------
@@ -55,8 +57,9 @@ ScriptNodeObjectInitialiser::execute(
            iter != objectInitialiserMapM.end();
            iter++)
       {
-         ScriptValue result = (*iter).second->execute(theContext).getValue();
-         object->putPropertyNoCheck((*iter).first, result);
+         ScriptValue result = 
+            (*iter).second.nodeM->execute(theContext).getValue();
+         object->putPropertyNoCheck((*iter).second.atomM, result);
       }
       return ScriptValue(object);
    }
@@ -115,8 +118,8 @@ ScriptNodeObjectInitialiser::print(
         iter != objectInitialiserMapM.end();
         iter = next)
    {
-      (*iter).second->printFileAndLine(theOutputString, 
-                                       theMaxFilenameLength);
+      (*iter).second.nodeM->printFileAndLine(theOutputString, 
+                                             theMaxFilenameLength);
       theOutputString += theLinePrefix + " +-";
       theOutputString += (*iter).first;
       theOutputString += ": ";
@@ -124,15 +127,15 @@ ScriptNodeObjectInitialiser::print(
       next++;
       if (next != objectInitialiserMapM.end())
       {
-         (*iter).second->print(theOutputString, 
-                               theLinePrefix + " | ",
-                               theMaxFilenameLength);
+         (*iter).second.nodeM->print(theOutputString, 
+                                     theLinePrefix + " | ",
+                                     theMaxFilenameLength);
       }
       else
       {
-         (*iter).second->print(theOutputString, 
-                               theLinePrefix + "   ",
-                               theMaxFilenameLength);
+         (*iter).second.nodeM->print(theOutputString, 
+                                     theLinePrefix + "   ",
+                                     theMaxFilenameLength);
          break;
       }
    }
@@ -1,6 +1,7 @@
 #ifndef PALSCRIPTNODEOBJECTINITIALISER_H
 #define PALSCRIPTNODEOBJECTINITIALISER_H
 
+#include "JsScriptAtom.h"
 #include "JsScriptNode.h"
 #include "JsScriptScanner.h"
 
@@ -73,7 +74,13 @@ namespace Js
       ScriptNodeObjectInitialiser(
          const ScriptNodeObjectInitialiser& theOther);
          
-      typedef std::map<std::string, ScriptNode*> ObjectInitialiserMap;
+      struct Element
+      {
+         ScriptAtom  atomM;   // interned when the script is parsed
+         ScriptNode* nodeM;
+      };
+
+      typedef std::map<std::string, Element> ObjectInitialiserMap;
       
       ObjectInitialiserMap objectInitialiserMapM;
    };
@@ -61,15 +61,15 @@ ScriptNodeQuadrupleOperation::execute(
             {
                result = op4M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
                op3M->execute(theContext);
             }
             result.resetCommand();
@@ -118,12 +118,18 @@ ScriptNodeQuadrupleOperation::execute(
                if (op4M != 0)
                {
                   op4M->execute(theContext);
+                  result.resetCommand();
                }
                throw;
             }
             if (op4M != 0)
             {
+               // The finally block does not change how the try or the
+               // catch block completed
+               ScriptValue::Command command = result.getCommand();
+               result.resetCommand();
                op4M->execute(theContext);
+               result.setCommand(command);
             }
             return result;
          }
@@ -56,15 +56,15 @@ ScriptNodeTernaryOperator::execute(
             {
                result = op3M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
                op2M->execute(theContext);
             }
             return ScriptValue(ScriptValue::UndefinedE);
@@ -79,15 +79,15 @@ ScriptNodeTernaryOperator::execute(
             {
                result =op3M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
                op2M->execute(theContext);
             }
             return ScriptValue(ScriptValue::UndefinedE);
@@ -102,15 +102,15 @@ ScriptNodeTernaryOperator::execute(
             {
                result = op3M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
             }
             return ScriptValue(ScriptValue::UndefinedE);
          }
@@ -132,8 +132,10 @@ ScriptNodeTernaryOperator::execute(
             ScriptValue op2 = op2M->execute(theContext).getValue();
             ScriptObject* object = op2.toObject();
             
-            std::string propertyName;
-            if (object->getNameOfFirstProperty(propertyName) == false)
+            // Enumerate a snapshot, so that the body may delete properties
+            std::vector<std::string> propertyNames;
+            object->getNamesOfProperties(propertyNames);
+            if (propertyNames.empty() == true)
             {
                // There is no first property
                return ScriptValue(ScriptValue::UndefinedE);
@@ -141,22 +143,26 @@ ScriptNodeTernaryOperator::execute(
 
             ScriptValue result;
             ScriptValue op1Ref = op1M->execute(theContext);
-            do
+            for (size_t i = 0; i < propertyNames.size(); i++)
             {
-               op1Ref.putValue(propertyName);
-               result = op3M->execute(theContext);
-               ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
+               if (object->hasProperty(propertyNames[i]) == false)
                {
-                  break;
+                  // Deleted before it was visited (ECMA-262 12.6.4)
+                  continue;
                }
-               else
+               op1Ref.putValue(propertyNames[i]);
+               result = op3M->execute(theContext);
+               ScriptValue::Command command = result.getCommand();
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
             }
-            while (object->getNameOfNextProperty(propertyName) == true);
             return ScriptValue(ScriptValue::UndefinedE);            
          }
          case ScriptScanner::IfE:
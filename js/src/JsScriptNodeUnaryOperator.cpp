@@ -86,15 +86,15 @@ ScriptNodeUnaryOperator::execute(
             {
                result = op1M->execute(theContext);
                ScriptValue::Command command = result.getCommand();
-               if (command == ScriptValue::BreakE)
-               {
-                  break;
-               }
-               else
                if (command == ScriptValue::ReturnE)
                {
                   return result;
                }
+               result.resetCommand();
+               if (command == ScriptValue::BreakE)
+               {
+                  break;
+               }
             }
             return ScriptValue(ScriptValue::UndefinedE);
          }
@@ -11,7 +11,7 @@ ScriptNodeVarDeclaration::ScriptNodeVarDeclaration(
    std::string               theIdentifier,
    ScriptNode*          theInitialValue)
 :  ScriptNode(theFile, theLine, false),
-   identifierM(theIdentifier),
+   identifierM(ScriptAtom::intern(theIdentifier)),
    initialValueM(theInitialValue),
    operatorM(theOperator)
 {
@@ -91,11 +91,11 @@ ScriptNodeVarDeclaration::print(
    }
    if (initialValueM == 0)
    {
-      theOutputString += "var " + identifierM + "\n";
+      theOutputString += "var " + getIdentifier() + "\n";
    }
    else
    {
-      theOutputString += "var " + identifierM + " =\n";
+      theOutputString += "var " + getIdentifier() + " =\n";
       initialValueM->printFileAndLine(theOutputString, theMaxFilenameLength);
       theOutputString += theLinePrefix + " +-";
       initialValueM->print(theOutputString, 
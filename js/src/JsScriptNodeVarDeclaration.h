@@ -96,7 +96,8 @@ namespace Js
       ScriptNodeVarDeclaration(
          const ScriptNodeVarDeclaration& theOther);
 
-      std::string               identifierM;
+      ScriptAtom           identifierM;   // interned when the script
+                                          // is parsed
       ScriptNode*          initialValueM;
       ScriptScanner::Token operatorM;
    };
@@ -107,7 +108,7 @@ namespace Js
    const std::string&
    ScriptNodeVarDeclaration::getIdentifier() const
    {
-      return identifierM;
+      return identifierM.getName();
    }
 
    // -------------------------------------------------------------------------
@@ -13,7 +13,8 @@ using namespace Js;
 const std::string 
 ScriptObject::PrototypeC("prototype");
 
-static const std::string ThisC("this");
+static const ScriptAtom PrototypeAtomC(ScriptAtom::intern("prototype"));
+static const ScriptAtom ThisC(ScriptAtom::intern("this"));
 
 // ----------------------------------------------------------------------------
 // THE NAME OF THIS CLASS:
@@ -28,7 +29,8 @@ ScriptObject::ClassNameC = "Object";
 
 ScriptObject::ScriptObject(
    ObjectType theObjectType)
-:  objectTypeM(theObjectType)
+:  objectTypeM(theObjectType),
+   shapeM(ScriptShape::getEmptyShape())
 {
    // Empty
 }
@@ -37,7 +39,7 @@ ScriptObject::ScriptObject(
 
 ScriptObject::~ScriptObject()
 {
-   // Empty
+   shapeM->release();
 }
 
 // ----------------------------------------------------------------------------
@@ -67,6 +69,38 @@ ScriptObject::create(
 
 // ----------------------------------------------------------------------------
 
+void
+ScriptObject::addProperty(
+   const ScriptAtom&     theName,
+   const ScriptProperty& theProperty)
+{
+   ScriptShape* shape = shapeM->addProperty(theName);
+   if (shape != shapeM)
+   {
+      shapeM->release();
+      shapeM = shape;
+   }
+   slotsM.push_back(theProperty);
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptObject::addProperty(
+   const std::string&    theName,
+   const ScriptProperty& theProperty)
+{
+   ScriptShape* shape = shapeM->addProperty(theName);
+   if (shape != shapeM)
+   {
+      shapeM->release();
+      shapeM = shape;
+   }
+   slotsM.push_back(theProperty);
+}
+
+// ----------------------------------------------------------------------------
+
 ScriptValue
 ScriptObject::call(
    const std::string&           theName,
@@ -117,7 +151,7 @@ ScriptObject::call(
       ScriptObject* newObject = new ScriptObject(ScriptObject::ObjectE);
       ScriptValue result(newObject);
       newObject->putProperty(
-         PrototypeC,
+         PrototypeAtomC,
          ScriptValue(obj),
          ScriptProperty::DontEnumE | 
          ScriptProperty::DontDeleteE | 
@@ -152,11 +186,11 @@ ScriptObject::deleteProperty(
    const std::string& theName)
 {
    // ECMA-262 8.6.2.5
-   ScriptProperty* property = getPropertyObject(theName);
-   if (property != 0)
+   int slot = shapeM->getSlot(theName);
+   if (slot >= 0)
    {
       // Property exists
-      if (property->dontDelete() == true)
+      if (slotsM[slot].dontDelete() == true)
       {
          // Property must not be deleted
          return false;
@@ -164,7 +198,7 @@ ScriptObject::deleteProperty(
       else
       {
          // Property may be be deleted
-         propertiesM.erase(theName);
+         removeProperty(slot);
          return true;
       }
    }
@@ -178,11 +212,11 @@ ScriptObject::deletePropertyNoCheck(
    const std::string& theName)
 {
    // ECMA-262 8.6.2.5
-   ScriptProperty* property = getPropertyObject(theName);
-   if (property != 0)
+   int slot = shapeM->getSlot(theName);
+   if (slot >= 0)
    {
       // Property may be be deleted, ignore possible "don't delete" property.
-      propertiesM.erase(theName);
+      removeProperty(slot);
       return true;
    }
    return false;
@@ -193,18 +227,19 @@ ScriptObject::deletePropertyNoCheck(
 void
 ScriptObject::flushAllProperties()
 {
-   Properties::iterator next;
-   for (Properties::iterator iter = propertiesM.begin();
-        iter != propertiesM.end();
-        iter = next)
+   // Detach the properties first, so that cyclic references end here
+   Slots slots;
+   slots.swap(slotsM);
+   shapeM->release();
+   shapeM = ScriptShape::getEmptyShape();
+   for (Slots::iterator iter = slots.begin();
+        iter != slots.end();
+        iter++)
    {
-      next = iter;
-      next++;
-      if ((*iter).second.getValue().getDataType() == ScriptValue::ObjectE)
+      if ((*iter).getValue().getDataType() == ScriptValue::ObjectE)
       {
-         (*iter).second.getValue().toObject()->flushAllProperties();
+         (*iter).getValue().toObject()->flushAllProperties();
       }
-      propertiesM.erase(iter);
    }
 }
 
@@ -231,13 +266,11 @@ bool
 ScriptObject::getNameOfFirstProperty(
    std::string& theName) const
 {
-   for (Properties::const_iterator iter = propertiesM.begin();
-        iter != propertiesM.end();
-        iter++)
+   for (int i = 0; i < (int)slotsM.size(); i++)
    {
-      if ((*iter).second.dontEnum() == false)
+      if (slotsM[i].dontEnum() == false)
       {
-         theName = (*iter).first;
+         theName = shapeM->getName(i);
          return true;
       }
    }
@@ -250,26 +283,48 @@ bool
 ScriptObject::getNameOfNextProperty(
    std::string& theName) const
 {
-   Properties::const_iterator iter = propertiesM.upper_bound(theName);
-   while (iter != propertiesM.end())
+   // The properties are enumerated in the order of their creation
+   int slot = shapeM->getSlot(theName);
+   if (slot < 0)
    {
-      if ((*iter).second.dontEnum() == false)
+      return false;
+   }
+   for (int i = slot + 1; i < (int)slotsM.size(); i++)
+   {
+      if (slotsM[i].dontEnum() == false)
       {
-         theName = (*iter).first;
+         theName = shapeM->getName(i);
          return true;
       }
-      iter++;
    }
    return false;  
 }
 
 // ----------------------------------------------------------------------------
 
+void
+ScriptObject::getNamesOfProperties(
+   std::vector<std::string>& theNames) const
+{
+   std::string propertyName;
+   if (getNameOfFirstProperty(propertyName) == false)
+   {
+      return;
+   }
+   do
+   {
+      theNames.push_back(propertyName);
+   }
+   while (getNameOfNextProperty(propertyName) == true);
+}
+
+// ----------------------------------------------------------------------------
+
 Number
 ScriptObject::getNumberValue() const
 {
    // See ECMA-262 9.3
-   return propertiesM.size();
+   return slotsM.size();
 }
 
 // ----------------------------------------------------------------------------
@@ -306,16 +361,41 @@ ScriptObject::getProperty(
 
 // ----------------------------------------------------------------------------
 
+ScriptValue
+ScriptObject::getProperty(
+   const ScriptAtom& theName) const
+{
+   if (hasStandardPropertyAccess() == false)
+   {
+      return getProperty(theName.getName());
+   }
+   // ECMA-262 8.6.2.1
+   const ScriptProperty* property = getPropertyObject(theName);
+   if (property != 0)
+   {
+      // Property exists
+      return property->getValue();   
+   }
+   // Property does not exist - check if it exists in prototype
+   const ScriptObject* prototype = getPrototypeObject();
+   if (prototype == 0)
+   {
+      // No prototype
+      return ScriptValue(ScriptValue::UndefinedE);
+   } 
+   // Check if the value exists in the prototype
+   return prototype->getProperty(theName);
+}
+
+// ----------------------------------------------------------------------------
+
 void
 ScriptObject::getPropertyNames(
    std::vector<std::string>& theNames) const
 {
-   for (Properties::const_iterator iter = propertiesM.begin();
-        iter != propertiesM.end();
-        iter++)
+   for (int i = 0; i < shapeM->getSize(); i++)
    {
-      std::string name = (*iter).first;
-      theNames.push_back(name);
+      theNames.push_back(shapeM->getName(i));
    }
 }
 
@@ -402,6 +482,35 @@ ScriptObject::hasProperty(
 
 // ----------------------------------------------------------------------------
 
+bool
+ScriptObject::hasProperty(
+   const ScriptAtom& theName) const
+{
+   if (hasStandardPropertyAccess() == false)
+   {
+      return hasProperty(theName.getName());
+   }
+   // ECMA-262 8.6.2.4
+   const ScriptProperty* property = getPropertyObject(theName);
+   if (property != 0)
+   {
+      // Property exists
+      return true;   
+   }
+
+   // Property does not exist - check if it exists in prototype
+   const ScriptObject* prototype = getPrototypeObject();
+   if (prototype == 0)
+   {
+      // No prototype
+      return false;
+   } 
+   // Check if the value exists in the prototype
+   return prototype->hasProperty(theName);
+}
+
+// ----------------------------------------------------------------------------
+
 bool
 ScriptObject::isInstanceOf(
    const std::string& theClassName) const
@@ -416,49 +525,62 @@ ScriptObject::print(
    std::string&       theOutputString,
    const std::string& theLinePrefix) const
 {
-   for (Properties::const_iterator iter = propertiesM.begin();
-        iter != propertiesM.end();
-        iter++)
+   for (int i = 0; i < (int)slotsM.size(); i++)
    {
-      if ((*iter).second.dontEnum() == true)
+      if (slotsM[i].dontEnum() == true)
       {
          continue;
       }
-      if (iter != propertiesM.begin())
+      if (i != 0)
       {
          theOutputString += ";\n";
       }
-      theOutputString += theLinePrefix;
-      theOutputString += "\"";
-      theOutputString += (*iter).first;
-      theOutputString += "\" = ";
-      ScriptValue value = (*iter).second.getValue();
-      switch (value.getDataType())
+      printProperty(theOutputString, 
+                    theLinePrefix, 
+                    shapeM->getName(i), 
+                    slotsM[i].getValue());
+   }
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptObject::printProperty(
+   std::string&       theOutputString,
+   const std::string& theLinePrefix,
+   const std::string& theName,
+   const ScriptValue& theValue)
+{
+   theOutputString += theLinePrefix;
+   theOutputString += "\"";
+   theOutputString += theName;
+   theOutputString += "\" = ";
+   ScriptValue value = theValue;
+   switch (value.getDataType())
+   {
+      case ScriptValue::ObjectE:
       {
-         case ScriptValue::ObjectE:
-         {
-            theOutputString += "\n";
-            theOutputString += theLinePrefix;
-            theOutputString += "{\n";
-//            theOutputString += theLinePrefix;
-            value.toObject()->print(theOutputString, theLinePrefix + "   ");
-            theOutputString += "\n";
-            theOutputString += theLinePrefix;
-            theOutputString += "}";
-            break;
-         }
-         case ScriptValue::StringE:
-         {
-            theOutputString += "\"";
-            theOutputString += value.toString();
-            theOutputString += "\"";
-            break;
-         }
-         default:
-         {
-            theOutputString += value.toString();
-            break;
-         }
+         theOutputString += "\n";
+         theOutputString += theLinePrefix;
+         theOutputString += "{\n";
+//         theOutputString += theLinePrefix;
+         value.toObject()->print(theOutputString, theLinePrefix + "   ");
+         theOutputString += "\n";
+         theOutputString += theLinePrefix;
+         theOutputString += "}";
+         break;
+      }
+      case ScriptValue::StringE:
+      {
+         theOutputString += "\"";
+         theOutputString += value.toString();
+         theOutputString += "\"";
+         break;
+      }
+      default:
+      {
+         theOutputString += value.toString();
+         break;
       }
    }
 }
@@ -469,6 +591,78 @@ bool
 ScriptObject::putProperty(
    const std::string&      theName,
    const ScriptValue& theValue)
+{
+   return putStandardProperty(theName, theValue);
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptObject::putProperty(
+   const ScriptAtom&  theName,
+   const ScriptValue& theValue)
+{
+   if (hasStandardPropertyAccess() == false)
+   {
+      return putProperty(theName.getName(), theValue);
+   }
+   return putStandardProperty(theName, theValue);
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptObject::putProperty(
+   const std::string&      theName,
+   const ScriptValue& theValue,
+   unsigned int       theAttributes)
+{
+   // ECMA-262 8.6.2.2
+   ScriptProperty* property = getPropertyObject(theName);
+   if (property != 0)
+   {
+      // Property exists
+      property->putValue(theValue, theAttributes);
+      return;
+   }
+
+   // Create property
+   addProperty(theName, ScriptProperty(theValue, theAttributes));
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptObject::putProperty(
+   const ScriptAtom&  theName,
+   const ScriptValue& theValue,
+   unsigned int       theAttributes)
+{
+   if (hasStandardPropertyAccess() == false)
+   {
+      putProperty(theName.getName(), theValue, theAttributes);
+      return;
+   }
+   // ECMA-262 8.6.2.2
+   ScriptProperty* property = getPropertyObject(theName);
+   if (property != 0)
+   {
+      // Property exists
+      property->putValue(theValue, theAttributes);
+      return;
+   }
+
+   // Create property
+   addProperty(theName, ScriptProperty(theValue, theAttributes));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class Name>
+bool
+ScriptObject::putStandardProperty(
+   const Name&        theName,
+   const ScriptValue& theValue)
 {
    // ECMA-262 8.6.2.2
    ScriptProperty* property = getPropertyObject(theName);
@@ -505,35 +699,12 @@ ScriptObject::putProperty(
    } 
 
    // Create property
-   propertiesM.insert(Properties::value_type(theName, 
-                                             ScriptProperty(theValue)));
+   addProperty(theName, ScriptProperty(theValue));
    return true;
 }
 
 // ----------------------------------------------------------------------------
 
-void
-ScriptObject::putProperty(
-   const std::string&      theName,
-   const ScriptValue& theValue,
-   unsigned int       theAttributes)
-{
-   // ECMA-262 8.6.2.2
-   ScriptProperty* property = getPropertyObject(theName);
-   if (property != 0)
-   {
-      // Property exists
-      property->putValue(theValue, theAttributes);
-   }
-
-   // Create property
-   propertiesM.insert(Properties::value_type(theName, 
-                                             ScriptProperty(theValue, 
-                                                            theAttributes)));
-}
-
-// ----------------------------------------------------------------------------
-
 void
 ScriptObject::read(
    const char*& theCurrentChar, 
@@ -770,9 +941,25 @@ ScriptObject::readPropertyValue(
 
 // ----------------------------------------------------------------------------
 
+void
+ScriptObject::removeProperty(
+   int theSlot)
+{
+   ScriptShape* shape = shapeM->removeProperty(theSlot);
+   if (shape != shapeM)
+   {
+      shapeM->release();
+      shapeM = shape;
+   }
+   slotsM.erase(slotsM.begin() + theSlot);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class Name>
 ScriptObject::UpdateResult
 ScriptObject::updateProperty(
-   const std::string& theName,
+   const Name&   theName,
    ScriptValue   theValue)
 {
    ScriptProperty* property = getPropertyObject(theName);
@@ -809,15 +996,30 @@ ScriptObject::putPropertyNoCheck(
    const ScriptValue& theValue,
    unsigned int       theAttributes)
 {
-   std::pair<Properties::iterator, bool> result =
-      propertiesM.insert(Properties::value_type(theName, 
-                                                ScriptProperty(theValue, 
-                                                               theAttributes)));
-   if (result.second == false)
+   ScriptProperty* property = getPropertyObject(theName);
+   if (property != 0)
+   {
+      *property = ScriptProperty(theValue, theAttributes);
+      return;
+   }
+   addProperty(theName, ScriptProperty(theValue, theAttributes));
+}
+        
+// ----------------------------------------------------------------------------
+
+void
+ScriptObject::putPropertyNoCheck(
+   const ScriptAtom&  theName,
+   const ScriptValue& theValue,
+   unsigned int       theAttributes)
+{
+   ScriptProperty* property = getPropertyObject(theName);
+   if (property != 0)
    {
-      (*result.first).second = ScriptProperty(theValue, 
-                                              theAttributes);
+      *property = ScriptProperty(theValue, theAttributes);
+      return;
    }
+   addProperty(theName, ScriptProperty(theValue, theAttributes));
 }
         
 // ----------------------------------------------------------------------------
@@ -827,13 +1029,29 @@ ScriptObject::putPropertyNoCheck(
    const std::string&      theName,
    const ScriptValue& theValue)
 {
-   std::pair<Properties::iterator, bool> result =
-      propertiesM.insert(Properties::value_type(theName, 
-                                                ScriptProperty(theValue)));
-   if (result.second == false)
+   ScriptProperty* property = getPropertyObject(theName);
+   if (property != 0)
+   {
+      *property = theValue;
+      return;
+   }
+   addProperty(theName, ScriptProperty(theValue));
+}
+        
+// ----------------------------------------------------------------------------
+
+void
+ScriptObject::putPropertyNoCheck(
+   const ScriptAtom&  theName,
+   const ScriptValue& theValue)
+{
+   ScriptProperty* property = getPropertyObject(theName);
+   if (property != 0)
    {
-      (*result.first).second = theValue;
+      *property = theValue;
+      return;
    }
+   addProperty(theName, ScriptProperty(theValue));
 }
 
 // -------------------------------------------------------------------------
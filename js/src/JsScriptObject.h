@@ -3,10 +3,11 @@
 
 #include "JsScriptDefinitions.h"
 #include "JsScriptProperty.h"
+#include "JsScriptShape.h"
 #include "JsScriptValue.h"
 #include "JsScriptValueArray.h"
 #include "JsSmartPointer.h"
-#include <map>
+#include <vector>
 
 namespace Js
 {
@@ -158,6 +159,9 @@ namespace Js
        *                contains the name of the first enumeratable
        *                property.
        *                Otherwise this parameter is unchanged.
+       *                The property must still exist, use
+       *                getNamesOfProperties() if properties may be
+       *                deleted during the enumeration.
        * @return 'true'   if a property that can be enumerated exist
        *                  after the specified property.
        *         'false', otherwise.
@@ -167,6 +171,15 @@ namespace Js
       getNameOfNextProperty(
          std::string& theName) const; 
 
+      /**
+       * Get the names of all properties that can be enumerated, in the
+       * order of the enumeration.
+       * @param theNames The names are appended to this vector.
+       */
+      void
+      getNamesOfProperties(
+         std::vector<std::string>& theNames) const;
+
       /**
        * Convert the value to a value of type Number.
        * @return the number value.
@@ -179,6 +192,27 @@ namespace Js
       ObjectType
       getObjectType() const;
 
+      /**
+       * Get the shape of the object, which maps the names of the own
+       * properties to their slots.
+       */
+      const ScriptShape*
+      getShape() const;
+
+      /**
+       * Get the property in the specified slot.
+       */
+      ScriptProperty&
+      getSlot(
+         int theSlot);
+
+      /**
+       * Get the property in the specified slot.
+       */
+      const ScriptProperty&
+      getSlot(
+         int theSlot) const;
+
       /**
        * Get the value of the specified property.
        */
@@ -187,9 +221,18 @@ namespace Js
       getProperty(
          const std::string& theName) const;
 
+      /**
+       * Get the value of the specified property.
+       * Objects with their own way to get properties are asked by name.
+       */
+      ScriptValue
+      getProperty(
+         const ScriptAtom& theName) const;
+
       /**
        * Get the names of all properties.
        */
+      virtual
       void
       getPropertyNames(
          std::vector<std::string>& theNames) const;
@@ -210,6 +253,21 @@ namespace Js
       hasProperty(
          const std::string& theName) const;
 
+      /**
+       * Check if the object has the specified property.
+       */
+      bool
+      hasProperty(
+         const ScriptAtom& theName) const;
+
+      /**
+       * Check if the properties are found in the slots of the object and
+       * its prototypes, which is not the case for arrays and external
+       * objects.
+       */
+      bool
+      hasStandardPropertyAccess() const;
+
       /**
        * Check if this object is derived from the class 'theClassName'.
        * @param theClassName (in) The name of the class.
@@ -229,6 +287,7 @@ namespace Js
        *                        each line of the description except of
        *                        the first one.
        */
+      virtual
       void
       print(
          std::string&       theOutputString,
@@ -243,6 +302,14 @@ namespace Js
          const std::string&      theName,
          const ScriptValue& theValue);
 
+      /**
+       * Put the specified property.
+       */
+      bool
+      putProperty(
+         const ScriptAtom&  theName,
+         const ScriptValue& theValue);
+
       /**
        * Put the specified property.
        */
@@ -253,17 +320,37 @@ namespace Js
          const ScriptValue& theValue,
          unsigned int       theAttributes);
 
+      /**
+       * Put the specified property.
+       */
+      void
+      putProperty(
+         const ScriptAtom&  theName,
+         const ScriptValue& theValue,
+         unsigned int       theAttributes);
+
       void
       putPropertyNoCheck(
          const std::string&      theName,
          const ScriptValue& theValue);
 
+      void
+      putPropertyNoCheck(
+         const ScriptAtom&  theName,
+         const ScriptValue& theValue);
+
       void
       putPropertyNoCheck(
          const std::string&      theName,
          const ScriptValue& theValue,
          unsigned int       theAttributes);
 
+      void
+      putPropertyNoCheck(
+         const ScriptAtom&  theName,
+         const ScriptValue& theValue,
+         unsigned int       theAttributes);
+
       /**
        * Read object from the specified C-string.
        */
@@ -283,6 +370,23 @@ namespace Js
 
    protected:
 
+      /**
+       * Add a property that does not exist yet behind the other properties.
+       */
+      void
+      addProperty(
+         const ScriptAtom&     theName,
+         const ScriptProperty& theProperty);
+
+      /**
+       * Add a property that does not exist yet behind the other properties.
+       * The name is not interned, it is found by name only.
+       */
+      void
+      addProperty(
+         const std::string&    theName,
+         const ScriptProperty& theProperty);
+
       ScriptProperty*
       getPropertyObject(
          const std::string& theName);
@@ -291,29 +395,83 @@ namespace Js
       getPropertyObject(
          const std::string& theName) const;
 
+      ScriptProperty*
+      getPropertyObject(
+         const ScriptAtom& theName);
+
+      const ScriptProperty*
+      getPropertyObject(
+         const ScriptAtom& theName) const;
+
       ScriptObject*
       getPrototypeObject();
 
       const ScriptObject*
       getPrototypeObject() const;
 
+      /**
+       * Print a single property as part of the description of an object.
+       */
+      static
+      void
+      printProperty(
+         std::string&       theOutputString,
+         const std::string& theLinePrefix,
+         const std::string& theName,
+         const ScriptValue& theValue);
+
       std::string 
       readPropertyName(
          const char*& theCurrentChar, 
          int&         theLine, 
          int&         theColumn);
 
+      /**
+       * Remove the property in the specified slot.
+       */
+      void
+      removeProperty(
+         int theSlot);
+
+      /**
+       * Update the property of the object or of its prototypes.
+       * @param theName The name or the atom of the name.
+       */
+      template <class Name>
       UpdateResult
       updateProperty(
-         const std::string& theName,
+         const Name&   theName,
          ScriptValue   theValue);
 
-      typedef std::map<std::string, ScriptProperty> Properties;
+      typedef std::vector<ScriptProperty> Slots;
 
       ObjectType          objectTypeM;
-      Properties          propertiesM;      
+      ScriptShape*        shapeM;       // maps the property names to slots
+      Slots               slotsM;
 
       static const std::string PrototypeC;
+
+   private:
+
+      /**
+       * Put a property into the slots of the object, or of the prototype
+       * that already has it.
+       * @param theName The name or the atom of the name.
+       */
+      template <class Name>
+      bool
+      putStandardProperty(
+         const Name&        theName,
+         const ScriptValue& theValue);
+
+      // Not implemented
+      ScriptObject(
+         const ScriptObject& theOther);
+
+      // Not implemented
+      ScriptObject&
+      operator=(
+         const ScriptObject& theOther);
    };
 
    typedef SmartPointer<ScriptObject> ScriptObjectPtr;
@@ -325,11 +483,11 @@ namespace Js
    ScriptObject::getPropertyObject(
       const std::string& theName)
    {
-      Properties::iterator iter1 = propertiesM.find(theName);
-      if (iter1 != propertiesM.end())
+      int slot = shapeM->getSlot(theName);
+      if (slot >= 0)
       {
          // Property exists
-         return &((*iter1).second);
+         return &slotsM[slot];
       }
       return 0;
    }
@@ -341,26 +499,96 @@ namespace Js
    ScriptObject::getPropertyObject(
       const std::string& theName) const
    {
-      Properties::const_iterator iter1 = propertiesM.find(theName);
-      if (iter1 != propertiesM.end())
+      int slot = shapeM->getSlot(theName);
+      if (slot >= 0)
+      {
+         // Property exists
+         return &slotsM[slot];
+      }
+      return 0;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptProperty*
+   ScriptObject::getPropertyObject(
+      const ScriptAtom& theName)
+   {
+      int slot = shapeM->getSlot(theName);
+      if (slot >= 0)
       {
          // Property exists
-         return &((*iter1).second);
+         return &slotsM[slot];
+      }
+      return 0;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   const ScriptProperty*
+   ScriptObject::getPropertyObject(
+      const ScriptAtom& theName) const
+   {
+      int slot = shapeM->getSlot(theName);
+      if (slot >= 0)
+      {
+         // Property exists
+         return &slotsM[slot];
       }
       return 0;
    }
    
    // -------------------------------------------------------------------------
 
+   inline
+   bool
+   ScriptObject::hasStandardPropertyAccess() const
+   {
+      return objectTypeM != ArrayE && objectTypeM != ExternalE;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   const ScriptShape*
+   ScriptObject::getShape() const
+   {
+      return shapeM;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptProperty&
+   ScriptObject::getSlot(
+      int theSlot)
+   {
+      return slotsM[theSlot];
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   const ScriptProperty&
+   ScriptObject::getSlot(
+      int theSlot) const
+   {
+      return slotsM[theSlot];
+   }
+
+   // -------------------------------------------------------------------------
+
    inline
    ScriptObject*
    ScriptObject::getPrototypeObject()
    {
-      Properties::iterator iter1 = propertiesM.find(PrototypeC);
-      if (iter1 != propertiesM.end())
+      int slot = shapeM->getPrototypeSlot();
+      if (slot >= 0)
       {
          // Property exists
-         return (*iter1).second.getValue().toObject();
+         return slotsM[slot].getValue().toObject();
       }
       return 0;
    }
@@ -371,11 +599,11 @@ namespace Js
    const ScriptObject*
    ScriptObject::getPrototypeObject() const 
    {
-      Properties::const_iterator iter1 = propertiesM.find(PrototypeC);
-      if (iter1 != propertiesM.end())
+      int slot = shapeM->getPrototypeSlot();
+      if (slot >= 0)
       {
          // Property exists
-         return (*iter1).second.getValue().toObject();
+         return slotsM[slot].getValue().toObject();
       }
       return 0;
    }
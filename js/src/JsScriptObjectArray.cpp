@@ -1,6 +1,9 @@
 #include "JsScannerUtilities.h"
 #include "JsScriptObjectArray.h"
 #include "JsScriptTypeError.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
 
 using namespace Js;
 
@@ -103,14 +106,7 @@ ScriptObjectArray::call(
       }
       for (int i = 0; i < theArguments.size(); i++)
       {
-         std::string index;
-         {
-         char buf[10] = {0};
-         snprintf(buf, 9, "%d", lengthM++);
-         //index.appendNumber(lengthM++);
-         index.append(buf);
-         }
-         ScriptObject::putPropertyNoCheck(index, theArguments[i]);
+         putElement(lengthM, theArguments[i]);
       }
       return ScriptValue::UndefinedC;
    }
@@ -127,16 +123,16 @@ ScriptObjectArray::call(
       {
          return ScriptValue::UndefinedC;
       }
-      std::string index;
+      lengthM--;
+      ScriptValue result = getElement(lengthM);
+      if (lengthM < (int)elementsM.size())
       {
-         char buf[10] = {0};
-         snprintf(buf, 10, "%d", lengthM -1); 
-         //index.appendNumber(lengthM - 1);
-         index.append(buf);
+         elementsM.pop_back();
+      }
+      else
+      {
+         ScriptObject::deleteProperty(getIndexName(lengthM));
       }
-      ScriptValue result = ScriptObject::getProperty(index);
-      ScriptObject::deleteProperty(index);
-      lengthM--;
       return result;      
    }
    else
@@ -150,6 +146,88 @@ ScriptObjectArray::call(
 
 // ----------------------------------------------------------------------------
 
+bool
+ScriptObjectArray::deleteElement(
+   int theIndex)
+{
+   if (theIndex == (int)elementsM.size() - 1)
+   {
+      elementsM.pop_back();
+      return true;
+   }
+   // The elements behind the new hole are no longer dense
+   for (int i = theIndex + 1; i < (int)elementsM.size(); i++)
+   {
+      ScriptObject::putPropertyNoCheck(getIndexName(i), elementsM[i]);
+   }
+   elementsM.resize(theIndex);
+   return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptObjectArray::deleteProperty(
+   const std::string& theName)
+{
+   int index;
+   if (isIndexName(theName, index) == true && 
+       index < (int)elementsM.size())
+   {
+      return deleteElement(index);
+   }
+   return ScriptObject::deleteProperty(theName);
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptObjectArray::deletePropertyNoCheck(
+   const std::string& theName)
+{
+   int index;
+   if (isIndexName(theName, index) == true && 
+       index < (int)elementsM.size())
+   {
+      return deleteElement(index);
+   }
+   return ScriptObject::deletePropertyNoCheck(theName);
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptObjectArray::fillElements()
+{
+   int slot = shapeM->getSlot(getIndexName(elementsM.size()));
+   while (slot >= 0)
+   {
+      elementsM.push_back(slotsM[slot].getValue());
+      removeProperty(slot);
+      slot = shapeM->getSlot(getIndexName(elementsM.size()));
+   }
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptObjectArray::flushAllProperties()
+{
+   for (Elements::iterator iter = elementsM.begin();
+        iter != elementsM.end();
+        iter++)
+   {
+      if ((*iter).getDataType() == ScriptValue::ObjectE)
+      {
+         (*iter).toObject()->flushAllProperties();
+      }
+   }
+   elementsM.clear();
+   ScriptObject::flushAllProperties();
+}
+
+// ----------------------------------------------------------------------------
+
 const char*
 ScriptObjectArray::getClass() const
 {
@@ -158,6 +236,60 @@ ScriptObjectArray::getClass() const
 
 // ----------------------------------------------------------------------------
 
+std::string
+ScriptObjectArray::getIndexName(
+   int theIndex)
+{
+   char buf[12];
+   snprintf(buf, sizeof(buf), "%d", theIndex);
+   return std::string(buf);
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptObjectArray::getNameOfFirstProperty(
+   std::string& theName) const
+{
+   if (elementsM.empty() == false)
+   {
+      theName = "0";
+      return true;
+   }
+   return ScriptObject::getNameOfFirstProperty(theName);
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptObjectArray::getNameOfNextProperty(
+   std::string& theName) const
+{
+   int index;
+   if (isIndexName(theName, index) == true && 
+       index < (int)elementsM.size())
+   {
+      if (index + 1 < (int)elementsM.size())
+      {
+         theName = getIndexName(index + 1);
+         return true;
+      }
+      // Continue with the properties behind the last element
+      return ScriptObject::getNameOfFirstProperty(theName);
+   }
+   return ScriptObject::getNameOfNextProperty(theName);
+}
+
+// ----------------------------------------------------------------------------
+
+Number
+ScriptObjectArray::getNumberValue() const
+{
+   return elementsM.size() + slotsM.size();
+}
+
+// ----------------------------------------------------------------------------
+
 ScriptValue
 ScriptObjectArray::getProperty(
    const std::string& thePropertyName) const
@@ -166,6 +298,11 @@ ScriptObjectArray::getProperty(
    {
       return ScriptValue((Number)lengthM);
    }
+   int index;
+   if (isIndexName(thePropertyName, index) == true)
+   {
+      return getElement(index);
+   }
    return ScriptObject::getProperty(thePropertyName);
 }
 
@@ -175,12 +312,24 @@ ScriptValue
 ScriptObjectArray::getProperty(
    Number theIndex) const
 {
-   std::string propertyName;
-   char buf[10] = {0};
-   snprintf(buf, 10, "%d", theIndex);
-   //propertyName.appendNumber(theIndex);
-   propertyName.append(buf);
-   return ScriptObject::getProperty(propertyName);
+   if (theIndex >= 0 && theIndex < INT_MAX && theIndex == (int)theIndex)
+   {
+      return getElement((int)theIndex);
+   }
+   return getProperty(ScriptValue(theIndex).toString());
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptObjectArray::getPropertyNames(
+   std::vector<std::string>& theNames) const
+{
+   for (int i = 0; i < (int)elementsM.size(); i++)
+   {
+      theNames.push_back(getIndexName(i));
+   }
+   ScriptObject::getPropertyNames(theNames);
 }
 
 // ----------------------------------------------------------------------------
@@ -191,7 +340,7 @@ ScriptObjectArray::getStringValue() const
    ScriptString* result = new ScriptString;
    for (int i = 0; i < lengthM; i++)
    {
-      result->append(getProperty(i).toString());
+      result->append(getElement(i).toString());
       if (i < lengthM - 1)
       {
          result->append(",");
@@ -202,6 +351,52 @@ ScriptObjectArray::getStringValue() const
 
 // ----------------------------------------------------------------------------
 
+bool
+ScriptObjectArray::hasProperty(
+   const std::string& theName) const
+{
+   int index;
+   if (isIndexName(theName, index) == true && 
+       index < (int)elementsM.size())
+   {
+      return true;
+   }
+   return ScriptObject::hasProperty(theName);
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptObjectArray::isIndexName(
+   const std::string& theName,
+   int&               theIndex)
+{
+   // Only "0" and digit strings without a leading zero name an index
+   const char* currentChar = theName.c_str();
+   if (*currentChar < '0' || *currentChar > '9' ||
+       (*currentChar == '0' && currentChar[1] != 0))
+   {
+      return false;
+   }
+   long long index = 0;
+   for (; *currentChar != 0; currentChar++)
+   {
+      if (*currentChar < '0' || *currentChar > '9')
+      {
+         return false;
+      }
+      index = index * 10 + (*currentChar - '0');
+      if (index >= INT_MAX)
+      {
+         return false;
+      }
+   }
+   theIndex = (int)index;
+   return true;
+}
+
+// ----------------------------------------------------------------------------
+
 bool
 ScriptObjectArray::isInstanceOf(
    const std::string& theClassName) const
@@ -215,6 +410,36 @@ ScriptObjectArray::isInstanceOf(
 
 // ----------------------------------------------------------------------------
 
+void
+ScriptObjectArray::print(
+   std::string&       theOutputString,
+   const std::string& theLinePrefix) const
+{
+   for (int i = 0; i < (int)elementsM.size(); i++)
+   {
+      if (i > 0)
+      {
+         theOutputString += ";\n";
+      }
+      printProperty(theOutputString, 
+                    theLinePrefix, 
+                    getIndexName(i), 
+                    elementsM[i]);
+   }
+   std::string properties;
+   ScriptObject::print(properties, theLinePrefix);
+   if (properties.empty() == false)
+   {
+      if (elementsM.empty() == false)
+      {
+         theOutputString += ";\n";
+      }
+      theOutputString += properties;
+   }
+}
+
+// ----------------------------------------------------------------------------
+
 bool
 ScriptObjectArray::putProperty(
    const std::string&      thePropertyName,
@@ -224,27 +449,33 @@ ScriptObjectArray::putProperty(
    {
       ScriptValue numberValue(theValue);
       Number newLength = numberValue.toNumber();
+      if (newLength < elementsM.size())
+      {
+         elementsM.resize(newLength > 0 ? (size_t)ceil(newLength) : 0);
+      }
       if (newLength < lengthM)
       {
-         Properties::iterator next;
-         for (Properties::iterator iter = propertiesM.begin();
-              iter != propertiesM.end();
-              iter = next)
+         for (int slot = shapeM->getSize() - 1; slot >= 0; slot--)
          {
-            ScriptValue index = (*iter).first;
+            ScriptValue index = shapeM->getName(slot);
             
-            next = iter;
-            next++;
             if (index.toNumber() != NaNC &&
                 index.toNumber() >= newLength)
             {
-               propertiesM.erase(iter);
+               removeProperty(slot);
             }
          }
       }
       lengthM = newLength >= 0 ? newLength : 0;
       return true;
    }
+
+   int index;
+   if (isIndexName(thePropertyName, index) == true)
+   {
+      putElement(index, theValue);
+      return true;
+   }
    
    const char* currentChar = thePropertyName.c_str();
    ScannerUtilities::skipStringWhiteSpace(currentChar);
@@ -290,16 +521,8 @@ ScriptObjectArray::putProperty(
    int                theIndex,
    const ScriptValue& theValue)
 {
-   string propertyName;
-   char buf[10] = {0};
-   snprintf(buf, 10, "%d", theIndex);
-   //propertyName.appendNumber(theIndex);
-   propertyName.append(buf);
-   if (theIndex >= lengthM)
-   {
-      lengthM = theIndex + 1;
-   }
-   return ScriptObject::putProperty(propertyName, theValue);
+   putElement(theIndex, theValue);
+   return true;
 }
 
 // ----------------------------------------------------------------------------
@@ -4,12 +4,16 @@
 #include "JsScriptObject.h"
 #include "JsScriptExecutionContext.h"
 #include "JsScriptValueArray.h"
+#include <vector>
 
 namespace Js
 {
   /** \class ScriptObjectArray ScriptObjectArray.h "ScriptObjectArray.h"
    * \ingroup PALSCRIPT
    * Array object
+   * The elements 0 .. n-1 without holes are kept in a vector; elements
+   * behind the first hole and all other properties are kept by name as in
+   * every other object.
    */
    class ScriptObjectArray : public ScriptObject
    {
@@ -52,6 +56,26 @@ namespace Js
          const ScriptValueArray& theArguments,
          bool                    theIsConstructor);
 
+      /**
+       * Remove the specified property from the array.
+       */
+      bool
+      deleteProperty(
+         const std::string& theName);
+
+      /**
+       * Remove the specified property from the array unconditionally.
+       */
+      bool
+      deletePropertyNoCheck(
+         const std::string& theName);
+
+      /**
+       * Flush all elements and properties.
+       */
+      void
+      flushAllProperties();
+
       /**
        * Get the name of this class.
        * @return The name of this class.
@@ -59,6 +83,14 @@ namespace Js
       const char*
       getClass() const;
 
+      /**
+       * Get the value of the element with the specified index.
+       * @param theIndex The index of the element, must not be negative.
+       */
+      ScriptValue
+      getElement(
+         int theIndex) const;
+
       /**
        * Get the length of the array.
        * @return The length of the array.
@@ -66,6 +98,29 @@ namespace Js
       int
       getLength() const;
 
+      /**
+       * Get the name of the first property that can be enumerated.
+       * The elements are enumerated in the order of their indexes before
+       * all other properties.
+       */
+      bool
+      getNameOfFirstProperty(
+         std::string& theName) const;
+
+      /**
+       * Get the name of the next property that can be enumerated.
+       */
+      bool
+      getNameOfNextProperty(
+         std::string& theName) const;
+
+      /**
+       * Convert the value to a value of type Number.
+       * @return the number of properties.
+       */
+      Number
+      getNumberValue() const;
+
       /**
        * Get the specified property.
        */
@@ -80,6 +135,13 @@ namespace Js
       getProperty(
          Number theIndex) const;
 
+      /**
+       * Get the names of all properties.
+       */
+      void
+      getPropertyNames(
+         std::vector<std::string>& theNames) const;
+
       /**
        * Convert the value to a value of type String.
        * @return the string value.
@@ -87,6 +149,13 @@ namespace Js
       ScriptValue
       getStringValue() const;
 
+      /**
+       * Check if the array has the specified property.
+       */
+      bool
+      hasProperty(
+         const std::string& theName) const;
+
       /**
        * Check if this object is derived from the class 'theClassName'.
        * @param theClassName (in) The name of the class.
@@ -97,6 +166,24 @@ namespace Js
       isInstanceOf(
          const std::string& theClassName) const;
 
+      /**
+       * Print a human-readable description of the array to a string.
+       */
+      void
+      print(
+         std::string&       theOutputString,
+         const std::string& theLinePrefix = "") const;
+
+      /**
+       * Set the value of the element with the specified index.
+       * @param theIndex The index of the element, must not be negative.
+       * @param theValue The new value of the element.
+       */
+      void
+      putElement(
+         int                theIndex,
+         const ScriptValue& theValue);
+
       /**
        * Put the specified property.
        */
@@ -130,6 +217,44 @@ namespace Js
 
    private:
 
+      typedef std::vector<ScriptValue> Elements;
+
+      /**
+       * Remove the element with the specified index.
+       */
+      bool
+      deleteElement(
+         int theIndex);
+
+      /**
+       * Move the elements that follow the dense elements from the
+       * properties into the dense elements.
+       */
+      void
+      fillElements();
+
+      /**
+       * Convert an index into the name of its property.
+       */
+      static
+      std::string
+      getIndexName(
+         int theIndex);
+
+      /**
+       * Check if the name is the canonical name of an index.
+       * @param theName  The name of the property.
+       * @param theIndex If the method returns 'true' then this parameter
+       *                 contains the index.
+       * @return 'true'   if the name is the canonical name of an index,
+       *         'false', otherwise.
+       */
+      static
+      bool
+      isIndexName(
+         const std::string& theName,
+         int&               theIndex);
+
       // only included to avoid compiler warning
       virtual
       void
@@ -138,6 +263,7 @@ namespace Js
          const ScriptValue& theValue,
          unsigned int       theAttributes) {};
 
+      Elements            elementsM;
       int                 lengthM;
    };
 
@@ -146,6 +272,20 @@ namespace Js
 
    // ----------------------------------------------------------------------------
 
+   inline
+   ScriptValue
+   ScriptObjectArray::getElement(
+      int theIndex) const
+   {
+      if (theIndex < (int)elementsM.size())
+      {
+         return elementsM[theIndex];
+      }
+      return ScriptObject::getProperty(getIndexName(theIndex));
+   }
+
+   // ----------------------------------------------------------------------------
+
    inline
    int
    ScriptObjectArray::getLength() const
@@ -157,19 +297,42 @@ namespace Js
 
    inline
    void
-   ScriptObjectArray::putPropertyNoCheck(
+   ScriptObjectArray::putElement(
       int                theIndex,
       const ScriptValue& theValue)
    {
-      std::string propertyName;
-      char buf[10] = {0};
-      snprintf(buf, 9, "%d", theIndex); 
-      propertyName.append(buf);
       if (theIndex >= lengthM)
       {
          lengthM = theIndex + 1;
       }
-      ScriptObject::putPropertyNoCheck(propertyName, theValue);
+      if (theIndex < (int)elementsM.size())
+      {
+         elementsM[theIndex] = theValue;
+      }
+      else
+      if (theIndex == (int)elementsM.size())
+      {
+         elementsM.push_back(theValue);
+         if (slotsM.empty() == false)
+         {
+            fillElements();
+         }
+      }
+      else
+      {
+         ScriptObject::putPropertyNoCheck(getIndexName(theIndex), theValue);
+      }
+   }
+
+   // ----------------------------------------------------------------------------
+
+   inline
+   void
+   ScriptObjectArray::putPropertyNoCheck(
+      int                theIndex,
+      const ScriptValue& theValue)
+   {
+      putElement(theIndex, theValue);
    }
 }
 
@@ -2,7 +2,7 @@
 
 using namespace Js;
 
-static const string PrototypeC("prototype");
+static const ScriptAtom PrototypeC(ScriptAtom::intern("prototype"));
 
 ScriptObjectFunction::ScriptObjectFunction(
    ScriptNodeFunction* theFunction)
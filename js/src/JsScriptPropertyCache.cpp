@@ -0,0 +1,253 @@
+#include "JsScriptObject.h"
+#include "JsScriptPropertyCache.h"
+
+using namespace Js;
+
+// ----------------------------------------------------------------------------
+// CONSTRUCTORS AND DESTRUCTORS:
+// ----------------------------------------------------------------------------
+
+ScriptPropertyCache::ScriptPropertyCache()
+:  numberOfEntriesM(0),
+   nextEntryM(0),
+   numberOfRenamingsM(0)
+{
+   // Empty
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptValue
+ScriptPropertyCache::getProperty(
+   const ScriptObject* theObject,
+   const ScriptAtom&   theName)
+{
+   return getCachedProperty(theObject, theName);
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptValue
+ScriptPropertyCache::getProperty(
+   const ScriptObject* theObject,
+   const std::string&  theName)
+{
+   return getCachedProperty(theObject, theName);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class Name>
+ScriptValue
+ScriptPropertyCache::getCachedProperty(
+   const ScriptObject* theObject,
+   const Name&         theName)
+{
+   if (theObject->hasStandardPropertyAccess() == false || 
+       useName(theName) == false)
+   {
+      return theObject->getProperty(theName);
+   }
+
+   const ScriptShape* shape = theObject->getShape();
+   for (int i = 0; i < numberOfEntriesM; i++)
+   {
+      const Entry& entry = entriesM[i];
+      if (entry.shapesM[0] != shape)
+      {
+         continue;
+      }
+      // Follow the prototypes as long as they have the cached shapes
+      const ScriptObject* holder = theObject;
+      int depth = 0;
+      while (depth < entry.depthM)
+      {
+         const ScriptValue& prototype =
+            holder->getSlot(holder->getShape()->getPrototypeSlot()).getValue();
+         if (prototype.getDataType() != ScriptValue::ObjectE)
+         {
+            break;
+         }
+         holder = prototype.toObject();
+         depth++;
+         if (holder->getShape() != entry.shapesM[depth])
+         {
+            break;
+         }
+      }
+      if (depth == entry.depthM && holder->getShape() == entry.shapesM[depth])
+      {
+         return holder->getSlot(entry.slotM).getValue();
+      }
+   }
+
+   int slot;
+   const ScriptObject* holder = lookup(theObject, theName, slot);
+   if (holder != 0)
+   {
+      return holder->getSlot(slot).getValue();
+   }
+   return theObject->getProperty(theName);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class Name>
+const ScriptObject*
+ScriptPropertyCache::lookup(
+   const ScriptObject* theObject,
+   const Name&         theName,
+   int&                theSlot)
+{
+   Entry entry;
+   const ScriptObject* holder = theObject;
+   for (int depth = 0; depth <= MaxDepthC; depth++)
+   {
+      const ScriptShape* shape = holder->getShape();
+      if (holder->hasStandardPropertyAccess() == false || 
+          shape->isShared() == false)
+      {
+         return 0;
+      }
+      entry.shapesM[depth] = shape;
+      int slot = shape->getSlot(theName);
+      if (slot >= 0)
+      {
+         entry.depthM = depth;
+         entry.slotM = slot;
+         entriesM[nextEntryM] = entry;
+         nextEntryM = (nextEntryM + 1) % EntriesC;
+         if (numberOfEntriesM < EntriesC)
+         {
+            numberOfEntriesM++;
+         }
+         theSlot = slot;
+         return holder;
+      }
+      int prototypeSlot = shape->getPrototypeSlot();
+      if (prototypeSlot < 0)
+      {
+         // Missing properties are not cached
+         return 0;
+      }
+      const ScriptValue& prototype = holder->getSlot(prototypeSlot).getValue();
+      if (prototype.getDataType() != ScriptValue::ObjectE)
+      {
+         return 0;
+      }
+      holder = prototype.toObject();
+   }
+   return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptPropertyCache::putProperty(
+   ScriptObject*      theObject,
+   const ScriptAtom&  theName,
+   const ScriptValue& theValue)
+{
+   return putCachedProperty(theObject, theName, theValue);
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptPropertyCache::putProperty(
+   ScriptObject*      theObject,
+   const std::string& theName,
+   const ScriptValue& theValue)
+{
+   return putCachedProperty(theObject, theName, theValue);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class Name>
+bool
+ScriptPropertyCache::putCachedProperty(
+   ScriptObject*      theObject,
+   const Name&        theName,
+   const ScriptValue& theValue)
+{
+   if (theObject->hasStandardPropertyAccess() == false || 
+       useName(theName) == false)
+   {
+      return theObject->putProperty(theName, theValue);
+   }
+
+   // Only properties of the object itself are updated through the cache
+   const ScriptShape* shape = theObject->getShape();
+   for (int i = 0; i < numberOfEntriesM; i++)
+   {
+      if (entriesM[i].shapesM[0] == shape && entriesM[i].depthM == 0)
+      {
+         return theObject->getSlot(entriesM[i].slotM).putValue(theValue);
+      }
+   }
+
+   int slot;
+   if (shape->getSlot(theName) >= 0 &&
+       lookup(theObject, theName, slot) == theObject)
+   {
+      return theObject->getSlot(slot).putValue(theValue);
+   }
+   return theObject->putProperty(theName, theValue);
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptPropertyCache::rename()
+{
+   if (numberOfRenamingsM >= MaxRenamingsC)
+   {
+      // Megamorphic subscript, e.g. a loop over the properties
+      return false;
+   }
+   numberOfRenamingsM++;
+   numberOfEntriesM = 0;
+   nextEntryM = 0;
+   return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptPropertyCache::useName(
+   const ScriptAtom& theName)
+{
+   if (theName == atomM)
+   {
+      return true;
+   }
+   if (rename() == false)
+   {
+      return false;
+   }
+   atomM = theName;
+   nameM.erase();
+   return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool
+ScriptPropertyCache::useName(
+   const std::string& theName)
+{
+   if (atomM.isNull() == true && theName == nameM)
+   {
+      return true;
+   }
+   if (rename() == false)
+   {
+      return false;
+   }
+   atomM = ScriptAtom();
+   nameM = theName;
+   return true;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,156 @@
+#ifndef PALSCRIPTPROPERTYCACHE_H
+#define PALSCRIPTPROPERTYCACHE_H
+
+#include "JsScriptAtom.h"
+#include "JsScriptValue.h"
+#include <string>
+
+namespace Js
+{
+   class ScriptObject;
+   class ScriptShape;
+
+   /** \class ScriptPropertyCache ScriptPropertyCache.h "ScriptPropertyCache.h"
+    * \ingroup PALSCRIPT
+    * Inline cache of a property access node.
+    * The cache remembers for up to four shapes where the property was
+    * found: in a slot of the object itself or in a slot of one of its
+    * first two prototypes. A cached access costs a comparison of the
+    * shapes on the way and an indexed load. Only shared shapes are
+    * cached, because private shapes change in place.
+    */
+   class ScriptPropertyCache
+   {
+   public:
+
+      ScriptPropertyCache();
+
+      /**
+       * Get the value of a property.
+       * @param theObject The object.
+       * @param theName   The atom of the name of the property.
+       * @return The value of the property.
+       */
+      ScriptValue
+      getProperty(
+         const ScriptObject* theObject,
+         const ScriptAtom&   theName);
+
+      /**
+       * Get the value of a property whose name is computed by a subscript.
+       * @param theObject The object.
+       * @param theName   The name of the property.
+       * @return The value of the property.
+       */
+      ScriptValue
+      getProperty(
+         const ScriptObject* theObject,
+         const std::string&  theName);
+
+      /**
+       * Put the value of a property.
+       * @param theObject The object.
+       * @param theName   The name of the property.
+       * @param theValue  The new value of the property.
+       * @return 'true'   if the value could be put,
+       *         'false', otherwise.
+       */
+      bool
+      putProperty(
+         ScriptObject*      theObject,
+         const ScriptAtom&  theName,
+         const ScriptValue& theValue);
+
+      /**
+       * Put the value of a property whose name is computed by a subscript.
+       * @param theObject The object.
+       * @param theName   The name of the property.
+       * @param theValue  The new value of the property.
+       * @return 'true'   if the value could be put,
+       *         'false', otherwise.
+       */
+      bool
+      putProperty(
+         ScriptObject*      theObject,
+         const std::string& theName,
+         const ScriptValue& theValue);
+
+   private:
+
+      enum
+      {
+         EntriesC      = 4,  // shapes per cache
+         MaxDepthC     = 2,  // prototypes per entry
+         MaxRenamingsC = 8   // changes of the name before the cache gives up
+      };
+
+      struct Entry
+      {
+         // Shapes of the object and of the prototypes up to the holder
+         const ScriptShape* shapesM[MaxDepthC + 1];
+         int                depthM;   // 0 if the object holds the property
+         int                slotM;    // slot of the property in the holder
+      };
+
+      /**
+       * Get the value of a property through the cache.
+       * @param theName The name or the atom of the name of the property.
+       */
+      template <class Name>
+      ScriptValue
+      getCachedProperty(
+         const ScriptObject* theObject,
+         const Name&         theName);
+
+      /**
+       * Put the value of a property through the cache.
+       * @param theName The name or the atom of the name of the property.
+       */
+      template <class Name>
+      bool
+      putCachedProperty(
+         ScriptObject*      theObject,
+         const Name&        theName,
+         const ScriptValue& theValue);
+
+      /**
+       * Make the cache refer to the specified property name.
+       * @return 'false' if the name changed too often to be cached.
+       */
+      bool
+      useName(
+         const ScriptAtom& theName);
+
+      bool
+      useName(
+         const std::string& theName);
+
+      /**
+       * Forget the entries of the previous property name.
+       * @return 'false' if the name changed too often to be cached.
+       */
+      bool
+      rename();
+
+      /**
+       * Look up the property and add an entry for the object to the cache.
+       * @return The object holding the property, or 0 if the property
+       *         can't be cached.
+       */
+      template <class Name>
+      const ScriptObject*
+      lookup(
+         const ScriptObject* theObject,
+         const Name&         theName,
+         int&                theSlot);
+
+      Entry        entriesM[EntriesC];
+      int          numberOfEntriesM;
+      int          nextEntryM;        // the entry replaced next if full
+      int          numberOfRenamingsM;
+      ScriptAtom   atomM;             // null if the name is a string
+      std::string  nameM;
+   };
+}
+
+#endif
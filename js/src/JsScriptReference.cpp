@@ -1,5 +1,37 @@
 #include "JsScriptReferenceError.h"
 #include "JsScriptReference.h"
+#include "JsScriptObjectArray.h"
 
 using namespace Js;
 
+// ----------------------------------------------------------------------------
+
+ScriptReference::ScriptReference(
+   ScriptObjectArray* theArray,
+   int                theIndex)
+:  objectM(theArray),
+   cacheM(0),
+   indexM(theIndex),
+   atomM(0)
+{
+   objectM->AddRef();
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptValue
+ScriptReference::getElementValue() const
+{
+   return ((const ScriptObjectArray*)objectM)->getElement(indexM);
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptReference::putElementValue(
+   const ScriptValue& theValue)
+{
+   ((ScriptObjectArray*)objectM)->putElement(indexM, theValue);
+}
+
+// ----------------------------------------------------------------------------
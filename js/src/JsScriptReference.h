@@ -3,11 +3,15 @@
 
 #include "JsScriptDefinitions.h"
 #include "JsScriptObject.h"
+#include "JsScriptPropertyCache.h"
 #include "JsScriptReferenceError.h"
 #include "JsScriptValue.h"
+#include <stdio.h>
 
 namespace Js
 {
+   class ScriptObjectArray;
+
    class ScriptReference :  public ThreadSafeSmartPointerObject
    {
    public:
@@ -26,6 +30,43 @@ namespace Js
          ScriptObject* theObject,
          const std::string& thePropertyName);
 
+      /**
+       * Create to the specified property of the specified object, which
+       * is accessed through the inline cache of a node.
+       * @param theObject       a pointer to the object.
+       * @param thePropertyName the name of the property.
+       * @param theCache        the cache, which must live longer than
+       *                        the reference.
+       */
+      ScriptReference(
+         ScriptObject*        theObject,
+         const std::string&   thePropertyName,
+         ScriptPropertyCache* theCache);
+
+      /**
+       * Create to the specified property of the specified object, which
+       * may be accessed through the inline cache of a node.
+       * @param theObject       a pointer to the object.
+       * @param thePropertyName the atom of the name of the property, which
+       *                        must live longer than the reference.
+       * @param theCache        the cache, which must live longer than
+       *                        the reference, or 0.
+       */
+      ScriptReference(
+         ScriptObject*        theObject,
+         const ScriptAtom&    thePropertyName,
+         ScriptPropertyCache* theCache);
+
+      /**
+       * Create a reference to the specified element of the specified array.
+       * The name of the property is only created when it is needed.
+       * @param theArray a pointer to the array.
+       * @param theIndex the index of the element, must not be negative.
+       */
+      ScriptReference(
+         ScriptObjectArray* theArray,
+         int                theIndex);
+
       /**
        * Copy constructor.
        */
@@ -91,15 +132,29 @@ namespace Js
 
    private:
 
+      ScriptValue
+      getElementValue() const;
+
+      void
+      putElementValue(
+         const ScriptValue& theValue);
+
       ScriptObject* objectM;
-      std::string        propertyNameM;
+      ScriptPropertyCache* cacheM;      // 0 if the property is not cached
+      int                indexM;        // -1 if the property is not an element
+      const ScriptAtom*  atomM;         // 0 if the property is named by
+                                        // a string or an index
+      mutable std::string propertyNameM;
    };
 
    // -------------------------------------------------------------------------
 
    inline
    ScriptReference::ScriptReference()
-   :  objectM(0)
+   :  objectM(0),
+      cacheM(0),
+      indexM(-1),
+      atomM(0)
    {
       // Empty
    }
@@ -111,6 +166,28 @@ namespace Js
       ScriptObject* theObject,
       const std::string& thePropertyName)
    :  objectM(theObject),
+      cacheM(0),
+      indexM(-1),
+      atomM(0),
+      propertyNameM(thePropertyName)
+   {
+      if (objectM != 0)
+      {
+         objectM->AddRef();
+      }
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptReference::ScriptReference(
+      ScriptObject*        theObject,
+      const std::string&   thePropertyName,
+      ScriptPropertyCache* theCache)
+   :  objectM(theObject),
+      cacheM(theCache),
+      indexM(-1),
+      atomM(0),
       propertyNameM(thePropertyName)
    {
       if (objectM != 0)
@@ -121,10 +198,31 @@ namespace Js
 
    // -------------------------------------------------------------------------
 
+   inline
+   ScriptReference::ScriptReference(
+      ScriptObject*        theObject,
+      const ScriptAtom&    thePropertyName,
+      ScriptPropertyCache* theCache)
+   :  objectM(theObject),
+      cacheM(theCache),
+      indexM(-1),
+      atomM(&thePropertyName)
+   {
+      if (objectM != 0)
+      {
+         objectM->AddRef();
+      }
+   }
+
+   // -------------------------------------------------------------------------
+
    inline
    ScriptReference::ScriptReference(
       const ScriptReference& theOther)
    :  objectM(theOther.objectM),
+      cacheM(theOther.cacheM),
+      indexM(theOther.indexM),
+      atomM(theOther.atomM),
       propertyNameM(theOther.propertyNameM)
       
    {
@@ -167,7 +265,7 @@ namespace Js
    {
       if (objectM != 0)
       {
-         return ScriptValue(objectM->deleteProperty(propertyNameM));
+         return ScriptValue(objectM->deleteProperty(getPropertyName()));
       }
       return ScriptValue(false);
    }
@@ -196,6 +294,16 @@ namespace Js
    const std::string&
    ScriptReference::getPropertyName() const
    {
+      if (atomM != 0)
+      {
+         return atomM->getName();
+      }
+      if (indexM >= 0 && propertyNameM.empty() == true)
+      {
+         char buf[12];
+         snprintf(buf, sizeof(buf), "%d", indexM);
+         propertyNameM = buf;
+      }
       return propertyNameM;
    }
 
@@ -205,10 +313,26 @@ namespace Js
    ScriptValue
    ScriptReference::getValue() const
    {
+      if (indexM >= 0)
+      {
+         return getElementValue();
+      }
       if (objectM == 0)
       {
          throw ScriptReferenceError(
-            "Can't get property '" + propertyNameM + "'.");
+            "Can't get property '" + getPropertyName() + "'.");
+      }
+      if (atomM != 0)
+      {
+         if (cacheM != 0)
+         {
+            return cacheM->getProperty(objectM, *atomM);
+         }
+         return objectM->getProperty(*atomM);   
+      }
+      if (cacheM != 0)
+      {
+         return cacheM->getProperty(objectM, propertyNameM);
       }
       return objectM->getProperty(propertyNameM);   
    }
@@ -220,10 +344,30 @@ namespace Js
    ScriptReference::putValue(
       const ScriptValue& theValue)
    {
+      if (indexM >= 0)
+      {
+         putElementValue(theValue);
+         return;
+      }
       if (objectM == 0)
       {
          throw ScriptReferenceError(
-            "Can't set property '" + propertyNameM + "'.");
+            "Can't set property '" + getPropertyName() + "'.");
+      }
+      if (atomM != 0)
+      {
+         if (cacheM != 0)
+         {
+            cacheM->putProperty(objectM, *atomM, theValue);
+            return;
+         }
+         objectM->putProperty(*atomM, theValue);
+         return;
+      }
+      if (cacheM != 0)
+      {
+         cacheM->putProperty(objectM, propertyNameM, theValue);
+         return;
       }
       objectM->putProperty(propertyNameM, theValue);
    }
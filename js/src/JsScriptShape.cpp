@@ -0,0 +1,188 @@
+#include "JsScriptMutex.h"
+#include "JsScriptShape.h"
+
+using namespace Js;
+
+// Objects with more properties get a private shape
+static const int MaxSharedSlotsC = 64;
+
+// Upper limit of the number of shared shapes, which are never deleted
+static const int MaxSharedShapesC = 16384;
+
+static int numberOfSharedShapesS = 1;
+
+// Protects the transitions of the shared shapes
+static ScriptMutex transitionLockS;
+
+static const char PrototypeC[] = "prototype";
+
+// ----------------------------------------------------------------------------
+// CONSTRUCTORS AND DESTRUCTORS:
+// ----------------------------------------------------------------------------
+
+ScriptShape::ScriptShape(
+   bool theIsShared)
+:  isSharedM(theIsShared),
+   prototypeSlotM(-1),
+   numberOfNamesM(0)
+{
+   // Empty
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptShape::ScriptShape(
+   const ScriptShape& theOther,
+   bool               theIsShared)
+:  isSharedM(theIsShared),
+   prototypeSlotM(theOther.prototypeSlotM),
+   numberOfNamesM(theOther.numberOfNamesM),
+   namesM(theOther.namesM),
+   atomsM(theOther.atomsM),
+   slotsM(theOther.slotsM),
+   atomSlotsM(theOther.atomSlotsM)
+{
+   // Empty
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptShape::~ScriptShape()
+{
+   // Empty
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptShape*
+ScriptShape::addProperty(
+   const ScriptAtom& theName)
+{
+   if (isSharedM == false)
+   {
+      appendProperty(theName, theName.getName());
+      return this;
+   }
+
+   transitionLockS.lock();
+   AtomTransitions::iterator iter = atomTransitionsM.find(theName);
+   if (iter != atomTransitionsM.end())
+   {
+      ScriptShape* result = (*iter).second;
+      transitionLockS.unlock();
+      return result;
+   }
+   bool isShared = getSize() < MaxSharedSlotsC &&
+                   numberOfSharedShapesS < MaxSharedShapesC;
+   ScriptShape* result = new ScriptShape(*this, isShared);
+   result->appendProperty(theName, theName.getName());
+   if (isShared == true)
+   {
+      atomTransitionsM.insert(AtomTransitions::value_type(theName, result));
+      numberOfSharedShapesS++;
+   }
+   transitionLockS.unlock();
+   return result;
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptShape*
+ScriptShape::addProperty(
+   const std::string& theName)
+{
+   if (isSharedM == false)
+   {
+      appendProperty(ScriptAtom(), theName);
+      return this;
+   }
+
+   transitionLockS.lock();
+   Transitions::iterator iter = transitionsM.find(theName);
+   if (iter != transitionsM.end())
+   {
+      ScriptShape* result = (*iter).second;
+      transitionLockS.unlock();
+      return result;
+   }
+   bool isShared = getSize() < MaxSharedSlotsC &&
+                   numberOfSharedShapesS < MaxSharedShapesC;
+   ScriptShape* result = new ScriptShape(*this, isShared);
+   result->appendProperty(ScriptAtom(), theName);
+   if (isShared == true)
+   {
+      transitionsM.insert(Transitions::value_type(theName, result));
+      numberOfSharedShapesS++;
+   }
+   transitionLockS.unlock();
+   return result;
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptShape::appendProperty(
+   const ScriptAtom&  theAtom,
+   const std::string& theName)
+{
+   if (theName == PrototypeC)
+   {
+      prototypeSlotM = namesM.size();
+   }
+   if (theAtom.isNull() == true)
+   {
+      numberOfNamesM++;
+   }
+   else
+   {
+      atomSlotsM.insert(AtomSlots::value_type(theAtom, namesM.size()));
+   }
+   slotsM.insert(Slots::value_type(theName, namesM.size()));
+   namesM.push_back(theName);
+   atomsM.push_back(theAtom);
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptShape*
+ScriptShape::getEmptyShape()
+{
+   static ScriptShape* emptyShape = new ScriptShape(true);
+   return emptyShape;
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptShape*
+ScriptShape::removeProperty(
+   int theSlot)
+{
+   ScriptShape* result = this;
+   if (isSharedM == true)
+   {
+      result = new ScriptShape(*this, false);
+   }
+   result->slotsM.erase(result->namesM[theSlot]);
+   if (result->atomsM[theSlot].isNull() == true)
+   {
+      result->numberOfNamesM--;
+   }
+   else
+   {
+      result->atomSlotsM.erase(result->atomsM[theSlot]);
+   }
+   result->namesM.erase(result->namesM.begin() + theSlot);
+   result->atomsM.erase(result->atomsM.begin() + theSlot);
+   for (int i = theSlot; i < result->getSize(); i++)
+   {
+      result->slotsM[result->namesM[i]] = i;
+      if (result->atomsM[i].isNull() == false)
+      {
+         result->atomSlotsM[result->atomsM[i]] = i;
+      }
+   }
+   result->prototypeSlotM = result->getSlot(std::string(PrototypeC));
+   return result;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,239 @@
+#ifndef PALSCRIPTSHAPE_H
+#define PALSCRIPTSHAPE_H
+
+#include "JsScriptAtom.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Js
+{
+   /** \class ScriptShape ScriptShape.h "ScriptShape.h"
+    * \ingroup PALSCRIPT
+    * The layout of the properties of an object.
+    * A shape maps the names of the properties to the indexes of their
+    * slots. Objects that got the same properties in the same order share
+    * the same shape. Shared shapes are never changed or deleted; an object
+    * that deletes a property or gets too many properties switches to a
+    * private shape that it changes in place and deletes when it is no
+    * longer needed.
+    * Properties named in the source of a script are found by the atom of
+    * their name, properties with names computed at run time only by the
+    * name itself.
+    */
+   class ScriptShape
+   {
+   public:
+
+      /**
+       * Get the shape of objects without properties.
+       */
+      static
+      ScriptShape*
+      getEmptyShape();
+
+      /**
+       * Get the shape with an additional property.
+       * A private shape is changed in place and returned.
+       * @param theName The name of the new property, which must not
+       *                exist in this shape.
+       * @return The shape with the new property in the last slot.
+       */
+      ScriptShape*
+      addProperty(
+         const ScriptAtom& theName);
+
+      /**
+       * Get the shape with an additional property whose name has not
+       * been interned.
+       * A private shape is changed in place and returned.
+       * @param theName The name of the new property, which must not
+       *                exist in this shape.
+       * @return The shape with the new property in the last slot.
+       */
+      ScriptShape*
+      addProperty(
+         const std::string& theName);
+
+      /**
+       * Get the name of the property in the specified slot.
+       */
+      const std::string&
+      getName(
+         int theSlot) const;
+
+      /**
+       * Get the slot of the property 'prototype'.
+       * @return The index of the slot, -1 if the property does not exist.
+       */
+      int
+      getPrototypeSlot() const;
+
+      /**
+       * Get the number of slots.
+       */
+      int
+      getSize() const;
+
+      /**
+       * Get the slot of the specified property.
+       * @return The index of the slot, -1 if the property does not exist.
+       */
+      int
+      getSlot(
+         const ScriptAtom& theName) const;
+
+      /**
+       * Get the slot of the specified property.
+       * @return The index of the slot, -1 if the property does not exist.
+       */
+      int
+      getSlot(
+         const std::string& theName) const;
+
+      /**
+       * Check if the shape is shared by several objects.
+       */
+      bool
+      isShared() const;
+
+      /**
+       * Get the shape without the property in the specified slot.
+       * The slots behind the slot move down by one.
+       * @return The private shape without the property.
+       */
+      ScriptShape*
+      removeProperty(
+         int theSlot);
+
+      /**
+       * Release the shape of an object.
+       * Private shapes are deleted, shared shapes are kept.
+       */
+      void
+      release();
+
+   private:
+
+      typedef std::map<ScriptAtom, int>            AtomSlots;
+      typedef std::map<std::string, int>           Slots;
+      typedef std::map<ScriptAtom, ScriptShape*>   AtomTransitions;
+      typedef std::map<std::string, ScriptShape*>  Transitions;
+
+      ScriptShape(
+         bool theIsShared);
+
+      ScriptShape(
+         const ScriptShape& theOther,
+         bool               theIsShared);
+
+      ~ScriptShape();
+
+      // Not implemented
+      ScriptShape&
+      operator=(
+         const ScriptShape& theOther);
+
+      void
+      appendProperty(
+         const ScriptAtom&  theAtom,
+         const std::string& theName);
+
+      bool                     isSharedM;
+      int                      prototypeSlotM;
+      int                      numberOfNamesM;  // properties without atom
+      std::vector<std::string> namesM;          // names in the order of
+                                                // the slots
+      std::vector<ScriptAtom>  atomsM;          // null if not interned
+      Slots                    slotsM;          // all properties
+      AtomSlots                atomSlotsM;      // interned properties
+      AtomTransitions          atomTransitionsM;// shared shapes with one
+      Transitions              transitionsM;    // more property
+   };
+
+   // -------------------------------------------------------------------------
+
+   inline
+   const std::string&
+   ScriptShape::getName(
+      int theSlot) const
+   {
+      return namesM[theSlot];
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   int
+   ScriptShape::getPrototypeSlot() const
+   {
+      return prototypeSlotM;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   int
+   ScriptShape::getSize() const
+   {
+      return namesM.size();
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   int
+   ScriptShape::getSlot(
+      const ScriptAtom& theName) const
+   {
+      AtomSlots::const_iterator iter = atomSlotsM.find(theName);
+      if (iter != atomSlotsM.end())
+      {
+         return (*iter).second;
+      }
+      if (numberOfNamesM == 0)
+      {
+         return -1;
+      }
+      // The property may have been added with a name that was not interned
+      return getSlot(theName.getName());
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   int
+   ScriptShape::getSlot(
+      const std::string& theName) const
+   {
+      Slots::const_iterator iter = slotsM.find(theName);
+      if (iter != slotsM.end())
+      {
+         return (*iter).second;
+      }
+      return -1;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   bool
+   ScriptShape::isShared() const
+   {
+      return isSharedM;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   void
+   ScriptShape::release()
+   {
+      if (isSharedM == false)
+      {
+         delete this;
+      }
+   }
+}
+
+#endif
@@ -1,10 +1,12 @@
 #include "JsScannerUtilities.h"
 #include "JsScriptObject.h"
+#include "JsScriptObjectArray.h"
 #include "JsScriptReference.h"
 #include "JsScriptReferenceError.h"
 #include "JsScriptTypeError.h"
 #include "JsScriptValue.h"
 #include <iomanip>
+#include <limits.h>
 #include <limits>
 #include <sstream>
 
@@ -12,17 +14,38 @@ using namespace Js;
 
 const ScriptValue ScriptValue::UndefinedC;
 
+__thread ScriptValue::Command ScriptValue::completionM = ScriptValue::NoneE;
+
 // ----------------------------------------------------------------------------
 
 ScriptValue::ScriptValue(
-   ScriptValue& theObject,
-   ScriptValue& thePropertyName)
-:  cmdAndDataTypeM(UndefinedE)
+   ScriptValue&         theObject,
+   ScriptValue&         thePropertyName,
+   ScriptPropertyCache* theCache)
 {
-   valueM.referenceValue = 
-      new ScriptReference(theObject.toObject(), thePropertyName.toString());
-   valueM.referenceValue->AddRef();
-   cmdAndDataTypeM = ReferenceE;
+   ScriptReference* reference;
+   Number index;
+   if (thePropertyName.getDataType() == NumberE &&
+       theObject.getDataType() == ObjectE &&
+       theObject.toObject()->getObjectType() == ScriptObject::ArrayE &&
+       (index = thePropertyName.toNumber()) >= 0 &&
+       index < INT_MAX &&
+       index == (int)index)
+   {
+      // Array element: skip the conversion of the index into a name
+      reference = 
+         new ScriptReference((ScriptObjectArray*)theObject.toObject(), 
+                             (int)index);
+   }
+   else
+   {
+      reference = 
+         new ScriptReference(theObject.toObject(), 
+                             thePropertyName.toString(),
+                             theCache);
+   }
+   reference->AddRef();
+   valueM.bits = box(ReferenceE, reference);
 }
 
 // ----------------------------------------------------------------------------
@@ -31,167 +54,57 @@ ScriptValue::ScriptValue(
    Command      theCommand,
    ScriptValue& theObject,
    ScriptValue& thePropertyName)
-:  cmdAndDataTypeM(UndefinedE)
 {
-   valueM.referenceValue = 
+   ScriptReference* reference = 
       new ScriptReference(theObject.toObject(), thePropertyName.toString());
-   valueM.referenceValue->AddRef();
-   cmdAndDataTypeM = theCommand | ReferenceE;
+   reference->AddRef();
+   valueM.bits = box(ReferenceE, reference);
+   completionM = theCommand;
 }
 
 // ----------------------------------------------------------------------------
 
 ScriptValue::ScriptValue(
-   const ScriptObject* theObject,
-   const std::string&       thePropertyName)
-:  cmdAndDataTypeM(ReferenceE)
+   const ScriptObject*  theObject,
+   const std::string&   thePropertyName,
+   ScriptPropertyCache* theCache)
 {
-   valueM.referenceValue = new ScriptReference(const_cast<ScriptObject*>(theObject), 
-                                               thePropertyName);
-   valueM.referenceValue->AddRef();
+   ScriptReference* reference = 
+      new ScriptReference(const_cast<ScriptObject*>(theObject), 
+                          thePropertyName,
+                          theCache);
+   reference->AddRef();
+   valueM.bits = box(ReferenceE, reference);
 }
 
 // ----------------------------------------------------------------------------
 
 ScriptValue::ScriptValue(
-   Command             theCommand,
-   const ScriptObject* theObject,
-   const std::string&       thePropertyName)
-:  cmdAndDataTypeM(theCommand | ReferenceE)
+   const ScriptObject*  theObject,
+   const ScriptAtom&    thePropertyName,
+   ScriptPropertyCache* theCache)
 {
-   valueM.referenceValue = 
+   ScriptReference* reference = 
       new ScriptReference(const_cast<ScriptObject*>(theObject), 
-                          thePropertyName);
-   valueM.referenceValue->AddRef();
-}
-
-// ----------------------------------------------------------------------------
-
-ScriptValue::~ScriptValue()
-{
-   switch (cmdAndDataTypeM & DataTypeMaskE)
-   {
-      case ObjectE:
-      {
-         if (valueM.objectValue != 0)
-         {
-            valueM.objectValue->Release();
-         }
-         break;
-      }
-      case ReferenceE:
-      {
-         if (valueM.referenceValue != 0)
-         {
-            valueM.referenceValue->Release();
-         }
-         break;
-      }
-      case StringE:
-      {
-         if (valueM.stringValue != 0)
-         {
-            valueM.stringValue->Release();
-         }
-         break;
-      }
-   }
+                          thePropertyName,
+                          theCache);
+   reference->AddRef();
+   valueM.bits = box(ReferenceE, reference);
 }
 
 // ----------------------------------------------------------------------------
 
-ScriptValue&
-ScriptValue::operator=(
-   const ScriptValue& theOther)
+ScriptValue::ScriptValue(
+   Command             theCommand,
+   const ScriptObject* theObject,
+   const std::string&       thePropertyName)
 {
-   if (this == &theOther)
-   {
-      return *this;
-   }
-   switch (cmdAndDataTypeM & DataTypeMaskE)
-   {
-      case ObjectE:
-      {
-         if (valueM.objectValue != 0)
-         {
-            valueM.objectValue->Release();
-         }
-         break;
-      }
-      case ReferenceE:
-      {
-         if (valueM.referenceValue != 0)
-         {
-            valueM.referenceValue->Release();
-         }
-         break;
-      }
-      case StringE:
-      {
-         if (valueM.stringValue != 0)
-         {
-            valueM.stringValue->Release();
-         }
-         break;
-      }
-   }
-   cmdAndDataTypeM = theOther.cmdAndDataTypeM;
-   switch (cmdAndDataTypeM & DataTypeMaskE)
-   {
-      case BooleanE:
-      {
-         valueM.booleanValue = theOther.valueM.booleanValue;
-         break;
-      }
-      case NumberE:
-      {
-         valueM.numberValue = theOther.valueM.numberValue;
-         break;
-      }
-      case ObjectE:
-      {
-         if (theOther.valueM.objectValue != 0)
-         {
-            valueM.objectValue = theOther.valueM.objectValue;
-            valueM.objectValue->AddRef();
-         }
-         else
-         {
-            cmdAndDataTypeM &= NotDataTypeMaskE;
-            cmdAndDataTypeM |= NullE;
-         }
-         break;
-      }
-      case ReferenceE:
-      {
-         if (theOther.valueM.referenceValue != 0)
-         {
-            valueM.referenceValue = theOther.valueM.referenceValue;
-            valueM.referenceValue->AddRef();
-         }
-         else
-         {
-            cmdAndDataTypeM &= NotDataTypeMaskE;
-            cmdAndDataTypeM |= NullE;
-         }
-         break;
-      }
-      case StringE:
-      {
-         if (theOther.valueM.stringValue != 0)
-         {
-            valueM.stringValue = theOther.valueM.stringValue;
-            valueM.stringValue->AddRef();
-         }
-         else
-         {
-            cmdAndDataTypeM &= NotDataTypeMaskE;
-            cmdAndDataTypeM |= NullE;
-         }
-         break;
-      }
-   }
-   return *this;
+   ScriptReference* reference = 
+      new ScriptReference(const_cast<ScriptObject*>(theObject), 
+                          thePropertyName);
+   reference->AddRef();
+   valueM.bits = box(ReferenceE, reference);
+   completionM = theCommand;
 }
 
 // ----------------------------------------------------------------------------
@@ -199,9 +112,9 @@ ScriptValue::operator=(
 ScriptValue
 ScriptValue::deleteOperator()
 {
-   if ((cmdAndDataTypeM & DataTypeMaskE) == ReferenceE)
+   if (getDataType() == ReferenceE)
    {
-      return valueM.referenceValue->deleteOperator();
+      return getReferencePointer()->deleteOperator();
    }
    else
    {
@@ -216,11 +129,11 @@ ScriptValue::format(
    std::string&       theFormatedValue,
    const std::string& theLinePrefix)
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   switch (getDataType())
    {
       case BooleanE:
       {
-         if (valueM.booleanValue == true)
+         if (getBooleanValue() == true)
          {
             theFormatedValue.append("true");
          }
@@ -259,7 +172,7 @@ ScriptValue::format(
       {
          theFormatedValue.append("{");
          std::string propertyName;
-         if (valueM.objectValue->getNameOfFirstProperty(propertyName) == false)
+         if (getObjectPointer()->getNameOfFirstProperty(propertyName) == false)
          {
             theFormatedValue.append(" }");
             return;
@@ -282,7 +195,7 @@ ScriptValue::format(
             theFormatedValue.append("\"");
             theFormatedValue.append(propertyName);
             theFormatedValue.append("\" = ");
-            ScriptValue value = valueM.objectValue->getProperty(propertyName).getValue();
+            ScriptValue value = getObjectPointer()->getProperty(propertyName).getValue();
             if (value.isObject() == true)
             {
                theFormatedValue.append("\n");
@@ -291,7 +204,7 @@ ScriptValue::format(
             value.format(theFormatedValue,
                          theLinePrefix + "   ");
          }
-         while (valueM.objectValue->getNameOfNextProperty(propertyName) == true);
+         while (getObjectPointer()->getNameOfNextProperty(propertyName) == true);
          theFormatedValue.append("\n");
          theFormatedValue.append(theLinePrefix);
          theFormatedValue.append("}");
@@ -304,7 +217,7 @@ ScriptValue::format(
       case StringE:
       {
          theFormatedValue.append("\"");
-         theFormatedValue.append(*valueM.stringValue);
+         theFormatedValue.append(*getStringPointer());
          theFormatedValue.append("\"");
          break;
       }
@@ -314,6 +227,10 @@ ScriptValue::format(
          theFormatedValue.append("undefined");
          break;
       }
+      default:
+      {
+         break;
+      }
    }
 }
 
@@ -328,11 +245,11 @@ ScriptValue::jsonFormat(
    const std::string&       theFormatOption,
    const std::string&       theLinePrefix)
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   switch (getDataType())
    {
       case BooleanE:
       {
-         if (valueM.booleanValue == true)
+         if (getBooleanValue() == true)
          {
             theFormatedValue.append("true");
          }
@@ -375,7 +292,7 @@ ScriptValue::jsonFormat(
             jb = true;
          }
 
-         if(valueM.objectValue->getObjectType() == ScriptObject::ArrayE)
+         if(getObjectPointer()->getObjectType() == ScriptObject::ArrayE)
          {
             // Array
             theFormatedValue.append("[");
@@ -387,9 +304,9 @@ ScriptValue::jsonFormat(
          }
 
          std::string propertyName;
-         if (valueM.objectValue->getNameOfFirstProperty(propertyName) == false)
+         if (getObjectPointer()->getNameOfFirstProperty(propertyName) == false)
          {
-            if(valueM.objectValue->getObjectType() == ScriptObject::ArrayE)
+            if(getObjectPointer()->getObjectType() == ScriptObject::ArrayE)
             {
                // Array
                theFormatedValue.append("]");
@@ -427,8 +344,8 @@ ScriptValue::jsonFormat(
                isFirstProperty = false;
             }
 
-            ScriptValue value = valueM.objectValue->getProperty(propertyName).getValue();
-            if(valueM.objectValue->getObjectType() != ScriptObject::ArrayE)
+            ScriptValue value = getObjectPointer()->getProperty(propertyName).getValue();
+            if(getObjectPointer()->getObjectType() != ScriptObject::ArrayE)
             {
                // Only add the name if the object is not an array.
                if(jb == true)
@@ -457,7 +374,7 @@ ScriptValue::jsonFormat(
                   theFormatOption,
                   theLinePrefix + "   ");
          }
-         while (valueM.objectValue->getNameOfNextProperty(propertyName) == true);
+         while (getObjectPointer()->getNameOfNextProperty(propertyName) == true);
 
          if(jb == true)
          {
@@ -465,7 +382,7 @@ ScriptValue::jsonFormat(
             theFormatedValue.append(theLinePrefix);
          }
 
-         if(valueM.objectValue->getObjectType() == ScriptObject::ArrayE)
+         if(getObjectPointer()->getObjectType() == ScriptObject::ArrayE)
          {
             // Array
             theFormatedValue.append("]");
@@ -484,7 +401,7 @@ ScriptValue::jsonFormat(
       case StringE:
       {
          theFormatedValue.append("\"");
-         theFormatedValue.append(*valueM.stringValue);
+         theFormatedValue.append(*getStringPointer());
          theFormatedValue.append("\"");
          break;
       }
@@ -494,6 +411,10 @@ ScriptValue::jsonFormat(
          throw ScriptTypeError("'undefined' cannot be converted to JSON", theFile, theLine);
          break;
       }
+      default:
+      {
+         break;
+      }
    }
 }
 
@@ -502,9 +423,9 @@ ScriptValue::jsonFormat(
 ScriptObject*
 ScriptValue::getBase()
 {
-   if ((cmdAndDataTypeM & DataTypeMaskE) == ReferenceE)
+   if (getDataType() == ReferenceE)
    {
-      return valueM.referenceValue->getBase();
+      return getReferencePointer()->getBase();
    }
    else
    {
@@ -518,9 +439,9 @@ static std::string EmptyStringC;
 const std::string&
 ScriptValue::getPropertyName() const
 {
-   if ((cmdAndDataTypeM & DataTypeMaskE) == ReferenceE)
+   if (getDataType() == ReferenceE)
    {
-      return valueM.referenceValue->getPropertyName();
+      return getReferencePointer()->getPropertyName();
    }
    else
    {
@@ -533,7 +454,7 @@ ScriptValue::getPropertyName() const
 ScriptValue
 ScriptValue::getTypeof() const
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   switch (getDataType())
    {
       case BooleanE:
       {
@@ -573,9 +494,9 @@ void
 ScriptValue::putValue(
    const ScriptValue& theValue)
 {
-   if ((cmdAndDataTypeM & DataTypeMaskE) == ReferenceE)
+   if (getDataType() == ReferenceE)
    {
-      valueM.referenceValue->putValue(theValue);
+      getReferencePointer()->putValue(theValue);
    }
    else
    {
@@ -591,8 +512,7 @@ void
 ScriptValue::print() const
 {
    ScriptValue tempValue(*this);
-   tempValue.toString();
-   printf(tempValue.valueM.stringValue->c_str());
+   printf(tempValue.toString().c_str());
 }
 
 // ----------------------------------------------------------------------------
@@ -603,7 +523,7 @@ ScriptValue::read(
    int&         theLine, 
    int&         theColumn)
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   switch (getDataType())
    {
       case BooleanE:
       {
@@ -612,12 +532,12 @@ ScriptValue::read(
                                                         theColumn);
          if (value == "true")
          {
-            valueM.booleanValue = true;
+            valueM.bits = box(BooleanE, (Bits)true);
          }
          else
          if (value == "false")
          {
-            valueM.booleanValue = false;
+            valueM.bits = box(BooleanE, (Bits)false);
          }
          else
          {
@@ -644,22 +564,20 @@ ScriptValue::read(
       }
       case NumberE:
       {
-         valueM.numberValue = ScannerUtilities::getNumber(theCurrentChar,
-                                                          theLine, 
-                                                          theColumn);
+         setNumberValue(ScannerUtilities::getNumber(theCurrentChar,
+                                                    theLine, 
+                                                    theColumn));
          break;
       }
       case ObjectE:
       {
-         if (valueM.objectValue != 0)
-         {
-            valueM.objectValue->Release();
-         }
-         valueM.objectValue = new ScriptObject(ScriptObject::ObjectE);
-         valueM.objectValue->AddRef();
-         valueM.objectValue->read(theCurrentChar, 
-                                  theLine, 
-                                  theColumn);
+         ScriptObject* object = new ScriptObject(ScriptObject::ObjectE);
+         object->AddRef();
+         releaseValue();
+         valueM.bits = box(ObjectE, object);
+         object->read(theCurrentChar, 
+                      theLine, 
+                      theColumn);
          break;
       }
       case ReferenceE:
@@ -668,15 +586,13 @@ ScriptValue::read(
       }
       case StringE:
       {
-         if (valueM.stringValue != 0)
-         {
-            valueM.stringValue->Release();
-         }
-         valueM.stringValue = new ScriptString;
-         valueM.stringValue->AddRef();
-         valueM.stringValue->read(theCurrentChar, 
-                                  theLine, 
-                                  theColumn);
+         ScriptString* string = new ScriptString;
+         string->AddRef();
+         releaseValue();
+         valueM.bits = box(StringE, string);
+         string->read(theCurrentChar, 
+                      theLine, 
+                      theColumn);
          break;
       }
       case UndefinedE:
@@ -693,6 +609,10 @@ ScriptValue::read(
          }
          break;
       }
+      default:
+      {
+         break;
+      }
    }
 }
 
@@ -702,8 +622,8 @@ ScriptValue
 ScriptValue::operator+(
    ScriptValue& theRhs)
 {
-   if ((cmdAndDataTypeM & DataTypeMaskE) == StringE || 
-       (theRhs.cmdAndDataTypeM & DataTypeMaskE) == StringE)
+   if (getDataType() == StringE || 
+       theRhs.getDataType() == StringE)
    {
       return ScriptValue(toString() + theRhs.toString());
    }
@@ -719,11 +639,11 @@ ScriptValue
 ScriptValue::operator==(
    ScriptValue& theRhs)
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   switch (getDataType())
    {
       case BooleanE:
       {
-         if ((theRhs.cmdAndDataTypeM & DataTypeMaskE) == BooleanE)
+         if (theRhs.getDataType() == BooleanE)
          {
             return ScriptValue(toBoolean() == theRhs.toBoolean());
          }
@@ -736,13 +656,13 @@ ScriptValue::operator==(
       }
       case NullE:
       {
-         if ((theRhs.cmdAndDataTypeM & DataTypeMaskE) == NullE || 
-             (theRhs.cmdAndDataTypeM & DataTypeMaskE) == UndefinedE)
+         if (theRhs.getDataType() == NullE || 
+             theRhs.getDataType() == UndefinedE)
          {
             return ScriptValue(true);
          }
          else
-         if ((theRhs.cmdAndDataTypeM & DataTypeMaskE) == BooleanE)
+         if (theRhs.getDataType() == BooleanE)
          {
             return ScriptValue(toBoolean() == theRhs.toBoolean());
          }
@@ -754,7 +674,7 @@ ScriptValue::operator==(
       }
       case ObjectE:
       {
-         if ((theRhs.cmdAndDataTypeM & DataTypeMaskE) == ObjectE)
+         if (theRhs.getDataType() == ObjectE)
          {
             return toObject() == theRhs.toObject();
          }
@@ -766,17 +686,17 @@ ScriptValue::operator==(
       }
       case StringE:
       {
-         if ((theRhs.cmdAndDataTypeM & DataTypeMaskE) == StringE)
+         if (theRhs.getDataType() == StringE)
          {
             return ScriptValue(toString() == theRhs.toString());
          }
          else
-         if ((theRhs.cmdAndDataTypeM & DataTypeMaskE) == NumberE)
+         if (theRhs.getDataType() == NumberE)
          {
             return ScriptValue(toNumber() == theRhs.toNumber());
          }
          else
-         if ((theRhs.cmdAndDataTypeM & DataTypeMaskE) == BooleanE)
+         if (theRhs.getDataType() == BooleanE)
          {
             theRhs.toNumber();
             return *this == theRhs;
@@ -785,20 +705,24 @@ ScriptValue::operator==(
       }
       case UndefinedE:
       {
-         if ((theRhs.cmdAndDataTypeM & DataTypeMaskE) == UndefinedE || 
-             (theRhs.cmdAndDataTypeM  & DataTypeMaskE) == NullE)
+         if (theRhs.getDataType() == UndefinedE || 
+             (theRhs.getDataType()) == NullE)
          {
             return ScriptValue(true);
          }
          else
-         if ((theRhs.cmdAndDataTypeM & DataTypeMaskE) == BooleanE)
+         if (theRhs.getDataType() == BooleanE)
          {
             toBoolean();
-            return ScriptValue(valueM.booleanValue == 
-                               theRhs.valueM.booleanValue);
+            return ScriptValue(getBooleanValue() == 
+                               theRhs.getBooleanValue());
          }
          break;
       }
+      default:
+      {
+         break;
+      }
    }
    return ScriptValue(false);
 }
@@ -809,8 +733,8 @@ ScriptValue
 ScriptValue::operator<(
    ScriptValue& theRhs)
 {
-   if ((cmdAndDataTypeM & DataTypeMaskE) == StringE && 
-       (theRhs.cmdAndDataTypeM  & DataTypeMaskE) == StringE)
+   if (getDataType() == StringE && 
+       (theRhs.getDataType()) == StringE)
    {
       return ScriptValue(toString() < theRhs.toString());
    }
@@ -826,8 +750,8 @@ ScriptValue
 ScriptValue::operator<=(
    ScriptValue& theRhs)
 {
-   if ((cmdAndDataTypeM & DataTypeMaskE) == StringE && 
-       (theRhs.cmdAndDataTypeM & DataTypeMaskE) == StringE)
+   if (getDataType() == StringE && 
+       theRhs.getDataType() == StringE)
    {
       return ScriptValue(!(toString() > theRhs.toString()));
    }
@@ -843,8 +767,8 @@ ScriptValue
 ScriptValue::operator>(
    ScriptValue& theRhs)
 {
-   if ((cmdAndDataTypeM & DataTypeMaskE) == StringE && 
-       (theRhs.cmdAndDataTypeM & DataTypeMaskE) == StringE)
+   if (getDataType() == StringE && 
+       theRhs.getDataType() == StringE)
    {
       return ScriptValue(toString() > theRhs.toString());
    }
@@ -860,8 +784,8 @@ ScriptValue
 ScriptValue::operator>=(
    ScriptValue& theRhs)
 {
-   if ((cmdAndDataTypeM & DataTypeMaskE) == StringE && 
-       (theRhs.cmdAndDataTypeM & DataTypeMaskE) == StringE)
+   if (getDataType() == StringE && 
+       theRhs.getDataType() == StringE)
    {
       return ScriptValue(!(toString() < theRhs.toString()));
    }
@@ -875,18 +799,32 @@ ScriptValue::operator>=(
 // PRIVATE METHODS
 // ----------------------------------------------------------------------------
 
-void
-ScriptValue::addRefObjectValue() const
-{
-   valueM.objectValue->AddRef();
-}
-
-// ----------------------------------------------------------------------------
 
 void
-ScriptValue::addRefReferenceValue() const
+ScriptValue::addRefValue() const
 {
-   valueM.referenceValue->AddRef();
+   switch (getDataType())
+   {
+      case ObjectE:
+      {
+         getObjectPointer()->AddRef();
+         break;
+      }
+      case ReferenceE:
+      {
+         getReferencePointer()->AddRef();
+         break;
+      }
+      case StringE:
+      {
+         getStringPointer()->AddRef();
+         break;
+      }
+      default:
+      {
+         // empty
+      }
+   }
 }
 
 // ----------------------------------------------------------------------------
@@ -894,72 +832,60 @@ ScriptValue::addRefReferenceValue() const
 bool
 ScriptValue::convertToBoolean()
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   bool result = false;
+   switch (getDataType())
    {
       case BooleanE:
       {
          // See ECMA-262 9.2
-         return valueM.booleanValue;
+         return getBooleanValue();
       }
       case NullE:
       {
          // See ECMA-262 9.2
-         valueM.booleanValue = false;
          break;
       }
       case NumberE:
       {
          // See ECMA-262 9.2
-         if (valueM.numberValue == 0 || valueM.numberValue == NaNC)
-         {
-            valueM.booleanValue = false;
-         }
-         else
+         if (valueM.numberValue != 0 && valueM.numberValue != NaNC)
          {
-            valueM.booleanValue = true;
+            result = true;
          }
          break;
       }
       case ObjectE:
       {
          // See ECMA-262 9.2
-         if (valueM.objectValue != 0)
-         {
-            valueM.objectValue->Release();
-         }
-         valueM.booleanValue = true;
+         releaseValue();
+         result = true;
          break;
       }
       case ReferenceE:
       {
          // TO BE DONE!!!
-         if (valueM.referenceValue != 0)
-         {
-            valueM.referenceValue->Release();
-            valueM.referenceValue = 0;
-         }
+         releaseValue();
          break;
       }
       case StringE:
       {
          // See ECMA-262 9.2
-         bool result = valueM.stringValue->size() > 0;
-         if (valueM.stringValue != 0)
-         {
-            valueM.stringValue->Release();
-         }
-         valueM.booleanValue = result;
+         result = getStringPointer() != 0 && getStringPointer()->size() > 0;
+         releaseValue();
          break;
       }
       case UndefinedE:
       {
          // See ECMA-262 9.2
-         valueM.booleanValue = false;
+         break;
+      }
+      default:
+      {
          break;
       }
    }
-   cmdAndDataTypeM = BooleanE;
-   return valueM.booleanValue;
+   valueM.bits = box(BooleanE, (Bits)result);
+   return result;
 }
 
 // ----------------------------------------------------------------------------
@@ -967,25 +893,21 @@ ScriptValue::convertToBoolean()
 Number
 ScriptValue::convertToNumber()
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   Number result = 0;
+   switch (getDataType())
    {
       case BooleanE:
       {
          // See ECMA-262 9.3
-         if (valueM.booleanValue == true)
+         if (getBooleanValue() == true)
          {
-            valueM.numberValue = 1;
-         }
-         else
-         {
-            valueM.numberValue = 0;
+            result = 1;
          }
          break;
       }
       case NullE:
       {
          // See ECMA-262 9.3
-         valueM.numberValue = 0;
          break;
       }
       case NumberE:
@@ -997,42 +919,34 @@ ScriptValue::convertToNumber()
       {
          // See ECMA-262 9.3
          // TO BE DONE!!!
-         if (valueM.objectValue != 0)
-         {
-            valueM.objectValue->Release();
-            valueM.objectValue = 0;
-         }
+         releaseValue();
          break;
       }
       case ReferenceE:
       {
          // TO BE DONE!!!
-         if (valueM.referenceValue != 0)
-         {
-            valueM.referenceValue->Release();
-            valueM.referenceValue = 0;
-         }
+         releaseValue();
          break;
       }
       case StringE:
       {
          // See ECMA-262 9.3
-         Number result = valueM.stringValue->toNumber();
-         if (valueM.stringValue != 0)
-         {
-            valueM.stringValue->Release();
-         }
-         valueM.numberValue = result;
+         result = getStringPointer()->toNumber();
+         releaseValue();
          break;
       }
       case UndefinedE:
       {
          // See ECMA-262 9.3
-         valueM.numberValue =  NaNC;
+         result = NaNC;
+         break;
+      }
+      default:
+      {
          break;
       }
    }
-   cmdAndDataTypeM = NumberE;
+   setNumberValue(result);
    return valueM.numberValue;
 }
 
@@ -1041,14 +955,17 @@ ScriptValue::convertToNumber()
 ScriptObject*
 ScriptValue::convertToObject()
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   switch (getDataType())
    {
       case BooleanE:
+      case NumberE:
+      case StringE:
       {
          ScriptObject* tempObject = new ScriptObject(ScriptObject::ObjectE);
          tempObject->putProperty("value", *this);
-         valueM.objectValue = tempObject;
-         valueM.objectValue->AddRef();
+         tempObject->AddRef();
+         releaseValue();
+         valueM.bits = box(ObjectE, tempObject);
          break;
       }
       case NullE:
@@ -1058,32 +975,13 @@ ScriptValue::convertToObject()
             "Can't convert a null value into an object.",
             0);
       }
-      case NumberE:
-      {
-         ScriptObject* tempObject = new ScriptObject(ScriptObject::ObjectE);
-         tempObject->putProperty("value", *this);
-         valueM.objectValue = tempObject;
-         valueM.objectValue->AddRef();
-         break;
-      }
       case ObjectE:
       {
-         return valueM.objectValue;
+         return getObjectPointer();
       }
       case ReferenceE:
       {
-         break;
-      }
-      case StringE:
-      {
-         ScriptObject* tempObject = new ScriptObject(ScriptObject::ObjectE);
-         tempObject->putProperty("value", *this);
-         if (valueM.stringValue != 0)
-         {
-            valueM.stringValue->Release();
-         }
-         valueM.objectValue = tempObject;
-         valueM.objectValue->AddRef();
+         valueM.bits = box(ObjectE, getReferencePointer());
          break;
       }
       case UndefinedE:
@@ -1094,9 +992,12 @@ ScriptValue::convertToObject()
             0);
          break;
       }
+      default:
+      {
+         break;
+      }
    }
-   cmdAndDataTypeM = ObjectE;
-   return valueM.objectValue;
+   return getObjectPointer();
 }
 
 // ----------------------------------------------------------------------------
@@ -1104,27 +1005,26 @@ ScriptValue::convertToObject()
 ScriptString*
 ScriptValue::convertToScriptString()
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   ScriptString* result = 0;
+   switch (getDataType())
    {
       case BooleanE:
       {
          // See ECMA-262 9.8
-         if (valueM.booleanValue == true)
+         if (getBooleanValue() == true)
          {
-            valueM.stringValue = new ScriptString("true");
+            result = new ScriptString("true");
          }
          else
          {
-            valueM.stringValue = new ScriptString("false");
+            result = new ScriptString("false");
          }
-         valueM.stringValue->AddRef();
          break;
       }
       case NullE:
       {
          // See ECMA-262 9.8
-         valueM.stringValue = new ScriptString("null");
-         valueM.stringValue->AddRef();
+         result = new ScriptString("null");
          break;
       }
       case NumberE:
@@ -1132,49 +1032,52 @@ ScriptValue::convertToScriptString()
          // See ECMA-262 9.8
          if (valueM.numberValue == NaNC)
          {
-            valueM.stringValue = new ScriptString("NaN");
+            result = new ScriptString("NaN");
          }
          else
          if (valueM.numberValue == InfinityC)
          {
-            valueM.stringValue = new ScriptString("Infinity");
+            result = new ScriptString("Infinity");
          }
          else
          {
-            ScriptString* tempString = new ScriptString;
+            result = new ScriptString;
             std::stringstream ss;
             ss << std::setprecision(std::numeric_limits<Number>::digits10)
                << valueM.numberValue;
-            tempString->append(ss.str());
-            valueM.stringValue = tempString;
+            result->append(ss.str());
          }
-         valueM.stringValue->AddRef();         
          break;
       }
       case ObjectE:
       {
-         *this = valueM.objectValue->getStringValue();
-         break;
+         *this = getObjectPointer()->getStringValue();
+         return toScriptString();
       }
       case ReferenceE:
       {
-         break;
+         valueM.bits = box(StringE, getReferencePointer());
+         return getStringPointer();
       }
       case StringE:
       {
          // See ECMA-262 9.8
-         return valueM.stringValue;
+         return getStringPointer();
       }
       case UndefinedE:
       {
          // See ECMA-262 9.8
-         valueM.stringValue = new ScriptString("undefined");
-         valueM.stringValue->AddRef();
+         result = new ScriptString("undefined");
+         break;
+      }
+      default:
+      {
          break;
       }
    }
-   cmdAndDataTypeM = StringE;
-   return valueM.stringValue;
+   result->AddRef();
+   valueM.bits = box(StringE, result);
+   return result;
 }
 
 // ----------------------------------------------------------------------------
@@ -1182,100 +1085,47 @@ ScriptValue::convertToScriptString()
 const std::string&
 ScriptValue::convertToString()
 {
-   switch (cmdAndDataTypeM & DataTypeMaskE)
+   return *convertToScriptString();
+}
+
+// ----------------------------------------------------------------------------
+
+ScriptValue
+ScriptValue::getReferenceValue() const
+{
+   return getReferencePointer()->getValue();
+}
+
+// ----------------------------------------------------------------------------
+
+void
+ScriptValue::releaseValue() const
+{
+   if ((valueM.bits & PayloadMaskC) == 0)
+   {
+      return;
+   }
+   switch (getDataType())
    {
-      case BooleanE:
-      {
-         // See ECMA-262 9.8
-         if (valueM.booleanValue == true)
-         {
-            valueM.stringValue = new ScriptString("true");
-         }
-         else
-         {
-            valueM.stringValue = new ScriptString("false");
-         }
-         valueM.stringValue->AddRef();
-         break;
-      }
-      case NullE:
-      {
-         // See ECMA-262 9.8
-         valueM.stringValue = new ScriptString("null");
-         valueM.stringValue->AddRef();
-         break;
-      }
-      case NumberE:
-      {
-         // See ECMA-262 9.8
-         if (valueM.numberValue == NaNC)
-         {
-            valueM.stringValue = new ScriptString("NaN");
-         }
-         else
-         if (valueM.numberValue == InfinityC)
-         {
-            valueM.stringValue = new ScriptString("Infinity");
-         }
-         else
-         {
-            ScriptString* tempString = new ScriptString;
-            std::stringstream ss;
-            ss << std::setprecision(std::numeric_limits<Number>::digits10)
-               << valueM.numberValue; 
-            tempString->append(ss.str());
-            valueM.stringValue = tempString;
-         }
-         valueM.stringValue->AddRef();         
-         break;
-      }
       case ObjectE:
       {
-         *this = valueM.objectValue->getStringValue();
+         getObjectPointer()->Release();
          break;
       }
       case ReferenceE:
       {
+         getReferencePointer()->Release();
          break;
       }
       case StringE:
       {
-         // See ECMA-262 9.8
-         return *valueM.stringValue;
+         getStringPointer()->Release();
+         break;
       }
-      case UndefinedE:
+      default:
       {
-         // See ECMA-262 9.8
-         valueM.stringValue = new ScriptString("undefined");
-         valueM.stringValue->AddRef();
-         break;
+         // empty
       }
    }
-   cmdAndDataTypeM = StringE;
-   return *valueM.stringValue;
-}
-
-// ----------------------------------------------------------------------------
-
-ScriptValue
-ScriptValue::getReferenceValue() const
-{
-   return valueM.referenceValue->getValue();
-}
-
-// ----------------------------------------------------------------------------
-
-void
-ScriptValue::releaseObjectValue() const
-{
-   valueM.objectValue->Release();
-}
-
-// ----------------------------------------------------------------------------
-
-void
-ScriptValue::releaseReferenceValue() const
-{
-   valueM.referenceValue->Release();
 }
 
@@ -1,6 +1,7 @@
 #ifndef PALSCRIPTVALUE_H
 #define PALSCRIPTVALUE_H
 
+#include "JsScriptAtom.h"
 #include "JsScriptDefinitions.h"
 #include "JsScriptString.h"
 #include <string>
@@ -9,6 +10,7 @@
 namespace Js
 {
    class ScriptObject;
+   class ScriptPropertyCache;
    class ScriptReference;
 
    class ScriptValue
@@ -88,8 +90,14 @@ namespace Js
          const ScriptObject* theObject);
 
       ScriptValue(
-         const ScriptObject* theObject,
-         const std::string&       thePropertyName);
+         const ScriptObject*  theObject,
+         const std::string&   thePropertyName,
+         ScriptPropertyCache* theCache = 0);
+
+      ScriptValue(
+         const ScriptObject*  theObject,
+         const ScriptAtom&    thePropertyName,
+         ScriptPropertyCache* theCache = 0);
 
       ScriptValue(
          Command             theCommand,
@@ -100,8 +108,9 @@ namespace Js
          const ScriptValue& theOther);
 
       ScriptValue(
-         ScriptValue& theObject,
-         ScriptValue& thePropertyName);
+         ScriptValue&         theObject,
+         ScriptValue&         thePropertyName,
+         ScriptPropertyCache* theCache = 0);
 
       ScriptValue(
          Command      theCommand,
@@ -157,7 +166,8 @@ namespace Js
       getBase();
 
       /**
-       * Returns the command that belonngs to the value.
+       * Returns the command of the statement that completed last,
+       * see completionM.
        * @return NoneE, BreakE, ContinueE, ReturnE.
        */
       Command
@@ -293,7 +303,7 @@ namespace Js
          int&         theColumn);
 
       /**
-       * Sets the command that belongs to the value to NoneE.
+       * Sets the command of the completed statement to NoneE.
        */
       void
       resetCommand();
@@ -303,8 +313,8 @@ namespace Js
          ScriptValue& theRhs);
 
       /**
-       * Sets the command that belongs to the value.
-       * @param theCommand the command that belongs to the value.
+       * Sets the command of the completed statement.
+       * @param theCommand the command that completes the statement.
        */
       void
       setCommand(
@@ -464,11 +474,59 @@ namespace Js
 
    private:
 
+      /**
+       * A value is stored in 64 bits. Numbers are kept as plain doubles
+       * (every NaN is stored as the canonical quiet NaN). All other types
+       * live in the NaN space above FirstBoxedC: bits 48 to 50 hold the
+       * data type plus one and the low 48 bits hold the boolean or the
+       * object, reference or string pointer.
+       */
+      typedef unsigned long long Bits;
+
+      static const Bits BoxC          = 0xFFF8000000000000ULL;
+      static const Bits FirstBoxedC   = 0xFFF9000000000000ULL;
+      static const Bits PayloadMaskC  = 0x0000FFFFFFFFFFFFULL;
+      static const Bits CanonicalNaNC = 0x7FF8000000000000ULL;
+
+      static
+      Bits
+      box(
+         DataType theDataType,
+         Bits     thePayload = 0);
+
+      static
+      Bits
+      box(
+         DataType    theDataType,
+         const void* thePointer);
+
+      /**
+       * Checks if the bits hold a reference counted value, i.e. an
+       * object, a reference or a string.
+       */
+      static
+      bool
+      isCounted(
+         Bits theBits);
+
       void
-      addRefObjectValue() const;
+      addRefValue() const;
+
+      bool
+      getBooleanValue() const;
+
+      ScriptObject*
+      getObjectPointer() const;
+
+      ScriptReference*
+      getReferencePointer() const;
+
+      ScriptString*
+      getStringPointer() const;
 
       void
-      addRefReferenceValue() const;
+      setNumberValue(
+         Number theValue);
 
       bool
       convertToBoolean();
@@ -486,29 +544,114 @@ namespace Js
       convertToScriptString();
 
       void
-      releaseObjectValue() const;
+      releaseValue() const;
 
-      void
-      releaseReferenceValue() const;
+      /**
+       * The completion record of the statement that was executed last on
+       * this thread: break, continue and return are not part of the value
+       * but are kept here until the enclosing loop, switch or function
+       * consumes them.
+       */
+      static __thread Command completionM;
 
-      unsigned int cmdAndDataTypeM;
       union
       {
-         bool             booleanValue;
-         Number           numberValue;
-         ScriptObject*    objectValue;
-         ScriptReference* referenceValue;
-         ScriptString*    stringValue;
+         Bits   bits;
+         Number numberValue;
       } valueM;
    };
 
    // -------------------------------------------------------------------------
 
+   inline
+   ScriptValue::Bits
+   ScriptValue::box(
+      DataType theDataType,
+      Bits     thePayload)
+   {
+      return BoxC | ((Bits)(theDataType + 1) << 48) | thePayload;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptValue::Bits
+   ScriptValue::box(
+      DataType    theDataType,
+      const void* thePointer)
+   {
+      // User space pointers fit into the 48 bits of the payload
+      return box(theDataType, (Bits)thePointer & PayloadMaskC);
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   bool
+   ScriptValue::isCounted(
+      Bits theBits)
+   {
+      // Objects, references and strings have consecutive data types
+      return (theBits >> 48) - (box(ObjectE) >> 48) <= StringE - ObjectE;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   bool
+   ScriptValue::getBooleanValue() const
+   {
+      return (valueM.bits & PayloadMaskC) != 0;
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptObject*
+   ScriptValue::getObjectPointer() const
+   {
+      return reinterpret_cast<ScriptObject*>(valueM.bits & PayloadMaskC);
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptReference*
+   ScriptValue::getReferencePointer() const
+   {
+      return reinterpret_cast<ScriptReference*>(valueM.bits & PayloadMaskC);
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptString*
+   ScriptValue::getStringPointer() const
+   {
+      return reinterpret_cast<ScriptString*>(valueM.bits & PayloadMaskC);
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   void
+   ScriptValue::setNumberValue(
+      Number theValue)
+   {
+      valueM.numberValue = theValue;
+      if (theValue != theValue)
+      {
+         // A NaN must not be mistaken for a boxed value
+         valueM.bits = CanonicalNaNC;
+      }
+   }
+
+   // -------------------------------------------------------------------------
+
    inline
    ScriptValue::ScriptValue()
-   :  cmdAndDataTypeM(UndefinedE)
    {
-      // Empty
+      valueM.bits = box(UndefinedE);
    }
 
    // -------------------------------------------------------------------------
@@ -516,9 +659,8 @@ namespace Js
    inline
    ScriptValue::ScriptValue(
       bool theValue)
-   :  cmdAndDataTypeM(BooleanE)   
    {
-      valueM.booleanValue = theValue;
+      valueM.bits = box(BooleanE, (Bits)theValue);
    }
 
    // -------------------------------------------------------------------------
@@ -527,9 +669,9 @@ namespace Js
    ScriptValue::ScriptValue(
       Command theCommand,
       bool    theValue)
-   :  cmdAndDataTypeM(theCommand | BooleanE)   
    {
-      valueM.booleanValue = theValue;
+      valueM.bits = box(BooleanE, (Bits)theValue);
+      completionM = theCommand;
    }
 
    // -------------------------------------------------------------------------
@@ -537,9 +679,8 @@ namespace Js
    inline
    ScriptValue::ScriptValue(
       Number theValue)
-   :  cmdAndDataTypeM(NumberE)
    {
-      valueM.numberValue = theValue;
+      setNumberValue(theValue);
    }
 
    // -------------------------------------------------------------------------
@@ -547,7 +688,6 @@ namespace Js
    inline
    ScriptValue::ScriptValue(
       long theValue)
-   :  cmdAndDataTypeM(NumberE)
    {
       valueM.numberValue = (Number)theValue;
    }
@@ -559,20 +699,20 @@ namespace Js
    ScriptValue::ScriptValue(
       Command theCommand,
       Number  theValue)
-   :  cmdAndDataTypeM(theCommand | NumberE)
    {
-      valueM.numberValue = theValue;
+      setNumberValue(theValue);
+      completionM = theCommand;
    }
 
    // -------------------------------------------------------------------------
-   
+
    inline
    ScriptValue::ScriptValue(
       const std::string& theValue)
-   :  cmdAndDataTypeM(StringE)
    {
-      valueM.stringValue = new ScriptString(theValue);
-      valueM.stringValue->AddRef();
+      ScriptString* string = new ScriptString(theValue);
+      string->AddRef();
+      valueM.bits = box(StringE, string);
    }
 
    // -------------------------------------------------------------------------
@@ -581,10 +721,11 @@ namespace Js
    ScriptValue::ScriptValue(
       Command       theCommand,
       const std::string& theValue)
-   :  cmdAndDataTypeM(theCommand | StringE)
    {
-      valueM.stringValue = new ScriptString(theValue);
-      valueM.stringValue->AddRef();
+      ScriptString* string = new ScriptString(theValue);
+      string->AddRef();
+      valueM.bits = box(StringE, string);
+      completionM = theCommand;
    }
 
    // -------------------------------------------------------------------------
@@ -592,16 +733,16 @@ namespace Js
    inline
    ScriptValue::ScriptValue(
       const char* theValue)
-   :  cmdAndDataTypeM(StringE)
    {
       if (theValue != 0)
       {
-         valueM.stringValue = new ScriptString(theValue);
-         valueM.stringValue->AddRef();
+         ScriptString* string = new ScriptString(theValue);
+         string->AddRef();
+         valueM.bits = box(StringE, string);
       }
       else
       {
-         cmdAndDataTypeM = NullE;
+         valueM.bits = box(NullE);
       }
    }
 
@@ -611,17 +752,18 @@ namespace Js
    ScriptValue::ScriptValue(
       Command     theCommand,
       const char* theValue)
-   :  cmdAndDataTypeM(theCommand | StringE)
    {
       if (theValue != 0)
       {
-         valueM.stringValue = new ScriptString(theValue);
-         valueM.stringValue->AddRef();
+         ScriptString* string = new ScriptString(theValue);
+         string->AddRef();
+         valueM.bits = box(StringE, string);
       }
       else
       {
-         cmdAndDataTypeM = theCommand | NullE;
+         valueM.bits = box(NullE);
       }
+      completionM = theCommand;
    }
 
    // -------------------------------------------------------------------------
@@ -629,43 +771,15 @@ namespace Js
    inline
    ScriptValue::ScriptValue(
       DataType theDataType)
-   :  cmdAndDataTypeM(theDataType)   
    {
-      switch (cmdAndDataTypeM & DataTypeMaskE)
+      if (theDataType == NumberE)
       {
-         case BooleanE:
-         {
-            valueM.booleanValue = false;
-            break;
-         }
-         case NullE:
-         {
-            break;
-         }
-         case NumberE:
-         {
-            valueM.numberValue = 0;
-            break;
-         }
-         case ObjectE:
-         {
-            valueM.objectValue = 0;
-            break;
-         }
-         case ReferenceE:
-         {
-            valueM.referenceValue = 0;
-            break;
-         }
-         case StringE:
-         {
-            valueM.stringValue = 0;
-            break;
-         }
-         case UndefinedE:
-         {
-            break;
-         }
+         valueM.numberValue = 0;
+      }
+      else
+      {
+         // false for booleans, a null pointer for the other types
+         valueM.bits = box(theDataType);
       }
    }
 
@@ -675,48 +789,16 @@ namespace Js
    ScriptValue::ScriptValue(
       Command  theCommand,
       DataType theDataType)
-   :  cmdAndDataTypeM(theCommand | theDataType)   
    {
-      switch (theDataType)
+      if (theDataType == NumberE)
       {
-         case BooleanE:
-         {
-            valueM.booleanValue = false;
-            break;
-         }
-         case NullE:
-         {
-            break;
-         }
-         case NumberE:
-         {
-            valueM.numberValue = 0;
-            break;
-         }
-         case ObjectE:
-         {
-            valueM.objectValue = 0;
-            break;
-         }
-         case ReferenceE:
-         {
-            valueM.referenceValue = 0;
-            break;
-         }
-         case StringE:
-         {
-            valueM.stringValue = 0;
-            break;
-         }
-         case UndefinedE:
-         {
-            break;
-         }
-         default:
-         {
-            // empty
-         }
+         valueM.numberValue = 0;
+      }
+      else
+      {
+         valueM.bits = box(theDataType);
       }
+      completionM = theCommand;
    }
 
    // -------------------------------------------------------------------------
@@ -724,53 +806,51 @@ namespace Js
    inline
    ScriptValue::ScriptValue(
       const ScriptObject* theObject)
-   :  cmdAndDataTypeM(ObjectE)
    {
       if (theObject != 0)
       {
-         valueM.objectValue = const_cast<ScriptObject*>(theObject);
-         addRefObjectValue();
+         valueM.bits = box(ObjectE, theObject);
+         addRefValue();
       }
       else
       {
-         cmdAndDataTypeM = NullE;
+         valueM.bits = box(NullE);
       }
    }
-   
+
    // -------------------------------------------------------------------------
 
    inline
    ScriptValue::ScriptValue(
       Command             theCommand,
       const ScriptObject* theObject)
-   :  cmdAndDataTypeM(theCommand | ObjectE)
    {
       if (theObject != 0)
       {
-         valueM.objectValue = const_cast<ScriptObject*>(theObject);
-         addRefObjectValue();
+         valueM.bits = box(ObjectE, theObject);
+         addRefValue();
       }
       else
       {
-         cmdAndDataTypeM = theCommand | NullE;
+         valueM.bits = box(NullE);
       }
+      completionM = theCommand;
    }
-   
+
    // -------------------------------------------------------------------------
 
    inline
    ScriptValue::ScriptValue(
       const ScriptString* theString)
-   :  cmdAndDataTypeM(StringE)
    {
       if (theString != 0)
       {
-         valueM.stringValue = const_cast<ScriptString*>(theString);
-         valueM.stringValue->AddRef();
+         theString->AddRef();
+         valueM.bits = box(StringE, theString);
       }
       else
       {
-         cmdAndDataTypeM = NullE;
+         valueM.bits = box(NullE);
       }
    }
 
@@ -780,62 +860,57 @@ namespace Js
    ScriptValue::ScriptValue(
       const ScriptValue& theOther)
    {
-      cmdAndDataTypeM = theOther.cmdAndDataTypeM;
-      switch (cmdAndDataTypeM & DataTypeMaskE)
+      valueM.bits = theOther.valueM.bits;
+      if (isCounted(valueM.bits))
       {
-         case BooleanE:
+         if ((valueM.bits & PayloadMaskC) != 0)
          {
-            valueM.booleanValue = theOther.valueM.booleanValue;
-            break;
+            addRefValue();
          }
-         case NumberE:
+         else
          {
-            valueM.numberValue = theOther.valueM.numberValue;
-            break;
+            valueM.bits = box(NullE);
          }
-         case ObjectE:
-         {
-            if (theOther.valueM.objectValue != 0)
-            {
-               valueM.objectValue = theOther.valueM.objectValue;
-               addRefObjectValue();
-            }
-            else
-            {
-               cmdAndDataTypeM &= NotDataTypeMaskE;
-               cmdAndDataTypeM |= NullE;
-            }
-            break;
-         }
-         case ReferenceE:
+      }
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptValue::~ScriptValue()
+   {
+      if (isCounted(valueM.bits))
+      {
+         releaseValue();
+      }
+   }
+
+   // -------------------------------------------------------------------------
+
+   inline
+   ScriptValue&
+   ScriptValue::operator=(
+      const ScriptValue& theOther)
+   {
+      Bits bits = theOther.valueM.bits;
+      if (isCounted(bits))
+      {
+         if ((bits & PayloadMaskC) != 0)
          {
-            if (theOther.valueM.referenceValue != 0)
-            {
-               valueM.referenceValue = theOther.valueM.referenceValue;
-               addRefReferenceValue();
-            }
-            else
-            {
-               cmdAndDataTypeM &= NotDataTypeMaskE;
-               cmdAndDataTypeM |= NullE;
-            }
-            break;
+            // Take the new reference before the old one is given up
+            theOther.addRefValue();
          }
-         case StringE:
+         else
          {
-            if (theOther.valueM.stringValue != 0)
-            {
-               valueM.stringValue = theOther.valueM.stringValue;
-               valueM.stringValue->AddRef();
-            }
-            else
-            {
-               cmdAndDataTypeM &= NotDataTypeMaskE;
-               cmdAndDataTypeM |= NullE;
-            }
-            break;
+            bits = box(NullE);
          }
       }
+      if (isCounted(valueM.bits))
+      {
+         releaseValue();
+      }
+      valueM.bits = bits;
+      return *this;
    }
 
    // -------------------------------------------------------------------------
@@ -854,7 +929,7 @@ namespace Js
    ScriptValue::Command
    ScriptValue::getCommand() const
    {
-      return static_cast<Command>(cmdAndDataTypeM & CommandMaskE); 
+      return completionM;
    }
 
    // -------------------------------------------------------------------------
@@ -863,7 +938,11 @@ namespace Js
    ScriptValue::DataType
    ScriptValue::getDataType() const
    {
-      return static_cast<DataType>(cmdAndDataTypeM & DataTypeMaskE);
+      if (valueM.bits < FirstBoxedC)
+      {
+         return NumberE;
+      }
+      return static_cast<DataType>(((valueM.bits >> 48) & 0x7) - 1);
    }
 
    // -------------------------------------------------------------------------
@@ -872,7 +951,7 @@ namespace Js
    void
    ScriptValue::resetCommand()
    {
-      cmdAndDataTypeM &= NotCommandMaskE;
+      completionM = NoneE;
    }
 
    // -------------------------------------------------------------------------
@@ -882,7 +961,7 @@ namespace Js
    ScriptValue::setCommand(
       Command theCommand)
    {
-      cmdAndDataTypeM = (cmdAndDataTypeM & NotCommandMaskE) | theCommand;
+      completionM = theCommand;
    }
 
    // -------------------------------------------------------------------------
@@ -1051,8 +1130,7 @@ namespace Js
    ScriptValue::strictlyEqual(
       ScriptValue& theRhs)
    {
-      if ((cmdAndDataTypeM & DataTypeMaskE) == 
-          (theRhs.cmdAndDataTypeM & DataTypeMaskE))
+      if (getDataType() == theRhs.getDataType())
       {
          // Operands have same data type
          return *this == theRhs;
@@ -1093,7 +1171,7 @@ namespace Js
    ScriptValue
    ScriptValue::getValue() const
    {
-      if ((cmdAndDataTypeM & DataTypeMaskE) == ReferenceE)
+      if (getDataType() == ReferenceE)
       {
          return getReferenceValue();
       }
@@ -1238,10 +1316,10 @@ namespace Js
    bool
    ScriptValue::toBoolean()
    {
-      if ((cmdAndDataTypeM & DataTypeMaskE) == BooleanE)
+      if (getDataType() == BooleanE)
       {
          // See ECMA-262 9.2
-         return valueM.booleanValue;
+         return getBooleanValue();
       }
       else
       {
@@ -1255,7 +1333,7 @@ namespace Js
    Number
    ScriptValue::toNumber()
    {
-      if ((cmdAndDataTypeM & DataTypeMaskE) == NumberE)
+      if (valueM.bits < FirstBoxedC)
       {
          // See ECMA-262 9.3
          return valueM.numberValue;
@@ -1272,9 +1350,9 @@ namespace Js
    ScriptObject*
    ScriptValue::toObject()
    {
-      if ((cmdAndDataTypeM & DataTypeMaskE) == ObjectE)
+      if (getDataType() == ObjectE)
       {
-         return valueM.objectValue;
+         return getObjectPointer();
       }
       else
       {
@@ -1288,9 +1366,9 @@ namespace Js
    const ScriptObject*
    ScriptValue::toObject() const
    {
-      if ((cmdAndDataTypeM & DataTypeMaskE) == ObjectE)
+      if (getDataType() == ObjectE)
       {
-         return valueM.objectValue;
+         return getObjectPointer();
       }
       else
       {
@@ -1304,10 +1382,10 @@ namespace Js
    ScriptString*
    ScriptValue::toScriptString()
    {
-      if ((cmdAndDataTypeM & DataTypeMaskE) == StringE)
+      if (getDataType() == StringE)
       {
          // See ECMA-262 9.8
-         return valueM.stringValue;
+         return getStringPointer();
       }
       else
       {
@@ -1321,10 +1399,10 @@ namespace Js
    const std::string&
    ScriptValue::toString()
    {
-      if ((cmdAndDataTypeM & DataTypeMaskE) == StringE)
+      if (getDataType() == StringE)
       {
          // See ECMA-262 9.8
-         return *valueM.stringValue;
+         return *getStringPointer();
       }
       else
       {
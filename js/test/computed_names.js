@@ -0,0 +1,41 @@
+// Properties named by computed keys are found by literal names and back
+
+function check(theName, theActual, theExpected) {
+   if (theActual != theExpected) {
+      throw new Error(theName + ": got '" + theActual + 
+                      "', expected '" + theExpected + "'");
+   }
+}
+
+var o = new Object();
+var n = "a";
+o[n + "b"] = 1;
+check("computed put", o.ab, 1);
+o.ab = 2;
+check("literal put", o[n + "b"], 2);
+o.cd = 3;
+check("literal add", o["c" + "d"], 3);
+delete o[n + "b"];
+check("computed delete", o.ab, undefined);
+check("other kept", o.cd, 3);
+o.ab = 4;
+check("literal add after delete", o[n + "b"], 4);
+
+// A subscript with many names
+for (var i = 0; i < 20; i++) {
+   o["k" + i] = i;
+}
+var sum = 0;
+for (var i = 0; i < 20; i++) {
+   sum = sum + o["k" + i];
+}
+check("many names", sum, 190);
+check("many names literal", o.k7, 7);
+
+// Prototype properties by computed name
+function F() { this.p = 1; }
+F.prototype.q = 2;
+var f = new F();
+check("prototype", f.p + f.q + f["q"], 5);
+
+print("computed_names: OK");
@@ -0,0 +1,51 @@
+// Deleting properties during for-in must not stop the enumeration
+
+function check(theName, theActual, theExpected) {
+   if (theActual != theExpected) {
+      throw new Error(theName + ": got '" + theActual + 
+                      "', expected '" + theExpected + "'");
+   }
+}
+
+// Delete the current property of an object
+var o = new Object();
+o.a = 1; o.b = 2; o.c = 3; o.d = 4;
+var visited = "";
+for (var k in o) {
+   visited = visited + k;
+   delete o[k];
+}
+check("object visited", visited, "abcd");
+var left = "";
+for (var k in o) {
+   left = left + k;
+}
+check("object left", left, "");
+
+// Delete a property that has not been visited yet
+var p = new Object();
+p.a = 1; p.b = 2; p.c = 3;
+visited = "";
+for (var k in p) {
+   visited = visited + k;
+   if (k == "a") {
+      delete p["b"];
+   }
+}
+check("object skipped", visited, "ac");
+
+// Delete the current element of an array
+var a = new Array(1, 2, 3, 4);
+visited = "";
+for (var k in a) {
+   visited = visited + k;
+   delete a[k];
+}
+check("array visited", visited, "0123");
+left = "";
+for (var k in a) {
+   left = left + k;
+}
+check("array left", left, "");
+
+print("forin_delete: OK");
@@ -1,11 +1,10 @@
 #include <stdio.h>
 #include <unittestdef.h>
-#include "PalTime.h"
 #include "tracing.h"
-#include "PalScriptRuntime.h"
-#include "PalScript.h"
+#include "JsScriptRuntime.h"
+#include "JsScript.h"
 
-using namespace Pal;
+using namespace Js;
 
 void
 getScript_test1(uts::TestContext& context)
@@ -29,5 +28,45 @@ getScript_test1(uts::TestContext& context)
   } 
 }
 
+void
+forInDelete_test1(uts::TestContext& context)
+{
+  ScriptRuntime *rt = new ScriptRuntime();
+  std::string error;
+  Script* script = rt->getScript("forin_delete.js", error);
+  if(NULL == script){  
+     WPR_LOG(100, "%s", error.c_str());
+     fail_if(true);
+     return;
+  }
+  ScriptExecutionContext* ctx = rt->newContext();
+  int rs = rt->runScript(ctx, script, error);
+  if(rs != 0){
+     WPR_LOG(100, "%s", error.c_str());
+  } 
+  fail_if(rs != 0);
+}
+
+void
+computedNames_test1(uts::TestContext& context)
+{
+  ScriptRuntime *rt = new ScriptRuntime();
+  std::string error;
+  Script* script = rt->getScript("computed_names.js", error);
+  if(NULL == script){  
+     WPR_LOG(100, "%s", error.c_str());
+     fail_if(true);
+     return;
+  }
+  ScriptExecutionContext* ctx = rt->newContext();
+  int rs = rt->runScript(ctx, script, error);
+  if(rs != 0){
+     WPR_LOG(100, "%s", error.c_str());
+  } 
+  fail_if(rs != 0);
+}
+
 DefineTestSuite(PalRuntimeTests, uts::root());
 DefineTestCase(getScript_test1, PalRuntimeTests);
+DefineTestCase(forInDelete_test1, PalRuntimeTests);
+DefineTestCase(computedNames_test1, PalRuntimeTests);
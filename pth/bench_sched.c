@@ -0,0 +1,577 @@
+/*
+**  GNU Pth - The GNU Portable Threads
+**  Copyright (c) 1999-2006 Ralf S. Engelschall <rse@engelschall.com>
+**
+**  This file is part of GNU Pth, a non-preemptive thread scheduling
+**  library which can be found at http://www.gnu.org/software/pth/.
+**
+**  This library is free software; you can redistribute it and/or
+**  modify it under the terms of the GNU Lesser General Public
+**  License as published by the Free Software Foundation; either
+**  version 2.1 of the License, or (at your option) any later version.
+**
+**  This library is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**  Lesser General Public License for more details.
+**
+**  You should have received a copy of the GNU Lesser General Public
+**  License along with this library; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+**  USA, or contact Ralf S. Engelschall <rse@engelschall.com>.
+**
+**  bench_sched.c: Pth benchmark program (scheduler and event manager)
+*/
+                             /* ``Premature optimization is
+                                  the root of all evil.''
+                                           -- Donald E. Knuth */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#include "pth.h"
+
+/*
+ * Each benchmark runs once for every thread count between the minimum
+ * and maximum (in steps of factor 10) and prints one CSV line:
+ *
+ *   benchmark,threads,operations,seconds,ns_per_op,ops_per_sec
+ *
+ * The number of operations per run is chosen so that roughly the same
+ * amount of work is done for every thread count. Benchmarks whose cost
+ * grows with the number of threads (e.g. the mutex handoff, where every
+ * release wakes up all waiters) stop escalating the thread count once a
+ * run exceeded the time budget.
+ */
+
+static int bench_iterations = 100000;  /* operations per run (approx.)  */
+static int bench_stacksize  = 32*1024; /* stack size of spawned threads */
+static int bench_budget     = 10;      /* seconds a run may take before
+                                          larger thread counts are skipped */
+
+/* spawn a joinable thread for the benchmarks */
+static pth_t bench_spawn(const char *name, void *(*func)(void *), void *arg)
+{
+    pth_attr_t attr;
+    pth_t t;
+
+    attr = pth_attr_new();
+    pth_attr_set(attr, PTH_ATTR_NAME, name);
+    pth_attr_set(attr, PTH_ATTR_JOINABLE, TRUE);
+    pth_attr_set(attr, PTH_ATTR_STACK_SIZE, (unsigned int)bench_stacksize);
+    t = pth_spawn(attr, func, arg);
+    pth_attr_destroy(attr);
+    return t;
+}
+
+/* spawn a whole set of threads (or none at all) */
+static pth_t *bench_spawn_all(int n, const char *name, void *(*func)(void *))
+{
+    pth_t *tids;
+    int i;
+
+    if ((tids = (pth_t *)malloc(n * sizeof(pth_t))) == NULL)
+        return NULL;
+    for (i = 0; i < n; i++) {
+        if ((tids[i] = bench_spawn(name, func, (void *)((long)i))) == NULL) {
+            fprintf(stderr, "bench_sched: failed to spawn thread #%d: %s\n",
+                    i, strerror(errno));
+            while (--i >= 0)
+                pth_abort(tids[i]);
+            free(tids);
+            return NULL;
+        }
+    }
+    return tids;
+}
+
+/* join a whole set of threads */
+static void bench_join_all(pth_t *tids, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        pth_join(tids[i], NULL);
+    free(tids);
+    return;
+}
+
+/* let all spawned threads run until they block */
+static void bench_settle(void)
+{
+    while (pth_ctrl(PTH_CTRL_GETTHREADS_NEW|PTH_CTRL_GETTHREADS_READY) > 0)
+        pth_yield(NULL);
+    return;
+}
+
+/* the number of rounds per thread for a run with n threads */
+static int bench_rounds(int n)
+{
+    int rounds;
+
+    rounds = bench_iterations / n;
+    return (rounds < 1 ? 1 : rounds);
+}
+
+/* measure time */
+static double bench_now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1000000;
+}
+
+/* report a result */
+static void bench_report(const char *name, int n, long ops, double secs)
+{
+    if (secs <= 0)
+        secs = 0.000001;
+    if (ops < 1)
+        ops = 1;
+    printf("%s,%d,%ld,%.6f,%.1f,%.0f\n",
+           name, n, ops, secs, secs * 1000000000 / (double)ops, (double)ops / secs);
+    fflush(stdout);
+    return;
+}
+
+/*
+ * spawn: spawn n threads and join them again
+ */
+
+static void *bench_spawn_func(void *_arg)
+{
+    return _arg;
+}
+
+static int bench_spawn_join(int n)
+{
+    double start;
+    pth_t *tids;
+    int rounds;
+    int r;
+
+    rounds = bench_rounds(n);
+    start = bench_now();
+    for (r = 0; r < rounds; r++) {
+        if ((tids = bench_spawn_all(n, "spawn", bench_spawn_func)) == NULL)
+            return FALSE;
+        bench_join_all(tids, n);
+    }
+    bench_report("spawn_join", n, (long)rounds * n, bench_now() - start);
+    return TRUE;
+}
+
+/*
+ * yield: n threads yield to each other (n = 2 is a ping-pong)
+ */
+
+static int bench_yield_rounds;
+
+static void *bench_yield_func(void *_arg)
+{
+    int i;
+
+    for (i = 0; i < bench_yield_rounds; i++)
+        pth_yield(NULL);
+    return NULL;
+}
+
+static int bench_yield(int n)
+{
+    double start;
+    pth_t *tids;
+
+    bench_yield_rounds = bench_rounds(n);
+    if ((tids = bench_spawn_all(n, "yield", bench_yield_func)) == NULL)
+        return FALSE;
+    start = bench_now();
+    bench_join_all(tids, n);
+    bench_report("yield", n, (long)bench_yield_rounds * n, bench_now() - start);
+    return TRUE;
+}
+
+/*
+ * msgport: n clients send messages to an echo server and wait for the reply
+ */
+
+static pth_msgport_t bench_msg_server;
+static int bench_msg_rounds;
+
+static void *bench_msg_server_func(void *_arg)
+{
+    pth_event_t ev;
+    pth_message_t *m;
+
+    ev = pth_event(PTH_EVENT_MSG, bench_msg_server);
+    for (;;) {
+        pth_wait(ev);
+        while ((m = pth_msgport_get(bench_msg_server)) != NULL) {
+            if (m->m_data == NULL) {
+                pth_msgport_reply(m);
+                pth_event_free(ev, PTH_FREE_THIS);
+                return NULL;
+            }
+            pth_msgport_reply(m);
+        }
+    }
+}
+
+static void *bench_msg_client_func(void *_arg)
+{
+    pth_msgport_t mp;
+    pth_message_t msg;
+    pth_event_t ev;
+    int i;
+
+    mp = pth_msgport_create(NULL);
+    ev = pth_event(PTH_EVENT_MSG, mp);
+    memset(&msg, 0, sizeof(msg));
+    msg.m_replyport = mp;
+    msg.m_data = (void *)&msg;
+    for (i = 0; i < bench_msg_rounds; i++) {
+        pth_msgport_put(bench_msg_server, &msg);
+        pth_wait(ev);
+        pth_msgport_get(mp);
+    }
+    pth_event_free(ev, PTH_FREE_THIS);
+    pth_msgport_destroy(mp);
+    return NULL;
+}
+
+static int bench_msgport(int n)
+{
+    pth_message_t stop;
+    pth_msgport_t mp;
+    pth_event_t ev;
+    double start;
+    pth_t *tids;
+    pth_t server;
+
+    bench_msg_rounds = bench_rounds(n);
+    bench_msg_server = pth_msgport_create("bench_sched");
+    server = bench_spawn("server", bench_msg_server_func, NULL);
+    if ((tids = bench_spawn_all(n, "client", bench_msg_client_func)) != NULL) {
+        start = bench_now();
+        bench_join_all(tids, n);
+        bench_report("msgport_roundtrip", n, (long)bench_msg_rounds * n, bench_now() - start);
+    }
+
+    /* stop the server */
+    mp = pth_msgport_create(NULL);
+    ev = pth_event(PTH_EVENT_MSG, mp);
+    memset(&stop, 0, sizeof(stop));
+    stop.m_replyport = mp;
+    stop.m_data = NULL;
+    pth_msgport_put(bench_msg_server, &stop);
+    pth_wait(ev);
+    pth_msgport_get(mp);
+    pth_event_free(ev, PTH_FREE_THIS);
+    pth_msgport_destroy(mp);
+    pth_join(server, NULL);
+    pth_msgport_destroy(bench_msg_server);
+    return (tids != NULL);
+}
+
+/*
+ * mutex: n threads hand a mutex over to each other by yielding with it held
+ */
+
+static pth_mutex_t bench_mutex;
+static int bench_mutex_rounds;
+
+static void *bench_mutex_func(void *_arg)
+{
+    int i;
+
+    for (i = 0; i < bench_mutex_rounds; i++) {
+        pth_mutex_acquire(&bench_mutex, FALSE, NULL);
+        pth_yield(NULL);
+        pth_mutex_release(&bench_mutex);
+        pth_yield(NULL);
+    }
+    return NULL;
+}
+
+static int bench_mutex_handoff(int n)
+{
+    double start;
+    pth_t *tids;
+
+    bench_mutex_rounds = bench_rounds(n);
+    pth_mutex_init(&bench_mutex);
+    if ((tids = bench_spawn_all(n, "mutex", bench_mutex_func)) == NULL)
+        return FALSE;
+    start = bench_now();
+    bench_join_all(tids, n);
+    bench_report("mutex_handoff", n, (long)bench_mutex_rounds * n, bench_now() - start);
+    return TRUE;
+}
+
+/*
+ * cond: wake up n waiters with a condition variable broadcast
+ */
+
+static pth_mutex_t bench_cond_mutex;
+static pth_cond_t bench_cond_go;
+static pth_cond_t bench_cond_done;
+static int bench_cond_gen;
+static int bench_cond_woken;
+static int bench_cond_waiters;
+
+static void *bench_cond_func(void *_arg)
+{
+    int seen = 0;
+
+    pth_mutex_acquire(&bench_cond_mutex, FALSE, NULL);
+    for (;;) {
+        while (bench_cond_gen == seen)
+            pth_cond_await(&bench_cond_go, &bench_cond_mutex, NULL);
+        seen = bench_cond_gen;
+        if (++bench_cond_woken == bench_cond_waiters)
+            pth_cond_notify(&bench_cond_done, FALSE);
+        if (seen < 0)
+            break;
+    }
+    pth_mutex_release(&bench_cond_mutex);
+    return NULL;
+}
+
+static int bench_cond_broadcast(int n)
+{
+    double start;
+    double secs = 0;
+    pth_t *tids;
+    int rounds;
+    int r;
+
+    rounds = bench_rounds(n);
+    pth_mutex_init(&bench_cond_mutex);
+    pth_cond_init(&bench_cond_go);
+    pth_cond_init(&bench_cond_done);
+    bench_cond_gen = 0;
+    bench_cond_waiters = n;
+    if ((tids = bench_spawn_all(n, "cond", bench_cond_func)) == NULL)
+        return FALSE;
+
+    /* let all waiters block on the condition variable */
+    bench_settle();
+
+    start = bench_now();
+    pth_mutex_acquire(&bench_cond_mutex, FALSE, NULL);
+    for (r = 0; r <= rounds; r++) {
+        bench_cond_gen = (r < rounds ? r + 1 : -1);
+        bench_cond_woken = 0;
+        pth_cond_notify(&bench_cond_go, TRUE);
+        while (bench_cond_woken < n)
+            pth_cond_await(&bench_cond_done, &bench_cond_mutex, NULL);
+        if (r == rounds - 1)
+            secs = bench_now() - start;
+    }
+    pth_mutex_release(&bench_cond_mutex);
+    bench_join_all(tids, n);
+    bench_report("cond_broadcast", n, (long)rounds * n, secs);
+    return TRUE;
+}
+
+/*
+ * eventmgr: cost of the event manager per scheduler pass with n idle
+ * waiters, measured as the yield ping-pong latency of two busy threads
+ */
+
+static int bench_idle_fd = -1;
+static pth_msgport_t bench_idle_mp;
+static pth_t bench_idle_peer[2];
+static int bench_idle_rounds;
+
+static void *bench_idle_fd_func(void *_arg)
+{
+    pth_event_t ev;
+
+    ev = pth_event(PTH_EVENT_FD|PTH_UNTIL_FD_READABLE, bench_idle_fd);
+    pth_wait(ev);
+    pth_event_free(ev, PTH_FREE_THIS);
+    return NULL;
+}
+
+static void *bench_idle_msg_func(void *_arg)
+{
+    pth_event_t ev;
+
+    ev = pth_event(PTH_EVENT_MSG, bench_idle_mp);
+    pth_wait(ev);
+    pth_event_free(ev, PTH_FREE_THIS);
+    return NULL;
+}
+
+static void *bench_idle_pingpong_func(void *_arg)
+{
+    int me = (int)((long)_arg);
+    int i;
+
+    for (i = 0; i < bench_idle_rounds; i++)
+        pth_yield(bench_idle_peer[1-me]);
+    return NULL;
+}
+
+static int bench_eventmgr(int n, int usefd)
+{
+    pth_message_t msg;
+    double start;
+    pth_t *tids;
+    int fds[2];
+    int i;
+
+    if (usefd) {
+        if (pipe(fds) == -1) {
+            fprintf(stderr, "bench_sched: pipe: %s\n", strerror(errno));
+            exit(1);
+        }
+        bench_idle_fd = fds[0];
+    }
+    else
+        bench_idle_mp = pth_msgport_create(NULL);
+    tids = bench_spawn_all(n, "idle", usefd ? bench_idle_fd_func : bench_idle_msg_func);
+    if (tids == NULL) {
+        if (usefd) {
+            close(fds[0]);
+            close(fds[1]);
+        }
+        else
+            pth_msgport_destroy(bench_idle_mp);
+        return FALSE;
+    }
+
+    /* let all idle threads start waiting */
+    bench_settle();
+
+    bench_idle_rounds = bench_iterations;
+    bench_idle_peer[0] = bench_spawn("ping", bench_idle_pingpong_func, (void *)0);
+    bench_idle_peer[1] = bench_spawn("pong", bench_idle_pingpong_func, (void *)1);
+    start = bench_now();
+    pth_join(bench_idle_peer[0], NULL);
+    pth_join(bench_idle_peer[1], NULL);
+    bench_report(usefd ? "eventmgr_idle_fd" : "eventmgr_idle_msg", n,
+                 2L * bench_idle_rounds, bench_now() - start);
+
+    /* wake up the idle threads again */
+    if (usefd) {
+        close(fds[1]);
+        bench_join_all(tids, n);
+        close(fds[0]);
+    }
+    else {
+        for (i = 0; i < n; i++) {
+            memset(&msg, 0, sizeof(msg));
+            pth_msgport_put(bench_idle_mp, &msg);
+        }
+        bench_join_all(tids, n);
+        while (pth_msgport_get(bench_idle_mp) != NULL)
+            ;
+        pth_msgport_destroy(bench_idle_mp);
+    }
+    return TRUE;
+}
+
+static int bench_eventmgr_fd(int n)
+{
+    return bench_eventmgr(n, TRUE);
+}
+
+static int bench_eventmgr_msg(int n)
+{
+    return bench_eventmgr(n, FALSE);
+}
+
+/*
+ * main procedure
+ */
+
+static struct {
+    const char *name;
+    int (*func)(int);
+} bench_table[] = {
+    { "spawn",    bench_spawn_join     },
+    { "yield",    bench_yield          },
+    { "msgport",  bench_msgport        },
+    { "mutex",    bench_mutex_handoff  },
+    { "cond",     bench_cond_broadcast },
+    { "eventfd",  bench_eventmgr_fd    },
+    { "eventmsg", bench_eventmgr_msg   },
+    { NULL,       NULL                 }
+};
+
+static void usage(const char *progname)
+{
+    int i;
+
+    fprintf(stderr, "Usage: %s [-m min-threads] [-n max-threads] [-i iterations]\n"
+                    "       [-s stack-size-kb] [-t budget-seconds] [benchmark ...]\n", progname);
+    fprintf(stderr, "Benchmarks:");
+    for (i = 0; bench_table[i].name != NULL; i++)
+        fprintf(stderr, " %s", bench_table[i].name);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    int minthreads = 10;
+    int maxthreads = 100000;
+    double start;
+    double secs;
+    int selected;
+    int i, j, n;
+    int c;
+
+    while ((c = getopt(argc, argv, "m:n:i:s:t:h")) != -1) {
+        switch (c) {
+            case 'm': minthreads       = atoi(optarg); break;
+            case 'n': maxthreads       = atoi(optarg); break;
+            case 'i': bench_iterations = atoi(optarg); break;
+            case 's': bench_stacksize  = atoi(optarg) * 1024; break;
+            case 't': bench_budget     = atoi(optarg); break;
+            default:  usage(argv[0]);
+        }
+    }
+    if (minthreads < 1 || maxthreads < minthreads || bench_iterations < 1 || bench_stacksize < 1)
+        usage(argv[0]);
+    for (i = optind; i < argc; i++) {
+        for (j = 0; bench_table[j].name != NULL; j++)
+            if (strcmp(argv[i], bench_table[j].name) == 0)
+                break;
+        if (bench_table[j].name == NULL)
+            usage(argv[0]);
+    }
+
+    pth_init();
+
+    printf("benchmark,threads,operations,seconds,ns_per_op,ops_per_sec\n");
+    for (j = 0; bench_table[j].name != NULL; j++) {
+        selected = (optind == argc);
+        for (i = optind; i < argc; i++)
+            if (strcmp(argv[i], bench_table[j].name) == 0)
+                selected = TRUE;
+        if (!selected)
+            continue;
+        for (n = minthreads; n <= maxthreads; n *= 10) {
+            start = bench_now();
+            if (!bench_table[j].func(n))
+                break;
+            secs = bench_now() - start;
+            if (n > maxthreads / 10)
+                break;
+            if (bench_budget > 0 && secs > bench_budget) {
+                fprintf(stderr, "bench_sched: %s: run with %d threads took %.1f seconds, "
+                        "skipping larger thread counts\n", bench_table[j].name, n, secs);
+                break;
+            }
+        }
+    }
+
+    pth_kill();
+    return 0;
+}
@@ -125,6 +125,8 @@ BEGIN_DECLARATION
                                        PTH_CTRL_GETTHREADS_DEAD)
 #define PTH_CTRL_DUMPSTATE            _BIT(10)
 #define PTH_CTRL_FAVOURNEW            _BIT(11)
+#define PTH_CTRL_STACKCACHE           _BIT(12)
+#define PTH_CTRL_GETTHREADSTATS       _BIT(13)
 
     /* the time value structure */
 typedef struct timeval pth_time_t;
@@ -133,6 +135,16 @@ typedef struct timeval pth_time_t;
 typedef struct pth_st *pth_t;
 struct pth_st;
 
+    /* the thread statistics structure (see PTH_CTRL_GETTHREADSTATS) */
+typedef struct pth_threadstats_st pth_threadstats_t;
+struct pth_threadstats_st {
+    unsigned long ts_dispatches;     /* total number of thread dispatches       */
+    pth_time_t    ts_running;        /* cumulative time the thread was running  */
+    pth_time_t    ts_waiting;        /* cumulative time it waited for events    */
+    unsigned long ts_yields;         /* switches which left the thread ready    */
+    unsigned long ts_waits;          /* switches to wait for events             */
+};
+
     /* thread states */
 typedef enum pth_state_en {
     PTH_STATE_SCHEDULER = 0,         /* the special scheduler thread only       */
@@ -276,6 +288,10 @@ enum { PTH_RWLOCK_RD, PTH_RWLOCK_RW };
 typedef struct pth_msgport_st *pth_msgport_t;
 struct pth_msgport_st;
 
+    /* the buffered I/O structure */
+typedef struct pth_bufio_st *pth_bufio_t;
+struct pth_bufio_st;
+
     /* the message structure */
 typedef struct pth_message_st pth_message_t;
 struct pth_message_st { /* not hidden to allow inclusion */
@@ -526,6 +542,17 @@ extern ssize_t        pth_send_ev(int, const void *, size_t, int, pth_event_t);
 extern ssize_t        pth_recvfrom_ev(int, void *, size_t, int, struct sockaddr *, socklen_t *, pth_event_t);
 extern ssize_t        pth_sendto_ev(int, const void *, size_t, int, const struct sockaddr *, socklen_t, pth_event_t);
 
+    /* buffered I/O functions */
+extern pth_bufio_t    pth_bufio_create(int, size_t, size_t);
+extern int            pth_bufio_destroy(pth_bufio_t);
+extern size_t         pth_bufio_pending(pth_bufio_t);
+extern ssize_t        pth_bufio_peek(pth_bufio_t, size_t, const char **, pth_event_t);
+extern ssize_t        pth_bufio_peek_until(pth_bufio_t, int, const char **, pth_event_t);
+extern ssize_t        pth_bufio_peek_line(pth_bufio_t, const char **, pth_event_t);
+extern int            pth_bufio_consume(pth_bufio_t, size_t);
+extern ssize_t        pth_bufio_write(pth_bufio_t, const void *, size_t, pth_event_t);
+extern ssize_t        pth_bufio_flush(pth_bufio_t, pth_event_t);
+
     /* standard replacement functions */
 extern int            pth_nanosleep(const struct timespec *, struct timespec *);
 extern int            pth_usleep(unsigned int);
@@ -1,6 +1,9 @@
 /* pth_acdef.h.  Generated by configure.  */
 /* pth_acdef.h.in.  Generated from configure.ac by autoheader.  */
 
+/* Define to 1 if you have the `clock_gettime' function. */
+#define HAVE_CLOCK_GETTIME 1
+
 /* Define to 1 if you have the `dlclose' function. */
 #define HAVE_DLCLOSE 1
 
@@ -70,6 +73,12 @@
 /* Define to 1 if you have the <memory.h> header file. */
 #define HAVE_MEMORY_H 1
 
+/* Define to 1 if you have the `mmap' function. */
+#define HAVE_MMAP 1
+
+/* Define to 1 if you have the `mprotect' function. */
+#define HAVE_MPROTECT 1
+
 /* Define to 1 if you have the <net/errno.h> header file. */
 /* #undef HAVE_NET_ERRNO_H */
 
@@ -198,6 +207,9 @@
 /* define if pre-processor define SYS_read exists in header sys/syscall.h */
 #define HAVE_SYS_READ 1
 
+/* Define to 1 if you have the <sys/mman.h> header file. */
+#define HAVE_SYS_MMAN_H 1
+
 /* Define to 1 if you have the <sys/resource.h> header file. */
 #define HAVE_SYS_RESOURCE_H 1
 
@@ -268,13 +280,13 @@
 /* #undef PTH_EX */
 
 /* define for machine context dispatching */
-#define PTH_MCTX_DSP_use PTH_MCTX_DSP_sc
+#define PTH_MCTX_DSP_use PTH_MCTX_DSP_rsw
 
 /* define for machine context method */
-#define PTH_MCTX_MTH_use PTH_MCTX_MTH_mcsc
+#define PTH_MCTX_MTH_use PTH_MCTX_MTH_rsw
 
 /* define for machine context stack */
-#define PTH_MCTX_STK_use PTH_MCTX_STK_mc
+#define PTH_MCTX_STK_use PTH_MCTX_STK_none
 
 /* define for number of signals */
 #define PTH_NSIG 32
@@ -47,6 +47,7 @@
 #define PTH_MCTX_STK(which)  (PTH_MCTX_STK_use == (PTH_MCTX_STK_##which))
 #define PTH_MCTX_MTH_mcsc    1
 #define PTH_MCTX_MTH_sjlj    2
+#define PTH_MCTX_MTH_rsw     3
 #define PTH_MCTX_DSP_sc      1
 #define PTH_MCTX_DSP_ssjlj   2
 #define PTH_MCTX_DSP_sjlj    3
@@ -55,6 +56,7 @@
 #define PTH_MCTX_DSP_sjljlx  6
 #define PTH_MCTX_DSP_sjljisc 7
 #define PTH_MCTX_DSP_sjljw32 8
+#define PTH_MCTX_DSP_rsw     9
 #define PTH_MCTX_STK_mc      1
 #define PTH_MCTX_STK_ss      2
 #define PTH_MCTX_STK_sas     3
@@ -242,7 +242,7 @@ intern int pth_attr_ctrl(int cmd, pth_attr_t a, int op, va_list ap)
                 return pth_error(FALSE, EPERM);
             dst = va_arg(ap, pth_time_t *);
             if (a->a_tid != NULL)
-                pth_time_set(dst, &a->a_tid->lastran);
+                pth_time_clock_tod(dst, &a->a_tid->lastran);
             else
                 pth_time_set(dst, PTH_TIME_ZERO);
             break;
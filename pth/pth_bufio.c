@@ -0,0 +1,307 @@
+/*
+**  GNU Pth - The GNU Portable Threads
+**  Copyright (c) 1999-2006 Ralf S. Engelschall <rse@engelschall.com>
+**
+**  This file is part of GNU Pth, a non-preemptive thread scheduling
+**  library which can be found at http://www.gnu.org/software/pth/.
+**
+**  This library is free software; you can redistribute it and/or
+**  modify it under the terms of the GNU Lesser General Public
+**  License as published by the Free Software Foundation; either
+**  version 2.1 of the License, or (at your option) any later version.
+**
+**  This library is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+**  Lesser General Public License for more details.
+**
+**  You should have received a copy of the GNU Lesser General Public
+**  License along with this library; if not, write to the Free Software
+**  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+**  USA, or contact Ralf S. Engelschall <rse@engelschall.com>.
+**
+**  pth_bufio.c: Pth buffered connection I/O
+*/
+                             /* ``The best way to accelerate a
+                                  computer is at 9.8 m/s^2.''
+                                             -- Unknown  */
+#include "pth_p.h"
+
+/*
+ * Buffered connection I/O.
+ *
+ * The read side keeps the not yet consumed input of a filedescriptor in
+ * one buffer which is refilled with as much data as fits through a
+ * single pth_read_ev(3) call. Lines and records are handed out as
+ * pointers into this buffer (no copying) and stay valid until the next
+ * peek, consume or destroy operation. The buffer is used like a ring,
+ * but instead of wrapping around, the unconsumed rest is moved to the
+ * front when the free space at the end runs out. This keeps every view
+ * contiguous and is cheap because the rest is usually small.
+ *
+ * The write side collects small writes and sends them together with
+ * the first write which no longer fits into the buffer in a single
+ * pth_writev_ev(3) call.
+ */
+
+/* default buffer size */
+#define PTH_BUFIO_SIZE 4096
+
+/* buffered I/O structure */
+struct pth_bufio_st {
+    int     bi_fd;      /* underlying filedescriptor                  */
+    int     bi_eof;     /* end of file was read                       */
+    char   *bi_rbuf;    /* read buffer                                */
+    size_t  bi_rsize;   /* size of read buffer                        */
+    size_t  bi_rpos;    /* offset of first unconsumed byte            */
+    size_t  bi_rend;    /* offset behind last valid byte              */
+    size_t  bi_rscan;   /* bytes after bi_rpos already scanned for
+                           the delimiter of the last peek operation   */
+    char   *bi_wbuf;    /* write buffer                               */
+    size_t  bi_wsize;   /* size of write buffer                       */
+    size_t  bi_wlen;    /* number of pending bytes in write buffer    */
+};
+
+/* create a buffered I/O handle for a filedescriptor */
+pth_bufio_t pth_bufio_create(int fd, size_t rsize, size_t wsize)
+{
+    pth_bufio_t bi;
+
+    if (!pth_util_fd_valid(fd))
+        return pth_error((pth_bufio_t)NULL, EBADF);
+    if (rsize == 0)
+        rsize = PTH_BUFIO_SIZE;
+    if (wsize == 0)
+        wsize = PTH_BUFIO_SIZE;
+    if ((bi = (pth_bufio_t)malloc(sizeof(struct pth_bufio_st) + rsize + wsize)) == NULL)
+        return pth_error((pth_bufio_t)NULL, ENOMEM);
+    bi->bi_fd    = fd;
+    bi->bi_eof   = FALSE;
+    bi->bi_rbuf  = (char *)bi + sizeof(struct pth_bufio_st);
+    bi->bi_rsize = rsize;
+    bi->bi_rpos  = 0;
+    bi->bi_rend  = 0;
+    bi->bi_rscan = 0;
+    bi->bi_wbuf  = bi->bi_rbuf + rsize;
+    bi->bi_wsize = wsize;
+    bi->bi_wlen  = 0;
+    return bi;
+}
+
+/* destroy a buffered I/O handle (after flushing pending output) */
+int pth_bufio_destroy(pth_bufio_t bi)
+{
+    int rc;
+
+    if (bi == NULL)
+        return pth_error(FALSE, EINVAL);
+    rc = TRUE;
+    if (bi->bi_wlen > 0)
+        if (pth_bufio_flush(bi, NULL) < 0)
+            rc = FALSE;
+    pth_shield { free(bi); }
+    return rc;
+}
+
+/* number of buffered input bytes which can be peeked without reading */
+size_t pth_bufio_pending(pth_bufio_t bi)
+{
+    if (bi == NULL)
+        return pth_error(0, EINVAL);
+    return bi->bi_rend - bi->bi_rpos;
+}
+
+/* read more input into the buffer */
+static ssize_t pth_bufio_fill(pth_bufio_t bi, pth_event_t ev_extra)
+{
+    ssize_t n;
+
+    /* make room by moving the unconsumed rest to the front */
+    if (bi->bi_rend == bi->bi_rsize && bi->bi_rpos > 0) {
+        if (bi->bi_rend > bi->bi_rpos)
+            memmove(bi->bi_rbuf, bi->bi_rbuf + bi->bi_rpos, bi->bi_rend - bi->bi_rpos);
+        bi->bi_rend -= bi->bi_rpos;
+        bi->bi_rpos  = 0;
+    }
+    if (bi->bi_rend == bi->bi_rsize)
+        return pth_error(-1, ENOBUFS);
+    n = pth_read_ev(bi->bi_fd, bi->bi_rbuf + bi->bi_rend,
+                    bi->bi_rsize - bi->bi_rend, ev_extra);
+    if (n > 0)
+        bi->bi_rend += n;
+    else if (n == 0)
+        bi->bi_eof = TRUE;
+    return n;
+}
+
+/* peek at the input up to and including a delimiter character */
+ssize_t pth_bufio_peek_until(pth_bufio_t bi, int delim, const char **view, pth_event_t ev_extra)
+{
+    char *cp;
+    size_t len;
+
+    if (bi == NULL || view == NULL)
+        return pth_error(-1, EINVAL);
+    for (;;) {
+        /* search only the part not already scanned by a previous call */
+        len = bi->bi_rend - bi->bi_rpos;
+        if (bi->bi_rscan < len) {
+            cp = (char *)memchr(bi->bi_rbuf + bi->bi_rpos + bi->bi_rscan,
+                                delim, len - bi->bi_rscan);
+            if (cp != NULL) {
+                bi->bi_rscan = 0;
+                *view = bi->bi_rbuf + bi->bi_rpos;
+                return (cp - *view) + 1;
+            }
+            bi->bi_rscan = len;
+        }
+
+        /* an unterminated rest at end of file is handed out as it is */
+        if (bi->bi_eof) {
+            bi->bi_rscan = 0;
+            *view = bi->bi_rbuf + bi->bi_rpos;
+            return len;
+        }
+
+        /* else wait for more input */
+        if (pth_bufio_fill(bi, ev_extra) < 0)
+            return -1;
+    }
+}
+
+/* peek at the input up to and including the next newline */
+ssize_t pth_bufio_peek_line(pth_bufio_t bi, const char **view, pth_event_t ev_extra)
+{
+    return pth_bufio_peek_until(bi, '\n', view, ev_extra);
+}
+
+/* peek at a record of a fixed number of bytes */
+ssize_t pth_bufio_peek(pth_bufio_t bi, size_t nbytes, const char **view, pth_event_t ev_extra)
+{
+    if (bi == NULL || view == NULL)
+        return pth_error(-1, EINVAL);
+    if (nbytes > bi->bi_rsize)
+        return pth_error(-1, ENOBUFS);
+    while (bi->bi_rend - bi->bi_rpos < nbytes && !bi->bi_eof) {
+        /* ensure the whole record fits behind its start */
+        if (bi->bi_rpos + nbytes > bi->bi_rsize && bi->bi_rpos > 0) {
+            memmove(bi->bi_rbuf, bi->bi_rbuf + bi->bi_rpos, bi->bi_rend - bi->bi_rpos);
+            bi->bi_rend -= bi->bi_rpos;
+            bi->bi_rpos  = 0;
+        }
+        if (pth_bufio_fill(bi, ev_extra) < 0)
+            return -1;
+    }
+    *view = bi->bi_rbuf + bi->bi_rpos;
+    if (bi->bi_rend - bi->bi_rpos < nbytes)
+        return bi->bi_rend - bi->bi_rpos;
+    return nbytes;
+}
+
+/* consume input which was previously peeked at */
+int pth_bufio_consume(pth_bufio_t bi, size_t nbytes)
+{
+    if (bi == NULL)
+        return pth_error(FALSE, EINVAL);
+    if (nbytes > bi->bi_rend - bi->bi_rpos)
+        return pth_error(FALSE, EINVAL);
+    bi->bi_rpos += nbytes;
+    bi->bi_rscan = 0;
+    if (bi->bi_rpos == bi->bi_rend) {
+        /* buffer drained, so start again at the front */
+        bi->bi_rpos = 0;
+        bi->bi_rend = 0;
+    }
+    return TRUE;
+}
+
+/* write the whole I/O vector (the usual partial write loop) */
+static int pth_bufio_writeall(pth_bufio_t bi, struct iovec *iov, int iovcnt,
+                              pth_event_t ev_extra, size_t *written)
+{
+    ssize_t n;
+
+    *written = 0;
+    while (iovcnt > 0) {
+        if ((n = pth_writev_ev(bi->bi_fd, iov, iovcnt, ev_extra)) < 0)
+            return FALSE;
+        *written += n;
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return TRUE;
+}
+
+/* drop the already written part of the collected data after an error */
+static void pth_bufio_wdrop(pth_bufio_t bi, size_t written)
+{
+    if (written >= bi->bi_wlen)
+        bi->bi_wlen = 0;
+    else if (written > 0) {
+        memmove(bi->bi_wbuf, bi->bi_wbuf + written, bi->bi_wlen - written);
+        bi->bi_wlen -= written;
+    }
+    return;
+}
+
+/* buffered write */
+ssize_t pth_bufio_write(pth_bufio_t bi, const void *buf, size_t nbytes, pth_event_t ev_extra)
+{
+    struct iovec iov[2];
+    size_t written;
+    int iovcnt;
+
+    if (bi == NULL || (buf == NULL && nbytes > 0))
+        return pth_error(-1, EINVAL);
+
+    /* small writes are just collected */
+    if (bi->bi_wlen + nbytes <= bi->bi_wsize) {
+        memcpy(bi->bi_wbuf + bi->bi_wlen, buf, nbytes);
+        bi->bi_wlen += nbytes;
+        return nbytes;
+    }
+
+    /* else send the collected data and the new data at once */
+    iovcnt = 0;
+    if (bi->bi_wlen > 0) {
+        iov[iovcnt].iov_base = bi->bi_wbuf;
+        iov[iovcnt].iov_len  = bi->bi_wlen;
+        iovcnt++;
+    }
+    iov[iovcnt].iov_base = (void *)buf;
+    iov[iovcnt].iov_len  = nbytes;
+    iovcnt++;
+    if (!pth_bufio_writeall(bi, iov, iovcnt, ev_extra, &written)) {
+        pth_shield { pth_bufio_wdrop(bi, written); }
+        return -1;
+    }
+    bi->bi_wlen = 0;
+    return nbytes;
+}
+
+/* write out all collected data */
+ssize_t pth_bufio_flush(pth_bufio_t bi, pth_event_t ev_extra)
+{
+    struct iovec iov[1];
+    size_t written;
+
+    if (bi == NULL)
+        return pth_error(-1, EINVAL);
+    if (bi->bi_wlen == 0)
+        return 0;
+    iov[0].iov_base = bi->bi_wbuf;
+    iov[0].iov_len  = bi->bi_wlen;
+    if (!pth_bufio_writeall(bi, iov, 1, ev_extra, &written)) {
+        pth_shield { pth_bufio_wdrop(bi, written); }
+        return -1;
+    }
+    bi->bi_wlen = 0;
+    return written;
+}
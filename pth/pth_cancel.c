@@ -68,6 +68,7 @@ int pth_cancel(pth_t thread)
 
     /* now mark the thread as cancelled */
     thread->cancelreq = TRUE;
+    pth_sched_notify_thread(thread);
 
     /* when cancellation is enabled in async mode we cancel the thread immediately */
     if (   thread->cancelstate & PTH_CANCEL_ENABLE
@@ -84,7 +85,10 @@ int pth_cancel(pth_t thread)
             return pth_error(FALSE, ESRCH);
         if (!pth_pqueue_contains(q, thread))
             return pth_error(FALSE, ESRCH);
-        pth_pqueue_delete(q, thread);
+        if (q == &pth_WQ)
+            pth_sched_wq_delete(thread);
+        else
+            pth_pqueue_delete(q, thread);
 
         /* execute cleanups */
         pth_thread_cleanup(thread);
@@ -99,6 +103,8 @@ int pth_cancel(pth_t thread)
             thread->join_arg = PTH_CANCELED;
             thread->state = PTH_STATE_DEAD;
             pth_pqueue_insert(&pth_DQ, PTH_PRIO_STD, thread);
+            pth_sched_notify(thread);
+            pth_sched_notify(NULL);
         }
     }
     return TRUE;
@@ -52,6 +52,9 @@ struct pth_event_st {
         struct { pth_t tid; }                                       TID;
         struct { pth_event_func_t func; void *arg; pth_time_t tv; } FUNC;
     } ev_args;
+    struct pth_event_st *ev_hnext;    /* next event in scheduler's waiter hash      */
+    struct pth_event_st **ev_hprev;   /* link pointing to us in waiter hash         */
+    pth_t ev_waiter;                  /* thread waiting on us (while hashed)        */
 };
 
 #endif /* cpp */
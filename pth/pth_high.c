@@ -130,12 +130,20 @@ int pth_sigmask(int how, const sigset_t *set, sigset_t *oset)
 {
     int rv;
 
+#if PTH_MCTX_MTH(rsw)
+    /* change the real signal mask and remember it as the private
+       mask of the thread (it is lazily restored on context switches) */
+    rv = pth_sc(sigprocmask)(how, set, oset);
+    if (rv == 0 && set != NULL && pth_current != NULL)
+        pth_mctx_sigown(&pth_current->mctx);
+#else
     /* change the explicitly remembered signal mask copy for the scheduler */
     if (set != NULL)
         pth_sc(sigprocmask)(how, &(pth_current->mctx.sigs), NULL);
 
     /* change the real (per-thread saved/restored) signal mask */
     rv = pth_sc(sigprocmask)(how, set, oset);
+#endif
 
     return rv;
 }
@@ -219,6 +227,9 @@ int pth_system(const char *cmd)
     struct stat sb;
     pid_t pid;
     int pstat;
+#if PTH_MCTX_MTH(rsw)
+    int sigmode;
+#endif
 
     /* POSIX calling convention: determine whether the
        Bourne Shell ("sh") is available on this platform */
@@ -238,7 +249,12 @@ int pth_system(const char *cmd)
     /* block SIGCHLD signal */
     sigemptyset(&ss_block);
     sigaddset(&ss_block, SIGCHLD);
+#if PTH_MCTX_MTH(rsw)
+    sigmode = pth_mctx_sigmode(&pth_current->mctx);
+    pth_sigmask(SIG_BLOCK, &ss_block, &ss_old);
+#else
     pth_sc(sigprocmask)(SIG_BLOCK, &ss_block, &ss_old);
+#endif
 
     /* fork the current process */
     pstat = -1;
@@ -270,7 +286,11 @@ int pth_system(const char *cmd)
     /* restore original signal dispositions and execute the command */
     sigaction(SIGINT,  &sa_int,  NULL);
     sigaction(SIGQUIT, &sa_quit, NULL);
+#if PTH_MCTX_MTH(rsw)
+    pth_mctx_sigrevert(&pth_current->mctx, sigmode, &ss_old);
+#else
     pth_sc(sigprocmask)(SIG_SETMASK, &ss_old, NULL);
+#endif
 
     /* return error or child process result code */
     return (pid == -1 ? -1 : pstat);
@@ -430,6 +450,9 @@ int pth_pselect(int nfds, fd_set *rfds, fd_set *wfds, fd_set *efds,
     struct timeval tv;
     struct timeval *tvp;
     int rv;
+#if PTH_MCTX_MTH(rsw)
+    int sigmode;
+#endif
 
     /* convert timeout */
     if (ts != NULL) {
@@ -441,15 +464,27 @@ int pth_pselect(int nfds, fd_set *rfds, fd_set *wfds, fd_set *efds,
         tvp = NULL;
 
     /* optionally set signal mask */
-    if (mask != NULL)
+    if (mask != NULL) {
+#if PTH_MCTX_MTH(rsw)
+        sigmode = pth_mctx_sigmode(&pth_current->mctx);
+        if (pth_sigmask(SIG_SETMASK, mask, &omask) < 0)
+            return pth_error(-1, errno);
+#else
         if (pth_sc(sigprocmask)(SIG_SETMASK, mask, &omask) < 0)
             return pth_error(-1, errno);
+#endif
+    }
 
     rv = pth_select(nfds, rfds, wfds, efds, tvp);
 
     /* optionally set signal mask */
-    if (mask != NULL)
+    if (mask != NULL) {
+#if PTH_MCTX_MTH(rsw)
+        pth_shield { pth_mctx_sigrevert(&pth_current->mctx, sigmode, &omask); }
+#else
         pth_shield { pth_sc(sigprocmask)(SIG_SETMASK, &omask, NULL); }
+#endif
+    }
 
     return rv;
 }
@@ -148,6 +148,7 @@ int pth_kill(void)
     pth_initialized = FALSE;
     pth_tcb_free(pth_sched);
     pth_tcb_free(pth_main);
+    pth_tcb_cache_flush();
     pth_syscall_kill();
 #ifdef PTH_EX
     __ex_ctx       = __ex_ctx_default;
@@ -199,6 +200,38 @@ long pth_ctrl(unsigned long query, ...)
         int favournew = va_arg(ap, int);
         pth_favournew = (favournew ? 1 : 0);
     }
+    else if (query & PTH_CTRL_STACKCACHE) {
+        int max = va_arg(ap, int);
+        rc = pth_tcb_cache_limit(max);
+    }
+    else if (query & PTH_CTRL_GETTHREADSTATS) {
+        pth_t t = va_arg(ap, pth_t);
+        pth_threadstats_t *st = va_arg(ap, pth_threadstats_t *);
+        pth_time_t now;
+        if (t == NULL)
+            t = pth_current;
+        if (st == NULL)
+            rc = -1;
+        else {
+            st->ts_dispatches = (unsigned long)t->dispatches;
+            st->ts_yields     = t->yields;
+            st->ts_waits      = t->waits;
+            pth_time_set(&st->ts_running, &t->running);
+            pth_time_set(&st->ts_waiting, &t->waiting);
+            if (t == pth_current) {
+                /* include the still ongoing time slice */
+                pth_time_clock(&now);
+                pth_time_sub(&now, &t->lastran);
+                pth_time_add(&st->ts_running, &now);
+            }
+            else if (t->state == PTH_STATE_WAITING && pth_pqueue_contains(&pth_WQ, t)) {
+                /* include the still ongoing wait */
+                pth_time_clock(&now);
+                pth_time_sub(&now, &t->waitsince);
+                pth_time_add(&st->ts_waiting, &now);
+            }
+        }
+    }
     else
         rc = -1;
     va_end(ap);
@@ -226,7 +259,6 @@ pth_t pth_spawn(pth_attr_t attr, void *(*func)(void *), void *arg)
     pth_t t;
     unsigned int stacksize;
     void *stackaddr;
-    pth_time_t ts;
 
     pth_debug1("pth_spawn: enter");
 
@@ -274,13 +306,17 @@ pth_t pth_spawn(pth_attr_t attr, void *(*func)(void *), void *arg)
     }
 
     /* initialize the time points and ranges */
-    pth_time_set(&ts, PTH_TIME_NOW);
-    pth_time_set(&t->spawned, &ts);
-    pth_time_set(&t->lastran, &ts);
+    pth_time_set(&t->spawned, PTH_TIME_NOW);
+    pth_time_clock(&t->lastran);
     pth_time_set(&t->running, PTH_TIME_ZERO);
+    pth_time_set(&t->waiting, PTH_TIME_ZERO);
+    t->yields = 0;
+    t->waits  = 0;
 
     /* initialize events */
-    t->events = NULL;
+    t->events     = NULL;
+    t->wq_listed  = FALSE;
+    t->wq_passive = FALSE;
 
     /* clear raised signals */
     sigemptyset(&t->sigpending);
@@ -317,6 +353,8 @@ pth_t pth_spawn(pth_attr_t attr, void *(*func)(void *), void *arg)
             return pth_error((pth_t)NULL, errno);
         }
     }
+    else
+        pth_mctx_adopt(&t->mctx);
 
     /* finally insert it into the "new queue" where
        the scheduler will pick it up for dispatching */
@@ -548,7 +586,10 @@ int pth_suspend(pth_t t)
         return pth_error(FALSE, EPERM);
     if (!pth_pqueue_contains(q, t))
         return pth_error(FALSE, ESRCH);
-    pth_pqueue_delete(q, t);
+    if (q == &pth_WQ)
+        pth_sched_wq_delete(t);
+    else
+        pth_pqueue_delete(q, t);
     pth_pqueue_insert(&pth_SQ, PTH_PRIO_STD, t);
     pth_debug2("pth_suspend: suspend thread \"%s\"\n", t->name);
     return TRUE;
@@ -572,7 +613,10 @@ int pth_resume(pth_t t)
         case PTH_STATE_WAITING: q = &pth_WQ; break;
         default:                q = NULL;
     }
-    pth_pqueue_insert(q, PTH_PRIO_STD, t);
+    if (q == &pth_WQ)
+        pth_sched_wq_insert(t, PTH_PRIO_STD);
+    else
+        pth_pqueue_insert(q, PTH_PRIO_STD, t);
     pth_debug2("pth_resume: resume thread \"%s\"\n", t->name);
     return TRUE;
 }
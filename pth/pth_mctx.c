@@ -36,7 +36,10 @@
  * pointer and (usually) the signals mask is stored. When the
  * signal mask cannot be implicitly stored in `jb', it's
  * alternatively stored explicitly in `sigs'. The `error' stores
- * the value of `errno'.
+ * the value of `errno'. With the register switch method the
+ * callee-saved registers are pushed onto the stack of the context
+ * and only the stack pointer is stored in `sp'. The `sigmode'
+ * then tells whether the context owns a private signal mask in `sigs'.
  */
 
 #if PTH_MCTX_MTH(mcsc)
@@ -50,6 +53,9 @@ struct pth_mctx_st {
     int restored;
 #elif PTH_MCTX_MTH(sjlj)
     pth_sigjmpbuf jb;
+#elif PTH_MCTX_MTH(rsw)
+    void *sp;
+    int sigmode;
 #else
 #error "unknown mctx method"
 #endif
@@ -60,6 +66,17 @@ struct pth_mctx_st {
     int error;
 };
 
+/*
+ * signal mask modes of a context (register switch method only)
+ */
+#if PTH_MCTX_MTH(rsw)
+#define PTH_MCTX_SIG_DEFAULT 0 /* runs with the process default mask  */
+#define PTH_MCTX_SIG_OWN     1 /* runs with its private mask in `sigs' */
+#define PTH_MCTX_SIG_ANY     2 /* runs with whatever mask is installed */
+extern void __pth_mctx_rsw(void **, void *);
+#define pth_mctx_rsw __pth_mctx_rsw
+#endif
+
 /*
 ** ____ MACHINE STATE SWITCHING ______________________________________
 */
@@ -82,10 +99,69 @@ struct pth_mctx_st {
 #define pth_mctx_save(mctx) \
         ( (mctx)->error = errno, \
           pth_sigsetjmp((mctx)->jb) )
+#elif PTH_MCTX_MTH(rsw)
+/* not applicable: a context is only saved as part of a switch */
 #else
 #error "unknown mctx method"
 #endif
 
+/*
+ * lazily install the signal mask a context wants to run with
+ * (register switch method only). The process signal mask is
+ * changed only if the context owns a private mask different from
+ * the installed one, or if it wants the default mask and a private
+ * one is still installed. Threads which never called pth_sigmask(3)
+ * therefore switch without any system call.
+ */
+#if PTH_MCTX_MTH(rsw)
+#define pth_mctx_sigswitch(mctx) \
+    if ((mctx)->sigmode == PTH_MCTX_SIG_OWN) { \
+        if (pth_mctx_sigowner != (mctx)) { \
+            pth_sc(sigprocmask)(SIG_SETMASK, &((mctx)->sigs), NULL); \
+            pth_mctx_sigowner = (mctx); \
+        } \
+    } \
+    else if ((mctx)->sigmode == PTH_MCTX_SIG_DEFAULT) { \
+        if (pth_mctx_sigowner != NULL) { \
+            pth_sc(sigprocmask)(SIG_SETMASK, &pth_mctx_sigdefault, NULL); \
+            pth_mctx_sigowner = NULL; \
+        } \
+    }
+#define pth_mctx_sigown(mctx) \
+    do { \
+        pth_sc(sigprocmask)(SIG_SETMASK, NULL, &((mctx)->sigs)); \
+        (mctx)->sigmode = PTH_MCTX_SIG_OWN; \
+        pth_mctx_sigowner = (mctx); \
+    } while (0)
+#define pth_mctx_sigany(mctx) \
+    (mctx)->sigmode = PTH_MCTX_SIG_ANY
+#define pth_mctx_sigblocked(mctx) \
+    do { \
+        sigset_t __ss; \
+        sigfillset(&__ss); \
+        pth_sc(sigprocmask)(SIG_SETMASK, &__ss, NULL); \
+        pth_mctx_sigowner = (mctx); \
+    } while (0)
+/*
+ * a mask a thread installs only temporarily, e.g. while it waits, is
+ * made its private mask via pth_sigmask(3) so that it is not left
+ * installed for the other threads. Afterwards the previous mask and
+ * mode (saved with pth_mctx_sigmode) are reinstalled.
+ */
+#define pth_mctx_sigmode(mctx) \
+    ((mctx)->sigmode)
+#define pth_mctx_sigrevert(mctx,mode,set) \
+    do { \
+        pth_sc(sigprocmask)(SIG_SETMASK, (set), NULL); \
+        if ((mode) == PTH_MCTX_SIG_OWN) \
+            pth_mctx_sigown(mctx); \
+        else { \
+            (mctx)->sigmode = (mode); \
+            pth_mctx_sigowner = NULL; \
+        } \
+    } while (0)
+#endif
+
 /*
  * restore the current machine context
  * (at the location of the old context)
@@ -99,6 +175,14 @@ struct pth_mctx_st {
 #define pth_mctx_restore(mctx) \
         ( errno = (mctx)->error, \
           (void)pth_siglongjmp((mctx)->jb, 1) )
+#elif PTH_MCTX_MTH(rsw)
+#define pth_mctx_restore(mctx) \
+    do { \
+        void *__sp; \
+        pth_mctx_sigswitch(mctx) \
+        errno = (mctx)->error; \
+        pth_mctx_rsw(&__sp, (mctx)->sp); \
+    } while (0)
 #else
 #error "unknown mctx method"
 #endif
@@ -135,12 +219,45 @@ struct pth_mctx_st {
     if (pth_mctx_save(old) == 0) \
         pth_mctx_restore(new); \
     pth_mctx_restored(old);
+#elif PTH_MCTX_MTH(rsw)
+#define pth_mctx_switch(old,new) \
+    _pth_mctx_switch_debug \
+    do { \
+        pth_mctx_t *__old = (old); \
+        pth_mctx_sigswitch(new) \
+        __old->error = errno; \
+        pth_mctx_rsw(&(__old->sp), (new)->sp); \
+        errno = __old->error; \
+    } while (0);
 #else
 #error "unknown mctx method"
 #endif
 
+/*
+ * initialize the machine context of the main thread,
+ * i.e. of the context which is already running on the process stack
+ */
+#if PTH_MCTX_MTH(rsw)
+#define pth_mctx_adopt(mctx) \
+    do { \
+        pth_sc(sigprocmask)(SIG_SETMASK, NULL, &pth_mctx_sigdefault); \
+        pth_mctx_sigowner = NULL; \
+        (mctx)->sigs = pth_mctx_sigdefault; \
+        (mctx)->sigmode = PTH_MCTX_SIG_DEFAULT; \
+        (mctx)->error = 0; \
+    } while (0)
+#else
+#define pth_mctx_adopt(mctx) \
+    /*nop*/
+#endif
+
 #endif /* cpp */
 
+#if PTH_MCTX_MTH(rsw)
+intern sigset_t    pth_mctx_sigdefault;  /* signal mask of contexts without a private one */
+intern pth_mctx_t *pth_mctx_sigowner;    /* context whose private mask is installed       */
+#endif
+
 /*
 ** ____ MACHINE STATE INITIALIZATION ________________________________
 */
@@ -535,6 +652,142 @@ pth_mctx_set(pth_mctx_t *mctx, void (*func)(void),
     return TRUE;
 }
 
+/*
+ * VARIANT 6: HAND-WRITTEN REGISTER SWITCH
+ *
+ * This avoids the sigprocmask(2) system call swapcontext(3) performs
+ * on every switch. Only the callee-saved registers (plus the floating
+ * point control state) have to survive a switch, because it always
+ * happens through an ordinary function call. So __pth_mctx_rsw() pushes
+ * them onto the current stack, stores the stack pointer, loads the new
+ * one and pops the registers of the other context again. A fresh context
+ * is prepared by building such a register frame by hand on its stack,
+ * with the start function as the return address. Signal masks are not
+ * part of the context; instead they are switched lazily (see
+ * pth_mctx_sigswitch above) and only for threads which changed their
+ * mask via pth_sigmask(3).
+ */
+
+#elif PTH_MCTX_MTH(rsw)
+
+#if defined(__x86_64__)
+__asm__ (
+    ".text\n"
+    ".p2align 4\n"
+    ".globl __pth_mctx_rsw\n"
+#if defined(__ELF__)
+    ".hidden __pth_mctx_rsw\n"
+    ".type __pth_mctx_rsw,@function\n"
+#endif
+    "__pth_mctx_rsw:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+#if defined(__ELF__)
+    ".size __pth_mctx_rsw,.-__pth_mctx_rsw\n"
+#endif
+);
+#elif defined(__aarch64__)
+__asm__ (
+    ".text\n"
+    ".p2align 4\n"
+    ".globl __pth_mctx_rsw\n"
+#if defined(__ELF__)
+    ".hidden __pth_mctx_rsw\n"
+    ".type __pth_mctx_rsw,%function\n"
+#endif
+    "__pth_mctx_rsw:\n"
+    "    sub sp, sp, #176\n"
+    "    stp x19, x20, [sp, #0]\n"
+    "    stp x21, x22, [sp, #16]\n"
+    "    stp x23, x24, [sp, #32]\n"
+    "    stp x25, x26, [sp, #48]\n"
+    "    stp x27, x28, [sp, #64]\n"
+    "    stp x29, x30, [sp, #80]\n"
+    "    stp d8,  d9,  [sp, #96]\n"
+    "    stp d10, d11, [sp, #112]\n"
+    "    stp d12, d13, [sp, #128]\n"
+    "    stp d14, d15, [sp, #144]\n"
+    "    mrs x9, fpcr\n"
+    "    str x9, [sp, #160]\n"
+    "    mov x9, sp\n"
+    "    str x9, [x0]\n"
+    "    mov sp, x1\n"
+    "    ldr x9, [sp, #160]\n"
+    "    msr fpcr, x9\n"
+    "    ldp d14, d15, [sp, #144]\n"
+    "    ldp d12, d13, [sp, #128]\n"
+    "    ldp d10, d11, [sp, #112]\n"
+    "    ldp d8,  d9,  [sp, #96]\n"
+    "    ldp x29, x30, [sp, #80]\n"
+    "    ldp x27, x28, [sp, #64]\n"
+    "    ldp x25, x26, [sp, #48]\n"
+    "    ldp x23, x24, [sp, #32]\n"
+    "    ldp x21, x22, [sp, #16]\n"
+    "    ldp x19, x20, [sp, #0]\n"
+    "    add sp, sp, #176\n"
+    "    ret\n"
+#if defined(__ELF__)
+    ".size __pth_mctx_rsw,.-__pth_mctx_rsw\n"
+#endif
+);
+#else
+#error "Unsupported platform for the register switch method"
+#endif
+
+intern int pth_mctx_set(
+    pth_mctx_t *mctx, void (*func)(void), char *sk_addr_lo, char *sk_addr_hi)
+{
+    unsigned long *sp;
+
+    /* start with a 16 byte aligned stack top */
+    sp = (unsigned long *)((unsigned long)sk_addr_hi & ~((unsigned long)15));
+#if defined(__x86_64__)
+    /* [mxcsr/fpucw] [r15] [r14] [r13] [r12] [rbx] [rbp] [func] [0] */
+    *--sp = 0;                     /* return address of func (never used) */
+    *--sp = (unsigned long)func;   /* return address of __pth_mctx_rsw   */
+    sp -= 6;
+    memset(sp, 0, 6*sizeof(unsigned long));
+    *--sp = ((unsigned long)0x037F << 32) | 0x1F80; /* default fpucw and mxcsr */
+#elif defined(__aarch64__)
+    /* [x19-x28] [x29] [x30=func] [d8-d15] [fpcr] [pad] */
+    sp -= 22;
+    memset(sp, 0, 22*sizeof(unsigned long));
+    sp[11] = (unsigned long)func;
+#endif
+    mctx->sp    = (void *)sp;
+    mctx->error = 0;
+
+    /* inherit the signal mask of the creating context */
+    if (pth_mctx_sigowner != NULL) {
+        mctx->sigs    = pth_mctx_sigowner->sigs;
+        mctx->sigmode = PTH_MCTX_SIG_OWN;
+    }
+    else {
+        mctx->sigs    = pth_mctx_sigdefault;
+        mctx->sigmode = PTH_MCTX_SIG_DEFAULT;
+    }
+    return TRUE;
+}
+
 /*
  * VARIANT X: JMP_BUF FIDDLING FOR ONE MORE ESOTERIC OS
  * Add the jmp_buf fiddling for your esoteric OS here...
@@ -123,6 +123,7 @@ int pth_msgport_put(pth_msgport_t mp, pth_message_t *m)
     if (mp == NULL)
         return pth_error(FALSE, EINVAL);
     pth_ring_append(&mp->mp_queue, (pth_ringnode_t *)m);
+    pth_sched_notify(mp);
     return TRUE;
 }
 
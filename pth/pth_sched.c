@@ -47,9 +47,33 @@ static sigset_t     pth_sigraised;  /* mask of raised signals                */
 static pth_time_t   pth_loadticknext;
 static pth_time_t   pth_loadtickgap = PTH_TIME(1,0);
 
+/*
+ * Event manager bookkeeping.
+ *
+ * Threads waiting only for events whose sources know when they change
+ * (message arrival, mutex release, condition signal, thread termination)
+ * are "passive": their events are hashed by the object they wait on and
+ * the thread is checked by the event manager only after its source
+ * called pth_sched_notify(). All other waiting threads (I/O, signals,
+ * timers, custom functions) are "active" and stay on the check list as
+ * long as they are in the waiting queue. So the per-iteration cost of the
+ * event manager no longer grows with the number of idle waiters.
+ */
+#define PTH_SCHED_WAITHASH 64
+#define pth_sched_waithash_idx(obj) \
+    ((unsigned int)(((unsigned long)(obj) >> 4) % PTH_SCHED_WAITHASH))
+
+static pth_t        pth_wq_head;    /* check list of the event manager       */
+static pth_t        pth_wq_tail;
+static pth_event_t  pth_waithash[PTH_SCHED_WAITHASH];
+static int          pth_wq_sigunblock[1+PTH_NSIG]; /* waiters not blocking sig */
+
 /* initialize the scheduler ingredients */
 intern int pth_scheduler_init(void)
 {
+    /* initialize the clock for time accounting */
+    pth_time_clock_init();
+
     /* create the internal signal pipe */
     if (pipe(pth_sigpipe) == -1)
         return pth_error(FALSE, errno);
@@ -69,12 +93,18 @@ intern int pth_scheduler_init(void)
     pth_pqueue_init(&pth_SQ);
     pth_pqueue_init(&pth_DQ);
 
+    /* initialize the event manager bookkeeping */
+    pth_wq_head = NULL;
+    pth_wq_tail = NULL;
+    memset(pth_waithash, 0, sizeof(pth_waithash));
+    memset(pth_wq_sigunblock, 0, sizeof(pth_wq_sigunblock));
+
     /* initialize scheduling hints */
     pth_favournew = 1; /* the default is the original behaviour */
 
     /* initialize load support */
     pth_loadval = 1.0;
-    pth_time_set(&pth_loadticknext, PTH_TIME_NOW);
+    pth_time_clock(&pth_loadticknext);
 
     return TRUE;
 }
@@ -95,8 +125,10 @@ intern void pth_scheduler_drop(void)
     pth_pqueue_init(&pth_RQ);
 
     /* clear the waiting queue */
-    while ((t = pth_pqueue_delmax(&pth_WQ)) != NULL)
+    while ((t = pth_pqueue_head(&pth_WQ)) != NULL) {
+        pth_sched_wq_delete(t);
         pth_tcb_free(t);
+    }
     pth_pqueue_init(&pth_WQ);
 
     /* clear the suspend queue */
@@ -123,6 +155,153 @@ intern void pth_scheduler_kill(void)
     return;
 }
 
+/* append a waiting thread to the check list of the event manager */
+static void pth_sched_wq_list(pth_t t)
+{
+    if (t->wq_listed)
+        return;
+    t->wq_next = NULL;
+    t->wq_prev = pth_wq_tail;
+    if (pth_wq_tail != NULL)
+        pth_wq_tail->wq_next = t;
+    else
+        pth_wq_head = t;
+    pth_wq_tail = t;
+    t->wq_listed = TRUE;
+    return;
+}
+
+/* remove a waiting thread from the check list of the event manager */
+static void pth_sched_wq_unlist(pth_t t)
+{
+    if (!t->wq_listed)
+        return;
+    if (t->wq_prev != NULL)
+        t->wq_prev->wq_next = t->wq_next;
+    else
+        pth_wq_head = t->wq_next;
+    if (t->wq_next != NULL)
+        t->wq_next->wq_prev = t->wq_prev;
+    else
+        pth_wq_tail = t->wq_prev;
+    t->wq_listed = FALSE;
+    return;
+}
+
+/* determine the object a passive event waits on (FALSE if it is active) */
+static int pth_sched_waitobj(pth_event_t ev, void **obj)
+{
+    switch (ev->ev_type) {
+        case PTH_EVENT_MSG:   *obj = ev->ev_args.MSG.mp;      return TRUE;
+        case PTH_EVENT_MUTEX: *obj = ev->ev_args.MUTEX.mutex; return TRUE;
+        case PTH_EVENT_COND:  *obj = ev->ev_args.COND.cond;   return TRUE;
+        case PTH_EVENT_TID:
+            /* only termination is notified, other states are polled */
+            if (ev->ev_args.TID.tid != NULL && ev->ev_goal != PTH_STATE_DEAD)
+                return FALSE;
+            *obj = ev->ev_args.TID.tid;
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+/* insert a thread into the waiting queue */
+intern void pth_sched_wq_insert(pth_t t, int prio)
+{
+    pth_event_t ev, evh;
+    void *obj;
+    int sig;
+    int i;
+
+    pth_pqueue_insert(&pth_WQ, prio, t);
+    pth_time_clock(&t->waitsince);
+
+    /* account the signals the thread does not block */
+    for (sig = 1; sig < PTH_NSIG; sig++)
+        if (!sigismember(&(t->mctx.sigs), sig))
+            pth_wq_sigunblock[sig]++;
+
+    /* classify the event ring */
+    t->wq_passive = (t->events != NULL);
+    if ((ev = evh = t->events) != NULL) {
+        do {
+            if (!pth_sched_waitobj(ev, &obj)) {
+                t->wq_passive = FALSE;
+                break;
+            }
+        } while ((ev = ev->ev_next) != evh);
+    }
+
+    /* hash the events of passive waiters by the object they wait on */
+    if (t->wq_passive) {
+        ev = evh = t->events;
+        do {
+            pth_sched_waitobj(ev, &obj);
+            i = pth_sched_waithash_idx(obj);
+            ev->ev_waiter = t;
+            ev->ev_hprev  = &pth_waithash[i];
+            ev->ev_hnext  = pth_waithash[i];
+            if (ev->ev_hnext != NULL)
+                ev->ev_hnext->ev_hprev = &ev->ev_hnext;
+            pth_waithash[i] = ev;
+        } while ((ev = ev->ev_next) != evh);
+    }
+
+    /* every thread is checked at least once, because the
+       condition it waits for might already be fulfilled */
+    pth_sched_wq_list(t);
+    return;
+}
+
+/* delete a thread from the waiting queue */
+intern void pth_sched_wq_delete(pth_t t)
+{
+    pth_event_t ev, evh;
+    pth_time_t waited;
+    int sig;
+
+    pth_pqueue_delete(&pth_WQ, t);
+    pth_sched_wq_unlist(t);
+    pth_time_clock(&waited);
+    pth_time_sub(&waited, &t->waitsince);
+    pth_time_add(&t->waiting, &waited);
+    for (sig = 1; sig < PTH_NSIG; sig++)
+        if (!sigismember(&(t->mctx.sigs), sig))
+            pth_wq_sigunblock[sig]--;
+    if (t->wq_passive) {
+        ev = evh = t->events;
+        do {
+            *(ev->ev_hprev) = ev->ev_hnext;
+            if (ev->ev_hnext != NULL)
+                ev->ev_hnext->ev_hprev = ev->ev_hprev;
+            ev->ev_waiter = NULL;
+        } while ((ev = ev->ev_next) != evh);
+        t->wq_passive = FALSE;
+    }
+    return;
+}
+
+/* let the event manager check the passive waiters on an object */
+intern void pth_sched_notify(void *obj)
+{
+    pth_event_t ev;
+    void *evobj;
+
+    for (ev = pth_waithash[pth_sched_waithash_idx(obj)]; ev != NULL; ev = ev->ev_hnext)
+        if (pth_sched_waitobj(ev, &evobj) && evobj == obj)
+            pth_sched_wq_list(ev->ev_waiter);
+    return;
+}
+
+/* let the event manager check a particular waiting thread */
+intern void pth_sched_notify_thread(pth_t t)
+{
+    if (t->state == PTH_STATE_WAITING && pth_pqueue_contains(&pth_WQ, t))
+        pth_sched_wq_list(t);
+    return;
+}
+
 /*
  * Update the average scheduler load.
  *
@@ -155,7 +334,6 @@ intern void pth_scheduler_kill(void)
 /* the heart of this library: the thread scheduler */
 intern void *pth_scheduler(void *dummy)
 {
-    sigset_t sigs;
     pth_time_t running;
     pth_time_t snapshot;
     struct sigaction sa;
@@ -171,12 +349,33 @@ intern void *pth_scheduler(void *dummy)
     /* mark this thread as the special scheduler thread */
     pth_sched->state = PTH_STATE_SCHEDULER;
 
+#if PTH_MCTX_MTH(rsw)
+    /* the scheduler thread does NOT block all signals: it has no signal
+       mask of its own and runs with the one of the last dispatched
+       thread, because installing a full mask on every entry and the
+       thread's mask again on every exit would cost two sigprocmask(2)
+       calls per switch. So process signals the last thread did not
+       block may be delivered to their handlers while the scheduler
+       updates its queues. This is safe because the queues are never
+       touched from signal context: the Pth handlers only record a
+       signal and are installed just while the scheduler waits in the
+       event manager or in pth_util_sigdelete(), and application
+       handlers must not call Pth functions anyway (they are not
+       asynchronous-safe, see pth(3)). Where the delivery point matters,
+       signals are blocked explicitly: before raising thread-specific
+       signals (below) and around the event manager's select(2). */
+    pth_mctx_sigany(&pth_sched->mctx);
+#else
     /* block all signals in the scheduler thread */
-    sigfillset(&sigs);
-    pth_sc(sigprocmask)(SIG_SETMASK, &sigs, NULL);
+    {
+        sigset_t sigs;
+        sigfillset(&sigs);
+        pth_sc(sigprocmask)(SIG_SETMASK, &sigs, NULL);
+    }
+#endif
 
     /* initialize the snapshot time for bootstrapping the loop */
-    pth_time_set(&snapshot, PTH_TIME_NOW);
+    pth_time_clock(&snapshot);
 
     /*
      * endless scheduler loop
@@ -224,6 +423,10 @@ intern void *pth_scheduler(void *dummy)
          *     process new pending:                      --######
          */
         if (pth_current->sigpendcnt > 0) {
+#if PTH_MCTX_MTH(rsw)
+            /* hold back delivery until we have switched to the thread */
+            pth_mctx_sigblocked(&pth_sched->mctx);
+#endif
             sigpending(&pth_sigpending);
             for (sig = 1; sig < PTH_NSIG; sig++)
                 if (sigismember(&pth_current->sigpending, sig))
@@ -239,7 +442,7 @@ intern void *pth_scheduler(void *dummy)
                    (unsigned long)pth_current, pth_current->name);
 
         /* update thread times */
-        pth_time_set(&pth_current->lastran, PTH_TIME_NOW);
+        pth_time_clock(&pth_current->lastran);
 
         /* update scheduler times */
         pth_time_set(&running, &pth_current->lastran);
@@ -251,7 +454,7 @@ intern void *pth_scheduler(void *dummy)
         pth_mctx_switch(&pth_sched->mctx, &pth_current->mctx);
 
         /* update scheduler times */
-        pth_time_set(&snapshot, PTH_TIME_NOW);
+        pth_time_clock(&snapshot);
         pth_debug3("pth_scheduler: cameback from thread 0x%lx (\"%s\")",
                    (unsigned long)pth_current, pth_current->name);
 
@@ -333,8 +536,11 @@ intern void *pth_scheduler(void *dummy)
             pth_debug2("pth_scheduler: marking thread \"%s\" as dead", pth_current->name);
             if (!pth_current->joinable)
                 pth_tcb_free(pth_current);
-            else
+            else {
                 pth_pqueue_insert(&pth_DQ, PTH_PRIO_STD, pth_current);
+                pth_sched_notify(pth_current);
+                pth_sched_notify(NULL);
+            }
             pth_current = NULL;
         }
 
@@ -345,7 +551,8 @@ intern void *pth_scheduler(void *dummy)
         if (pth_current != NULL && pth_current->state == PTH_STATE_WAITING) {
             pth_debug2("pth_scheduler: moving thread \"%s\" to waiting queue",
                        pth_current->name);
-            pth_pqueue_insert(&pth_WQ, pth_current->prio, pth_current);
+            pth_current->waits++;
+            pth_sched_wq_insert(pth_current, pth_current->prio);
             pth_current = NULL;
         }
 
@@ -355,8 +562,10 @@ intern void *pth_scheduler(void *dummy)
          * thread back into this queue, too.
          */
         pth_pqueue_increase(&pth_RQ);
-        if (pth_current != NULL)
+        if (pth_current != NULL) {
+            pth_current->yields++;
             pth_pqueue_insert(&pth_RQ, pth_current->prio, pth_current);
+        }
 
         /*
          * Manage the events in the waiting queue, i.e. decide whether their
@@ -366,10 +575,10 @@ intern void *pth_scheduler(void *dummy)
         if (   pth_pqueue_elements(&pth_RQ) == 0
             && pth_pqueue_elements(&pth_NQ) == 0)
             /* still no NEW or READY threads, so we have to wait for new work */
-            pth_sched_eventmanager(&snapshot, FALSE /* wait */);
+            pth_sched_eventmanager(FALSE /* wait */);
         else
             /* already NEW or READY threads exists, so just poll for even more work */
-            pth_sched_eventmanager(&snapshot, TRUE  /* poll */);
+            pth_sched_eventmanager(TRUE  /* poll */);
     }
 
     /* NOTREACHED */
@@ -379,9 +588,17 @@ intern void *pth_scheduler(void *dummy)
 /*
  * Look whether some events already occurred (or failed) and move
  * corresponding threads from waiting queue back to ready queue.
+ * The time of day is only fetched when timers have to be checked.
  */
-intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
+#define pth_sched_eventmanager_now() \
+    if (!havenow) { \
+        pth_time_set(&now, PTH_TIME_NOW); \
+        havenow = TRUE; \
+    }
+intern void pth_sched_eventmanager(int dopoll)
 {
+    pth_time_t now;
+    int havenow;
     pth_t nexttimer_thread;
     pth_event_t nexttimer_ev;
     pth_time_t nexttimer_value;
@@ -412,6 +629,7 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
     /* entry point for internal looping in event handling */
     loop_entry:
     loop_repeat = FALSE;
+    havenow = FALSE;
 
     /* initialize fd sets */
     FD_ZERO(&rfds);
@@ -430,15 +648,15 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
     nexttimer_thread = NULL;
     nexttimer_ev = NULL;
 
-    /* for all threads in the waiting queue... */
-    any_occurred = FALSE;
-    for (t = pth_pqueue_head(&pth_WQ); t != NULL;
-         t = pth_pqueue_walk(&pth_WQ, t, PTH_WALK_NEXT)) {
+    /* determine signals we block, i.e. those
+       all threads in the waiting queue block */
+    for (sig = 1; sig < PTH_NSIG; sig++)
+        if (pth_wq_sigunblock[sig] > 0)
+            sigdelset(&pth_sigblock, sig);
 
-        /* determine signals we block */
-        for (sig = 1; sig < PTH_NSIG; sig++)
-            if (!sigismember(&(t->mctx.sigs), sig))
-                sigdelset(&pth_sigblock, sig);
+    /* for all threads in the waiting queue which have to be checked... */
+    any_occurred = FALSE;
+    for (t = pth_wq_head; t != NULL; t = t->wq_next) {
 
         /* cancellation support */
         if (t->cancelreq == TRUE)
@@ -505,7 +723,8 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
                 }
                 /* Timer */
                 else if (ev->ev_type == PTH_EVENT_TIME) {
-                    if (pth_time_cmp(&(ev->ev_args.TIME.tv), now) < 0)
+                    pth_sched_eventmanager_now();
+                    if (pth_time_cmp(&(ev->ev_args.TIME.tv), &now) < 0)
                         this_occurred = TRUE;
                     else {
                         /* remember the timer which will be elapsed next */
@@ -554,7 +773,8 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
                         this_occurred = TRUE;
                     else {
                         pth_time_t tv;
-                        pth_time_set(&tv, now);
+                        pth_sched_eventmanager_now();
+                        pth_time_set(&tv, &now);
                         pth_time_add(&tv, &(ev->ev_args.FUNC.tv));
                         if ((nexttimer_thread == NULL && nexttimer_ev == NULL) ||
                             pth_time_cmp(&tv, &nexttimer_value) < 0) {
@@ -587,8 +807,9 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
     else if (nexttimer_ev != NULL) {
         /* do a polling with a timeout set to the next timer,
            i.e. wait for the fd sets or the next timer */
+        pth_sched_eventmanager_now();
         pth_time_set(&delay, &nexttimer_value);
-        pth_time_sub(&delay, now);
+        pth_time_sub(&delay, &now);
         pdelay = &delay;
     }
     else {
@@ -664,8 +885,8 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
        additionally if a thread has one occurred event, we move it from the
        waiting queue to the ready queue */
 
-    /* for all threads in the waiting queue... */
-    t = pth_pqueue_head(&pth_WQ);
+    /* for all threads in the waiting queue which have to be checked... */
+    t = pth_wq_head;
     while (t != NULL) {
 
         /* do the late handling of the fd I/O and signal
@@ -808,9 +1029,9 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
             any_occurred = TRUE;
         }
 
-        /* walk to next thread in waiting queue */
+        /* walk to next thread on the check list */
         tlast = t;
-        t = pth_pqueue_walk(&pth_WQ, t, PTH_WALK_NEXT);
+        t = t->wq_next;
 
         /*
          * move last thread to ready queue if any events occurred for it.
@@ -821,19 +1042,21 @@ intern void pth_sched_eventmanager(pth_time_t *now, int dopoll)
          * a chance.
          */
         if (any_occurred) {
-            pth_pqueue_delete(&pth_WQ, tlast);
+            pth_sched_wq_delete(tlast);
             tlast->state = PTH_STATE_READY;
             pth_pqueue_insert(&pth_RQ, tlast->prio+1, tlast);
             pth_debug2("pth_sched_eventmanager: thread \"%s\" moved from waiting "
                        "to ready queue", tlast->name);
         }
+        else if (tlast->wq_passive) {
+            /* nothing to do until the source of an event notifies us */
+            pth_sched_wq_unlist(tlast);
+        }
     }
 
     /* perhaps we have to internally loop... */
-    if (loop_repeat) {
-        pth_time_set(now, PTH_TIME_NOW);
+    if (loop_repeat)
         goto loop_entry;
-    }
 
     pth_debug1("pth_sched_eventmanager: leaving");
     return;
@@ -121,6 +121,7 @@ int pth_mutex_release(pth_mutex_t *mutex)
         mutex->mx_owner = NULL;
         mutex->mx_count = 0;
         pth_ring_delete(&(pth_current->mutexring), &(mutex->mx_node));
+        pth_sched_notify(mutex);
     }
     return TRUE;
 }
@@ -315,6 +316,7 @@ int pth_cond_notify(pth_cond_t *cond, int broadcast)
         else
             cond->cn_state &= ~(PTH_COND_BROADCAST);
         cond->cn_state &= ~(PTH_COND_HANDLED);
+        pth_sched_notify(cond);
 
         /* and give other threads a chance to awake */
         pth_yield(NULL);
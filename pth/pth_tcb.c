@@ -45,11 +45,19 @@ struct pth_st {
 
     /* timing */
     pth_time_t     spawned;              /* time point at which thread was spawned      */
-    pth_time_t     lastran;              /* time point at which thread was last running */
+    pth_time_t     lastran;              /* scheduler clock time of the last dispatch   */
     pth_time_t     running;              /* time range the thread was already running   */
+    pth_time_t     waitsince;            /* time point at which thread started to wait  */
+    pth_time_t     waiting;              /* time range the thread was already waiting   */
+    unsigned long  yields;               /* number of switches leaving thread ready     */
+    unsigned long  waits;                /* number of switches to wait for events       */
 
     /* event handling */
     pth_event_t    events;               /* events the tread is waiting for             */
+    pth_t          wq_next;              /* next thread on event manager check list     */
+    pth_t          wq_prev;              /* previous thread on event manager check list */
+    int            wq_listed;            /* whether thread is on the check list         */
+    int            wq_passive;           /* whether all events are notified by sources  */
 
     /* per-thread signal handling */
     sigset_t       sigpending;           /* set    of pending signals                   */
@@ -61,6 +69,9 @@ struct pth_st {
     unsigned int   stacksize;            /* size of thread stack                        */
     long          *stackguard;           /* stack overflow guard                        */
     int            stackloan;            /* stack type                                  */
+    char          *stackmap;             /* base of mmap(2)'ed stack region (or NULL)   */
+    size_t         stackmaplen;          /* length of mmap(2)'ed stack region           */
+    unsigned int   cachekey;             /* requested stack size (cache slot key)       */
     void        *(*start_func)(void *);  /* start routine                               */
     void          *start_arg;            /* start argument                              */
 
@@ -99,24 +110,194 @@ intern const char *pth_state_names[] = {
 #define SIGSTKSZ 8192
 #endif
 
+/*
+ * Thread control block and stack cache.
+ *
+ * Spawning and reaping threads at a high rate (e.g. one thread per
+ * accepted connection) makes the allocation of stacks and the page faults
+ * on their first touch a significant cost. So dead threads are not
+ * released immediately, but their control block (together with the still
+ * attached stack) is kept on a free list per stack size. A subsequent
+ * pth_tcb_alloc() with the same stack size then is just a list pop. The
+ * number of cached blocks per stack size is bounded by a high-water mark
+ * which can be adjusted with pth_ctrl(PTH_CTRL_STACKCACHE, n).
+ *
+ * Where available, stacks are mmap(2)'ed with an additional PROT_NONE
+ * guard page at the end the stack grows towards, so a stack overflow
+ * faults immediately instead of silently corrupting foreign memory.
+ */
+#if cpp
+#define PTH_TCB_CACHE_SLOTS 8
+#define PTH_TCB_CACHE_MAX   32
+#endif /* cpp */
+
+typedef struct {
+    unsigned int stacksize;  /* stack size this slot caches blocks for */
+    int          count;      /* number of cached blocks                */
+    pth_t        head;       /* free list (chained via q_next)         */
+} pth_tcb_cache_slot_t;
+
+static pth_tcb_cache_slot_t pth_tcb_cache[PTH_TCB_CACHE_SLOTS];
+intern int pth_tcb_cache_max = PTH_TCB_CACHE_MAX;
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP) && defined(HAVE_MPROTECT)
+#include <sys/mman.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#if defined(MAP_ANONYMOUS)
+#define PTH_TCB_STACK_MMAP 1
+#endif
+#endif
+
+/* allocate a thread stack (with guard page if possible) */
+static int pth_tcb_stack_alloc(pth_t t, unsigned int stacksize)
+{
+#ifdef PTH_TCB_STACK_MMAP
+    size_t pagesize;
+    char *map;
+
+    pagesize = (size_t)sysconf(_SC_PAGESIZE);
+    stacksize = (unsigned int)((stacksize + pagesize - 1) & ~(pagesize - 1));
+    map = (char *)mmap(NULL, stacksize + pagesize, PROT_READ|PROT_WRITE,
+                       MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (map == (char *)MAP_FAILED)
+        return FALSE;
+#if PTH_STACKGROWTH < 0
+    /* guard page is below the lowest stack address */
+    if (mprotect(map, pagesize, PROT_NONE) == -1) {
+        pth_shield { munmap(map, stacksize + pagesize); }
+        return FALSE;
+    }
+    t->stack = map + pagesize;
+#else
+    /* guard page is above the highest stack address */
+    if (mprotect(map + stacksize, pagesize, PROT_NONE) == -1) {
+        pth_shield { munmap(map, stacksize + pagesize); }
+        return FALSE;
+    }
+    t->stack = map;
+#endif
+    t->stackmap    = map;
+    t->stackmaplen = stacksize + pagesize;
+    t->stacksize   = stacksize;
+#else
+    if ((t->stack = (char *)malloc(stacksize)) == NULL)
+        return FALSE;
+    t->stackmap    = NULL;
+    t->stackmaplen = 0;
+    t->stacksize   = stacksize;
+#endif
+    return TRUE;
+}
+
+/* release a thread stack */
+static void pth_tcb_stack_free(pth_t t)
+{
+#ifdef PTH_TCB_STACK_MMAP
+    if (t->stackmap != NULL) {
+        munmap(t->stackmap, t->stackmaplen);
+        return;
+    }
+#endif
+    free(t->stack);
+    return;
+}
+
+/* find the cache slot for a particular stack size */
+static pth_tcb_cache_slot_t *pth_tcb_cache_slot(unsigned int stacksize, int create)
+{
+    pth_tcb_cache_slot_t *slot;
+    int i;
+
+    slot = NULL;
+    for (i = 0; i < PTH_TCB_CACHE_SLOTS; i++) {
+        if (pth_tcb_cache[i].stacksize == stacksize)
+            return &pth_tcb_cache[i];
+        if (slot == NULL && pth_tcb_cache[i].count == 0)
+            slot = &pth_tcb_cache[i];
+    }
+    if (!create || slot == NULL)
+        return NULL;
+    slot->stacksize = stacksize;
+    return slot;
+}
+
+/* release all cached thread control blocks */
+intern void pth_tcb_cache_flush(void)
+{
+    pth_t t;
+    int i;
+
+    for (i = 0; i < PTH_TCB_CACHE_SLOTS; i++) {
+        while ((t = pth_tcb_cache[i].head) != NULL) {
+            pth_tcb_cache[i].head = t->q_next;
+            pth_tcb_stack_free(t);
+            free(t);
+        }
+        pth_tcb_cache[i].count     = 0;
+        pth_tcb_cache[i].stacksize = 0;
+    }
+    return;
+}
+
+/* adjust the high-water mark of the cache and return the old one */
+intern int pth_tcb_cache_limit(int max)
+{
+    pth_tcb_cache_slot_t *slot;
+    pth_t t;
+    int old;
+    int i;
+
+    old = pth_tcb_cache_max;
+    pth_tcb_cache_max = (max < 0 ? 0 : max);
+    for (i = 0; i < PTH_TCB_CACHE_SLOTS; i++) {
+        slot = &pth_tcb_cache[i];
+        while (slot->count > pth_tcb_cache_max) {
+            t = slot->head;
+            slot->head = t->q_next;
+            slot->count--;
+            pth_tcb_stack_free(t);
+            free(t);
+        }
+    }
+    return old;
+}
+
 /* allocate a thread control block */
 intern pth_t pth_tcb_alloc(unsigned int stacksize, void *stackaddr)
 {
+    pth_tcb_cache_slot_t *slot;
     pth_t t;
 
     if (stacksize > 0 && stacksize < SIGSTKSZ)
         stacksize = SIGSTKSZ;
+
+    /* fast path: reuse a cached control block with its stack */
+    if (stacksize > 0 && stackaddr == NULL) {
+        if ((slot = pth_tcb_cache_slot(stacksize, FALSE)) != NULL && slot->head != NULL) {
+            t = slot->head;
+            slot->head = t->q_next;
+            slot->count--;
+            *t->stackguard = 0xDEAD;
+            return t;
+        }
+    }
+
     if ((t = (pth_t)malloc(sizeof(struct pth_st))) == NULL)
         return NULL;
-    t->stacksize  = stacksize;
-    t->stack      = NULL;
-    t->stackguard = NULL;
-    t->stackloan  = (stackaddr != NULL ? TRUE : FALSE);
+    t->stacksize   = stacksize;
+    t->stack       = NULL;
+    t->stackguard  = NULL;
+    t->stackmap    = NULL;
+    t->stackmaplen = 0;
+    t->stackloan   = (stackaddr != NULL ? TRUE : FALSE);
+    t->cachekey    = stacksize;
     if (stacksize > 0) { /* stacksize == 0 means "main" thread */
         if (stackaddr != NULL)
             t->stack = (char *)(stackaddr);
         else {
-            if ((t->stack = (char *)malloc(stacksize)) == NULL) {
+            if (!pth_tcb_stack_alloc(t, stacksize)) {
                 pth_shield { free(t); }
                 return NULL;
             }
@@ -126,7 +307,7 @@ intern pth_t pth_tcb_alloc(unsigned int stacksize, void *stackaddr)
         t->stackguard = (long *)((long)t->stack); /* double cast to avoid alignment warning */
 #else
         /* guard is at highest address (be careful with alignment) */
-        t->stackguard = (long *)(t->stack+(((stacksize/sizeof(long))-1)*sizeof(long)));
+        t->stackguard = (long *)(t->stack+(((t->stacksize/sizeof(long))-1)*sizeof(long)));
 #endif
         *t->stackguard = 0xDEAD;
     }
@@ -136,14 +317,27 @@ intern pth_t pth_tcb_alloc(unsigned int stacksize, void *stackaddr)
 /* free a thread control block */
 intern void pth_tcb_free(pth_t t)
 {
+    pth_tcb_cache_slot_t *slot;
+
     if (t == NULL)
         return;
-    if (t->stack != NULL && !t->stackloan)
-        free(t->stack);
     if (t->data_value != NULL)
         free(t->data_value);
     if (t->cleanups != NULL)
         pth_cleanup_popall(t, FALSE);
+    if (t->stack != NULL && !t->stackloan) {
+        /* try to keep the block for a later pth_tcb_alloc() */
+        slot = pth_tcb_cache_slot(t->cachekey, TRUE);
+        if (slot != NULL && slot->count < pth_tcb_cache_max) {
+            t->data_value = NULL;
+            t->cleanups   = NULL;
+            t->q_next     = slot->head;
+            slot->head    = t;
+            slot->count++;
+            return;
+        }
+        pth_tcb_stack_free(t);
+    }
     free(t);
     return;
 }
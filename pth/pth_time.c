@@ -180,3 +180,58 @@ intern int pth_time_pos(pth_time_t *t)
         return 0;
 }
 
+
+/*
+ * Low-overhead clock for the scheduler's time accounting.
+ *
+ * The scheduler takes two time stamps on every dispatch, so instead of
+ * gettimeofday(2) it reads the monotonic clock, which needs neither a
+ * calibration nor a system call on platforms providing it through the
+ * vDSO. Its values are only good for measuring time ranges: they are
+ * unrelated to the time of day and must be converted with
+ * pth_time_clock_tod() before they are handed out through the API.
+ */
+#ifdef HAVE_CLOCK_GETTIME
+static int pth_time_mono_ok = FALSE;        /* monotonic clock is usable */
+#endif
+
+/* initialize the scheduler clock */
+intern void pth_time_clock_init(void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec ts;
+
+    pth_time_mono_ok = (clock_gettime(CLOCK_MONOTONIC, &ts) == 0);
+#endif
+    return;
+}
+
+/* read the scheduler clock */
+intern void pth_time_clock(pth_time_t *t)
+{
+#ifdef HAVE_CLOCK_GETTIME
+    if (pth_time_mono_ok) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        t->tv_sec  = ts.tv_sec;
+        t->tv_usec = ts.tv_nsec / 1000;
+        return;
+    }
+#endif
+    pth_time_set(t, PTH_TIME_NOW);
+    return;
+}
+
+/* convert a time point of the scheduler clock into a time of day,
+   re-anchored at the current time of day */
+intern void pth_time_clock_tod(pth_time_t *tod, pth_time_t *t)
+{
+    pth_time_t now;
+
+    pth_time_clock(&now);
+    pth_time_sub(&now, t);
+    pth_time_set(tod, PTH_TIME_NOW);
+    pth_time_sub(tod, &now);
+    return;
+}
+
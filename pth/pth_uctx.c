@@ -138,6 +138,9 @@ pth_uctx_make(
                       uctx->uc_stack_ptr, uctx->uc_stack_ptr+uctx->uc_stack_len))
         return pth_error(FALSE, errno);
 
+    /* the parent context is only filled by the switch below */
+    memset((void *)&mctx_parent, 0, sizeof(pth_mctx_t));
+
     /* move context information into global storage for the trampoline jump */
     pth_uctx_trampoline_ctx.mctx_parent = &mctx_parent;
     pth_uctx_trampoline_ctx.uctx_this   = uctx;
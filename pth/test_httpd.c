@@ -52,23 +52,34 @@
 static void *handler(void *_arg)
 {
     int fd = (int)((long)_arg);
-    char caLine[MAXREQLINE];
+    pth_bufio_t bi;
+    const char *line;
     char str[1024];
-    int n;
+    ssize_t n;
+    int blank;
+
+    if ((bi = pth_bufio_create(fd, MAXREQLINE, 0)) == NULL) {
+        fprintf(stderr, "bufio error: errno=%d\n", errno);
+        close(fd);
+        return NULL;
+    }
 
     /* read request */
     for (;;) {
-        n = pth_readline(fd, caLine, MAXREQLINE);
+        n = pth_bufio_peek_line(bi, &line, NULL);
         if (n < 0) {
             fprintf(stderr, "read error: errno=%d\n", errno);
+            pth_bufio_destroy(bi);
             close(fd);
             return NULL;
         }
         if (n == 0)
             break;
-        if (n == 1 && caLine[0] == '\n')
+        /* the peeked line is only valid until it is consumed */
+        blank = ((n == 1 && line[0] == '\n') || (n == 2 && line[0] == '\r'));
+        pth_bufio_consume(bi, n);
+        if (blank)
             break;
-        caLine[n-1] = NUL;
     }
 
     /* simulate a little bit of processing ;) */
@@ -79,13 +90,15 @@ static void *handler(void *_arg)
                  "Server: test_httpd/%x\r\n"
                  "Connection: close\r\n"
                  "Content-type: text/plain\r\n"
-                 "\r\n"
-                 "Just a trivial test for GNU Pth\n"
-                 "to show that it's serving data.\r\n", PTH_VERSION);
-    pth_write(fd, str, strlen(str));
+                 "\r\n", PTH_VERSION);
+    pth_bufio_write(bi, str, strlen(str), NULL);
+    sprintf(str, "Just a trivial test for GNU Pth\n"
+                 "to show that it's serving data.\r\n");
+    pth_bufio_write(bi, str, strlen(str), NULL);
 
     /* close connection and let thread die */
     fprintf(stderr, "connection shutdown (fd: %d)\n", fd);
+    pth_bufio_destroy(bi);
     close(fd);
     return NULL;
 }
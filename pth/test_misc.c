@@ -28,6 +28,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <signal.h>
+#include <sys/time.h>
 
 #include "pth.h"
 
@@ -84,6 +86,120 @@ static void *my_child(void *_arg)
     return NULL;
 }
 
+/*
+ *  yield ping-pong: two threads hand the CPU back and forth
+ *  with pth_yield(3), so each round trip costs two dispatches
+ */
+
+#define DO_YIELDS 250000
+
+static pth_t pingpong_peer[2];
+static volatile int pingpong_done;
+
+static void *my_pingpong(void *_arg)
+{
+    int me = (int)((long)_arg);
+    int i;
+
+    for (i = 0; i < DO_YIELDS; i++)
+        pth_yield(pingpong_peer[1-me]);
+    pingpong_done++;
+    return NULL;
+}
+
+static void test_pingpong(void)
+{
+    pth_attr_t t_attr;
+    struct timeval start;
+    struct timeval end;
+    double secs;
+
+    fprintf(stderr, "Performing %d yield ping-pong rounds... be patient!\n", DO_YIELDS);
+
+    t_attr = pth_attr_new();
+    pth_attr_set(t_attr, PTH_ATTR_JOINABLE, TRUE);
+    pth_attr_set(t_attr, PTH_ATTR_NAME, "ping");
+    pingpong_peer[0] = pth_spawn(t_attr, my_pingpong, (void *)0);
+    pth_attr_set(t_attr, PTH_ATTR_NAME, "pong");
+    pingpong_peer[1] = pth_spawn(t_attr, my_pingpong, (void *)1);
+    pth_attr_destroy(t_attr);
+
+    gettimeofday(&start, NULL);
+    pth_join(pingpong_peer[0], NULL);
+    pth_join(pingpong_peer[1], NULL);
+    gettimeofday(&end, NULL);
+
+    secs = (double)(end.tv_sec - start.tv_sec)
+         + (double)(end.tv_usec - start.tv_usec) / 1000000;
+    if (secs <= 0)
+        secs = 0.000001;
+    fprintf(stderr, "We required %.3f seconds, i.e. %.0f ns per yield "
+            "(%.0f thread switches per second).\n",
+            secs, secs * 1000000000 / (2.0 * DO_YIELDS), (2.0 * DO_YIELDS) / secs);
+    fprintf(stderr, "\n");
+    return;
+}
+
+/*
+ *  signal mask leak: while one thread waits in pth_pselect(3) with
+ *  SIGUSR1 blocked, another thread must still run with SIGUSR1 unblocked
+ */
+
+static volatile int sigmask_leaked;
+
+static void *my_pselect(void *_arg)
+{
+    struct timespec ts;
+    sigset_t ss;
+
+    sigemptyset(&ss);
+    sigaddset(&ss, SIGUSR1);
+    ts.tv_sec  = 0;
+    ts.tv_nsec = 200000000;
+    pth_pselect(0, NULL, NULL, NULL, &ts, &ss);
+    return NULL;
+}
+
+static void *my_sigcheck(void *_arg)
+{
+    sigset_t ss;
+
+    /* let the other thread enter pth_pselect(3) first */
+    pth_usleep(50000);
+    pth_sigmask(SIG_SETMASK, NULL, &ss);
+    if (sigismember(&ss, SIGUSR1))
+        sigmask_leaked = 1;
+    return NULL;
+}
+
+static int test_sigmask(void)
+{
+    pth_attr_t t_attr;
+    pth_t t[2];
+
+    fprintf(stderr, "Checking that a pth_pselect(3) mask stays private to its thread\n");
+
+    t_attr = pth_attr_new();
+    pth_attr_set(t_attr, PTH_ATTR_JOINABLE, TRUE);
+    pth_attr_set(t_attr, PTH_ATTR_NAME, "pselect");
+    t[0] = pth_spawn(t_attr, my_pselect, NULL);
+    pth_attr_set(t_attr, PTH_ATTR_NAME, "sigcheck");
+    t[1] = pth_spawn(t_attr, my_sigcheck, NULL);
+    pth_attr_destroy(t_attr);
+
+    pth_join(t[0], NULL);
+    pth_join(t[1], NULL);
+
+    if (sigmask_leaked) {
+        fprintf(stderr, "FAILED: SIGUSR1 blocked in the other thread\n");
+        fprintf(stderr, "\n");
+        return 1;
+    }
+    fprintf(stderr, "OK: SIGUSR1 unblocked in the other thread\n");
+    fprintf(stderr, "\n");
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     pth_t child[10];
@@ -101,6 +217,12 @@ int main(int argc, char *argv[])
     fprintf(stderr, "Enter 'q' to quit.\n");
     fprintf(stderr, "\n");
 
+    test_pingpong();
+    if (test_sigmask() != 0) {
+        pth_kill();
+        return 1;
+    }
+
     fprintf(stderr, "Main Startup (%ld total threads running)\n", pth_ctrl(PTH_CTRL_GETTHREADS));
 
     t_attr = pth_attr_new();
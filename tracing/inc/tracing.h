@@ -3,6 +3,30 @@
 
 //note: for better c compatibility, should avoid to use namespace in interface. 
 
+//peers with smaller ids are looked up by index, larger ids by hashing.
+#ifndef WPR_LOG_DENSE_PEERS
+#define WPR_LOG_DENSE_PEERS 1024
+#endif
+
+//severity levels. WPR_LOG logs at WPR_LEVEL_INFO, function tracing at
+//WPR_LEVEL_TRACE.
+#define WPR_LEVEL_TRACE 0
+#define WPR_LEVEL_DEBUG 1
+#define WPR_LEVEL_INFO  2
+#define WPR_LEVEL_WARN  3
+#define WPR_LEVEL_ERROR 4
+#define WPR_LEVEL_OFF   5
+
+//time sources for the timestamps of synchronous log calls.
+#define WPR_LOG_CLOCK_REALTIME 0  //gettimeofday(), the default.
+#define WPR_LOG_CLOCK_COARSE   1  //CLOCK_REALTIME_COARSE, a tick (1-4ms) resolution.
+#define WPR_LOG_CLOCK_TSC      2  //calibrated cycle counter, no vDSO call.
+
+//log statements below this level are compiled out.
+#ifndef WPR_MIN_LEVEL
+#define WPR_MIN_LEVEL WPR_LEVEL_TRACE
+#endif
+
 //main interface to log info.
 extern "C"{
 void 
@@ -12,6 +36,126 @@ wpr_log(const unsigned int peerId,
 
 void
 wpr_log_addConsoleAppender(const unsigned int peerId);
+
+//a peer is enabled if it has appenders and was not disabled. log calls
+//of disabled peers return before any formatting or argument handling.
+int
+wpr_log_isEnabled(const unsigned int peerId);
+
+void
+wpr_log_setEnabled(const unsigned int peerId, const int enabled);
+
+//runtime level: statements of peerId below level are skipped before their
+//arguments are evaluated. the default is WPR_LEVEL_TRACE (log everything).
+void
+wpr_log_setLevel(const unsigned int peerId, const int level);
+
+int
+wpr_log_isLevelEnabled(const unsigned int peerId, const int level);
+
+//sample function tracing of peerId: only every n-th traced call is logged
+//(1 logs all), and if minMicros is not 0 only calls which took at least
+//minMicros microseconds are logged, by a single line on return.
+void
+wpr_log_setFunctionSampling(const unsigned int peerId, const unsigned int n,
+                            const unsigned int minMicros);
+
+//bit (1 << level) is set for each level the peers below
+//WPR_LOG_DENSE_PEERS log, 0 if disabled. see WPR_LOG_LEVEL_ENABLED.
+extern unsigned char wpr_log_peerLevels[WPR_LOG_DENSE_PEERS];
+
+//options of a file appender, zero fields select the defaults.
+struct wpr_log_fileOptions
+{
+  unsigned int bufferSize;      //bytes collected per write, default 256KiB.
+  unsigned int flushMillis;     //max age of buffered lines, default 100ms.
+  unsigned long long rotateBytes;   //start a new file at this size.
+  unsigned int rotateSeconds;   //start a new file after this many seconds.
+  unsigned int keepFiles;       //rotated files kept as filename.1 ... .N.
+  unsigned long long preallocate;   //reserve disk space in steps of this size.
+};
+
+//write the formatted lines of peerId into filename. peers using the same
+//name share the appender, its options are taken from the first call
+//(options may be NULL). lines are buffered, see wpr_log_flush().
+void
+wpr_log_addFileAppender(const unsigned int peerId, const char * filename,
+                        const struct wpr_log_fileOptions * options);
+
+//write the records of peerId unformatted into filename, which is shared by
+//all peers using the same name. use wpr_trace_decode to read it.
+void
+wpr_log_addBinaryAppender(const unsigned int peerId, const char * filename);
+
+//select the clock for timestamps (one of WPR_LOG_CLOCK_*). asynchronous
+//records always use the cycle counter.
+void
+wpr_log_setClock(const int clock);
+
+//keep the latest formatted lines of peerId in a ring of size bytes inside
+//the memory mapped filename (a flight recorder, it survives a crash of the
+//process). peers using the same name share the ring. use wpr_ring_dump to
+//read it.
+void
+wpr_log_addMmapRingAppender(const unsigned int peerId, const char * filename,
+                            unsigned long long size);
+
+//asynchronous mode: wpr_log() only copies the format arguments into a
+//per-thread ring and a background thread formats and writes them.
+//format, srcfile and function must be string literals (they are kept by
+//pointer). ringSize is the number of records per thread (0 for default),
+//when a ring is full new records are dropped and counted.
+//returns 0 on success, -1 if the writer thread could not be started.
+int
+wpr_log_enableAsync(const unsigned int ringSize);
+
+//drain all pending records and go back to synchronous mode.
+void
+wpr_log_disableAsync(void);
+
+//wait until all records logged before this call have been written
+//(this also writes out the buffers of file and binary appenders).
+void
+wpr_log_flush(void);
+
+//number of records dropped because a thread ring was full.
+unsigned long
+wpr_log_getDroppedCount(void);
+
+//span tracing: timed scopes (see TraceSpan) are recorded into per-thread
+//buffers of eventsPerThread spans (0 for default) and exported in the
+//Chrome trace event format, which chrome://tracing and ui.perfetto.dev
+//load. spans of a full buffer are dropped and counted.
+int
+wpr_span_start(const unsigned int eventsPerThread);
+
+void
+wpr_span_stop(void);
+
+//clock ticks to pass to wpr_span_end(), 0 if span tracing is stopped.
+unsigned long long
+wpr_span_begin(void);
+
+//record a span which started at start (see wpr_span_begin(), nothing is
+//recorded for 0). name, category and key must be string literals, value
+//is copied. key may be NULL.
+void
+wpr_span_end(const char * name, const char * category,
+             unsigned long long start, const char * key, const char * value);
+
+//write all spans recorded so far as JSON, returns -1 on error.
+int
+wpr_span_exportChrome(const char * filename);
+
+//discard the recorded spans, only call while no spans are recorded.
+void
+wpr_span_reset(void);
+
+unsigned long
+wpr_span_getDroppedCount(void);
+
+//set while span tracing is started, see TraceSpan.
+extern int wpr_span_enabled;
 } //extern "C"
 
 #ifndef WPR_ENABLE_TRACING
@@ -26,23 +170,75 @@ wpr_log_addConsoleAppender(const unsigned int peerId);
 #define NULL 0
 #endif
 
-#ifndef WPR_LOG_TRACE
+#ifndef WPR_LOG_LEVEL_ENABLED
+#define WPR_LOG_LEVEL_ENABLED(logger, level)\
+    ((level) >= WPR_MIN_LEVEL &&\
+     ((unsigned int)(logger) < WPR_LOG_DENSE_PEERS ?\
+      0 != (__atomic_load_n(&wpr_log_peerLevels[(unsigned int)(logger)],\
+                            __ATOMIC_RELAXED) & (1 << (level))) :\
+      0 != wpr_log_isLevelEnabled(logger, level)))
+#endif
+
+#ifndef WPR_LOG_ENABLED
+#define WPR_LOG_ENABLED(logger)\
+    WPR_LOG_LEVEL_ENABLED(logger, WPR_LEVEL_INFO)
+#endif
+
+#ifndef WPR_LOG_TRACE_LEVEL
 #  if WPR_ENABLE_TRACING == 1
-#    define WPR_LOG_TRACE(logger, file, line, function, format, ...)\
+#    define WPR_LOG_TRACE_LEVEL(logger, level, file, line, function, format, ...)\
         {\
-        if( NULL != logger )\
+        if( NULL != logger && WPR_LOG_LEVEL_ENABLED(logger, level) )\
         {\
         wpr_log(logger, file, line, function, format, ##__VA_ARGS__);\
         }\
         }
 #  else
-#    define WPR_LOG_TRACE(logger, file, line, function, const char * format, ...) {}/* empty */
+#    define WPR_LOG_TRACE_LEVEL(logger, level, file, line, function, format, ...) {}/* empty */
 #  endif
 #endif
 
+#ifndef WPR_LOG_TRACE
+#define WPR_LOG_TRACE(logger, file, line, function, format, ...)\
+    WPR_LOG_TRACE_LEVEL(logger, WPR_LEVEL_INFO, file, line, function, format, ##__VA_ARGS__)
+#endif
+
+#ifndef WPR_LOG_AT
+#define WPR_LOG_AT(logger, level, format, ...)\
+    WPR_LOG_TRACE_LEVEL(logger, level, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__);
+#endif
+
 #ifndef WPR_LOG
 #define WPR_LOG(logger, format, ...)\
-    WPR_LOG_TRACE(logger, __FILE__, __LINE__, __FUNCTION__, format, ##__VA_ARGS__);
+    WPR_LOG_AT(logger, WPR_LEVEL_INFO, format, ##__VA_ARGS__)
+#endif
+
+#if WPR_MIN_LEVEL <= WPR_LEVEL_DEBUG
+#  define WPR_LOG_DEBUG(logger, format, ...)\
+    WPR_LOG_AT(logger, WPR_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#  define WPR_LOG_DEBUG(logger, format, ...) {}/* compiled out */
+#endif
+
+#if WPR_MIN_LEVEL <= WPR_LEVEL_INFO
+#  define WPR_LOG_INFO(logger, format, ...)\
+    WPR_LOG_AT(logger, WPR_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#  define WPR_LOG_INFO(logger, format, ...) {}/* compiled out */
+#endif
+
+#if WPR_MIN_LEVEL <= WPR_LEVEL_WARN
+#  define WPR_LOG_WARN(logger, format, ...)\
+    WPR_LOG_AT(logger, WPR_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#  define WPR_LOG_WARN(logger, format, ...) {}/* compiled out */
+#endif
+
+#if WPR_MIN_LEVEL <= WPR_LEVEL_ERROR
+#  define WPR_LOG_ERROR(logger, format, ...)\
+    WPR_LOG_AT(logger, WPR_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#  define WPR_LOG_ERROR(logger, format, ...) {}/* compiled out */
 #endif
 
 //function tracing.
@@ -62,8 +258,12 @@ wpr_log_addConsoleAppender(const unsigned int peerId);
 #endif
 
 #ifndef WPR_FUNCTION_TRACER
-#  define WPR_FUNCTION_TRACER(logger) \
+#  if WPR_MIN_LEVEL <= WPR_LEVEL_TRACE
+#    define WPR_FUNCTION_TRACER(logger) \
     FunctionTracer WPR_TMPVAR(__LINE__)(logger, __FILE__, __FUNCTION__);
+#  else
+#    define WPR_FUNCTION_TRACER(logger) {}/* compiled out */
+#  endif
 #endif
 
 #ifndef WPR_LOG_FUNCTION
@@ -84,6 +284,8 @@ namespace wpr_tracing
       unsigned int _peerId;
       const char * _file;
       const char * _function;
+      unsigned long long _start;  //clock ticks at entry, 0 if not sampled.
+      bool _logReturn;            //log the return of this call.
   };
 }
 #else
@@ -92,5 +294,76 @@ namespace wpr_tracing
 # endif
 #endif   //function tracing.
 
+//span tracing.
+#ifndef WPR_ENABLE_SPANS
+#define WPR_ENABLE_SPANS 1
+#endif
+
+#define WPR_SPAN_MAX_ARGS 2
+#define WPR_SPAN_TEXT_SIZE 24
+
+#define WPR_SPAN_CONCAT2(a, b) a##b
+#define WPR_SPAN_CONCAT(a, b) WPR_SPAN_CONCAT2(a, b)
+
+#ifndef WPR_SPAN
+#  if WPR_ENABLE_SPANS == 1
+#    define WPR_SPAN(name) \
+    wpr_tracing::TraceSpan WPR_SPAN_CONCAT(__wpr_span_, __LINE__)(name);
+#  else
+#    define WPR_SPAN(name) {}/* compiled out */
+#  endif
+#endif
+
+namespace wpr_tracing
+{
+  struct TraceSpanArg
+  {
+    const char * key;
+    bool isText;
+    long long value;
+    char text[WPR_SPAN_TEXT_SIZE];  //copied and truncated.
+  };
+
+  /**
+   * TraceSpan records the time from its construction to its destruction
+   * as one span of the calling thread, with up to WPR_SPAN_MAX_ARGS
+   * arguments. While span tracing is stopped it costs one load.
+   */
+  class TraceSpan
+  {
+    public:
+      TraceSpan(const char * name, const char * category = "wpr")
+      : _name(name), _category(category), _start(0), _argCount(0)
+      {
+        if(__atomic_load_n(&wpr_span_enabled, __ATOMIC_RELAXED)){
+          _start = wpr_span_begin();
+        }
+      }
+
+      ~TraceSpan()
+      {
+        if(_start != 0){
+          end();
+        }
+      }
+
+      TraceSpan&
+      arg(const char * key, long long value);
+
+      TraceSpan&
+      arg(const char * key, const char * value);
+
+    private:
+      void
+      end();
+
+      const char * _name;
+      const char * _category;
+      unsigned long long _start;  //0 if not recorded.
+      unsigned int _argCount;
+      TraceSpanArg _args[WPR_SPAN_MAX_ARGS];
+  };
+}
+
 #endif
 
@@ -1,19 +1,52 @@
 #include "tracing.h"
+#include "tracemanager.h"
+#include "tracepeer.h"
+#include "traceclock.h"
 #ifdef WPR_ENABLE_FUNCTION_TRACING
 namespace wpr_tracing
 {
+  //traced calls of this thread, for 1 in n sampling.
+  static __thread unsigned int tracedCalls = 0;
+
   // constructor
   FunctionTracer::FunctionTracer(const unsigned int peerId, const char * file,
                                  const char * function) :
-    _peerId(peerId), _file(file), _function(function)
+    _peerId(peerId), _file(file), _function(function), _start(0),
+    _logReturn(false)
   {
+      TracePeer * peer = TraceManager::getInstance()->findTracePeer(_peerId);
+      if(NULL == peer || !peer->isLevelEnabled(WPR_LEVEL_TRACE)){
+        return;
+      }
+      unsigned int every = peer->getSampleEvery();
+      if(every > 1 && ++tracedCalls % every != 0){
+        return;
+      }
+      _logReturn = true;
+      if(peer->getSampleMinTicks() > 0){
+        _start = traceClockNow(); //decide on return, when the duration is known.
+        return;
+      }
       ::wpr_log(_peerId, _file, 0, _function, "->%s", _function);
   } 
 
   // destructor
   FunctionTracer::~FunctionTracer()
   {
-      ::wpr_log(_peerId, _file, 0, _function, "<-%s", _function);
+      if(!_logReturn){
+        return;
+      }
+      if(0 == _start){
+        ::wpr_log(_peerId, _file, 0, _function, "<-%s", _function);
+        return;
+      }
+      unsigned long long elapsed = traceClockNow() - _start;
+      TracePeer * peer = TraceManager::getInstance()->findTracePeer(_peerId);
+      if(elapsed < peer->getSampleMinTicks()){
+        return;
+      }
+      ::wpr_log(_peerId, _file, 0, _function, "<-%s %lluus", _function,
+                (unsigned long long)(elapsed * 1e6 / traceClockInfo().hz));
   }
 }
 #endif
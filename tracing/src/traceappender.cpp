@@ -8,6 +8,12 @@
 #include "tracing.h"
 #include <cstdarg>
 #include "tracemsg.h"
+#include "traceasync.h"
+#include "traceargs.h"
+#include "traceclock.h"
+#include "tracebinary.h"
+#include "tracering.h"
+#include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
 #include <string.h>
@@ -16,24 +22,85 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #define  MAX_BUFFER_SIZE  1024
 
 namespace wpr_tracing
 {
 
+  //the date part only changes once a second, each thread keeps the last
+  //one so localtime_r() and strftime() are not called per message.
+  struct TimeStampCache
+  {
+    time_t second;
+    int length;
+    char text[64];
+  };
+
+  static __thread TimeStampCache timeStampCache = { -1, 0, { 0 } };
+
   static
   inline int
-  printTimeStamp(char *p, int max_len)
+  printTimeStamp(const struct timeval& now, char *p, int max_len)
   {
-    struct timeval now;
-    gettimeofday(&now, NULL);
-    struct tm local_now;
-    localtime_r(&now.tv_sec, &local_now);
-    int n = strftime(p, max_len, "%x %X", &local_now);
-    max_len = max_len - n;
-    p = p + n;
-    n += snprintf(p, max_len, ".%ld", (long) (now.tv_usec) / 1000);
-    return n;
+    TimeStampCache& cache = timeStampCache;
+    if(cache.second != now.tv_sec){
+      struct tm local_now;
+      localtime_r(&now.tv_sec, &local_now);
+      cache.length = strftime(cache.text, sizeof(cache.text), "%x %X", &local_now);
+      cache.second = now.tv_sec;
+    }
+    if(cache.length + 8 > max_len){
+      return 0; //no room, leave the timestamp out.
+    }
+    memcpy(p, cache.text, cache.length);
+    p += cache.length;
+    //".uuuuuu", microseconds
+    unsigned int us = now.tv_usec;
+    p[0] = '.';
+    for(int i = 6; i > 0; --i){
+      p[i] = '0' + us % 10;
+      us /= 10;
+    }
+    p[7] = '\0';
+    return cache.length + 7;
+  }
+
+  int
+  buildTraceHeader(char* buf, int buf_size, const struct timeval& now,
+                   const char* srcfile, const int line)
+  {
+    int n = printTimeStamp(now, buf, buf_size);
+    size_t len = strlen(srcfile);
+    if(n + len + 20 > (size_t)buf_size || line < 0){
+      n += snprintf(buf + n, buf_size - n, " (%s:%d): ", srcfile, line);
+      return n < buf_size ? n : buf_size - 1;
+    }
+    //same as the snprintf() above, without parsing the format each time.
+    char * p = buf + n;
+    *p++ = ' ';
+    *p++ = '(';
+    memcpy(p, srcfile, len);
+    p += len;
+    *p++ = ':';
+    char digits[12];
+    int d = 0;
+    unsigned int value = line;
+    do{
+      digits[d++] = '0' + value % 10;
+      value /= 10;
+    }while(value > 0);
+    while(d > 0){
+      *p++ = digits[--d];
+    }
+    *p++ = ')';
+    *p++ = ':';
+    *p++ = ' ';
+    *p = '\0';
+    return p - buf;
   }
 
   static
@@ -44,19 +111,118 @@ namespace wpr_tracing
     char *p = buf;
     unsigned int max_len = buf_size;
     unsigned int n = 0;
-    n = printTimeStamp(buf, max_len);
-    p = p + n;
-    max_len = max_len - n;
-    n = snprintf(p, max_len, " (%s:%d): ", msg.srcfile, msg.line);
+    struct timeval now;
+    traceTimeNow(now);
+    n = buildTraceHeader(buf, max_len, now, msg.srcfile, msg.line);
     p = p + n;
     max_len = max_len - n;
 
-    vsnprintf(p, max_len, msg.format, *((va_list *)msg.ap));
+    va_list args;  //each appender needs its own copy of the arguments.
+    va_copy(args, *((va_list *)msg.ap));
+    vsnprintf(p, max_len, msg.format, args);
+    va_end(args);
      
 
     return;
   }
 
+  void
+  TraceAppender::traceRecord(const TraceRecord&, const char* line, unsigned int len)
+  {
+    queueLine(line, len);
+  }
+
+  bool
+  TraceAppender::isBinary() const
+  {
+    return false;
+  }
+
+  TraceAppender::TraceAppender()
+  {
+    pthread_mutex_init(&_pendingLock, NULL);
+  }
+
+  TraceAppender::~TraceAppender()
+  {
+    pthread_mutex_destroy(&_pendingLock);
+  }
+
+  void
+  TraceAppender::queueLine(const char* line, unsigned int len)
+  {
+    pthread_mutex_lock(&_pendingLock);
+    if(!_pending.empty()){
+      struct iovec& last = _pending.back();
+      if((char *)last.iov_base + last.iov_len == line){
+        last.iov_len += len; //adjacent in the batch buffer, just extend.
+        pthread_mutex_unlock(&_pendingLock);
+        return;
+      }
+    }
+    if(_pending.size() == WPR_TRACING_MAX_IOV){
+      writePending();
+    }
+    struct iovec iov;
+    iov.iov_base = (void *)line;
+    iov.iov_len = len;
+    _pending.push_back(iov);
+    pthread_mutex_unlock(&_pendingLock);
+  }
+
+  void
+  TraceAppender::flush()
+  {
+    pthread_mutex_lock(&_pendingLock);
+    writePending();
+    pthread_mutex_unlock(&_pendingLock);
+  }
+
+  void
+  TraceAppender::writePending()
+  {
+    int fd = getFd();
+    struct iovec * iov = _pending.empty() ? NULL : &_pending[0];
+    int iovcnt = _pending.size();
+    while(fd != -1 && iovcnt > 0){
+      ssize_t n = writev(fd, iov, iovcnt);
+      if(n < 0){
+        if(errno == EINTR){
+          continue;
+        }
+        if(errno == EAGAIN){
+          struct pollfd pfd = { fd, POLLOUT, 0 };
+          poll(&pfd, 1, 100);
+          continue;
+        }
+        break; //give up on this batch.
+      }
+      //skip what has been written, the usual partial write handling.
+      while(iovcnt > 0 && (size_t)n >= iov->iov_len){
+        n -= iov->iov_len;
+        ++iov;
+        --iovcnt;
+      }
+      if(iovcnt > 0){
+        iov->iov_base = (char *)iov->iov_base + n;
+        iov->iov_len -= n;
+      }
+    }
+    _pending.clear();
+  }
+
+  void
+  TraceAppender::endBatch()
+  {
+    flush();
+  }
+
+  int
+  ConsoleTraceAppender::getFd() const
+  {
+    return STDOUT_FILENO;
+  }
+
   void
   ConsoleTraceAppender::traceInfo(const TraceMsg& msg)
   {
@@ -70,33 +236,585 @@ namespace wpr_tracing
     return;
   }
  
-  FileTraceAppender::FileTraceAppender(const char * filename)
-  :_fd(-1)
+  #define WPR_TRACING_FILE_BUFFER_SIZE  (256 * 1024)
+  #define WPR_TRACING_FILE_FLUSH_MS     100
+
+  static
+  inline
+  unsigned long long
+  monotonicNanos()
   {
-    _fd = open(filename, O_WRONLY|O_APPEND|O_CREAT|O_NONBLOCK); 
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now); //no syscall, ms resolution.
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+  }
+
+  FileTraceAppender::FileTraceAppender(const char * filename,
+                                       const struct wpr_log_fileOptions * options)
+  :_filename(filename), _bufferSize(WPR_TRACING_FILE_BUFFER_SIZE),
+   _flushNanos(WPR_TRACING_FILE_FLUSH_MS * 1000000ULL), _rotateBytes(0),
+   _rotateNanos(0), _keepFiles(0), _preallocate(0), _fd(-1), _buf(NULL),
+   _used(0), _firstLine(0), _opened(0), _size(0), _reserved(0)
+  {
+    if(NULL != options){
+      if(options->bufferSize > 0){
+        _bufferSize = options->bufferSize < 2 * MAX_BUFFER_SIZE ?
+                      2 * MAX_BUFFER_SIZE : options->bufferSize;
+      }
+      if(options->flushMillis > 0){
+        _flushNanos = options->flushMillis * 1000000ULL;
+      }
+      _rotateBytes = options->rotateBytes;
+      _rotateNanos = options->rotateSeconds * 1000000000ULL;
+      _keepFiles = options->keepFiles;
+      _preallocate = options->preallocate;
+    }
+    pthread_mutex_init(&_lock, NULL);
+    _buf = (char *)malloc(_bufferSize);
+    openFile();
+  }
+
+  int
+  FileTraceAppender::getFd() const
+  {
+    return _fd;
   }
 
   FileTraceAppender::~FileTraceAppender()
   {
+    pthread_mutex_lock(&_lock);
+    writeBuffer();
     if(_fd!=-1){
       close(_fd);
     }
+    pthread_mutex_unlock(&_lock);
+    free(_buf);
+    pthread_mutex_destroy(&_lock);
+  }
+
+  bool
+  FileTraceAppender::openFile()
+  {
+    _fd = open(_filename.c_str(), O_WRONLY|O_APPEND|O_CREAT|O_CLOEXEC, 0644);
+    if(_fd == -1){
+      return false;
+    }
+    struct stat st;
+    _size = fstat(_fd, &st) == 0 ? st.st_size : 0;
+    _reserved = _size;
+    _opened = monotonicNanos();
+    return true;
   }
-  
+
   void
-  FileTraceAppender::traceInfo(const TraceMsg& msg)
+  FileTraceAppender::rotate()
+  {
+    close(_fd);
+    _fd = -1;
+    if(_keepFiles == 0){
+      unlink(_filename.c_str());
+    }else{
+      //shift filename.N-1 -> filename.N ... filename -> filename.1
+      char from[1024];
+      char to[1024];
+      for(unsigned int i = _keepFiles; i > 1; --i){
+        snprintf(from, sizeof(from), "%s.%u", _filename.c_str(), i - 1);
+        snprintf(to, sizeof(to), "%s.%u", _filename.c_str(), i);
+        rename(from, to);
+      }
+      snprintf(to, sizeof(to), "%s.1", _filename.c_str());
+      rename(_filename.c_str(), to);
+    }
+    openFile();
+  }
+
+  void
+  FileTraceAppender::writeBuffer()
+  {
+    if(_used == 0 || _buf == NULL){
+      return;
+    }
+    if(_fd != -1 && _size > 0){
+      bool full = _rotateBytes > 0 && _size + _used > _rotateBytes;
+      bool old = _rotateNanos > 0 && monotonicNanos() - _opened >= _rotateNanos;
+      if(full || old){
+        rotate();
+      }
+    }
+    if(_fd == -1){
+      _used = 0; //nowhere to write, drop the lines instead of growing.
+      return;
+    }
+    if(_preallocate > 0 && _size + _used > _reserved){
+      //reserve the next step so the file system can keep it contiguous.
+      unsigned long long end = _size + _used + _preallocate;
+      if(fallocate(_fd, FALLOC_FL_KEEP_SIZE, _reserved, end - _reserved) == 0){
+        _reserved = end;
+      }else{
+        _preallocate = 0; //not supported here, stop trying.
+      }
+    }
+    const char * p = _buf;
+    unsigned int left = _used;
+    while(left > 0){
+      ssize_t n = write(_fd, p, left);
+      if(n < 0){
+        if(errno == EINTR){
+          continue;
+        }
+        break; //give up on this buffer.
+      }
+      p += n;
+      left -= n;
+      _size += n;
+    }
+    _used = 0;
+  }
+
+  void
+  FileTraceAppender::append(const char * line, unsigned int len)
   {
-    if( _fd == -1){
+    if(_buf == NULL){
       return;
-    } 
+    }
+    if(_used + len > _bufferSize){
+      writeBuffer();
+    }
+    if(_used == 0){
+      _firstLine = monotonicNanos();
+    }
+    memcpy(_buf + _used, line, len);
+    _used += len;
+    if(_used == _bufferSize || monotonicNanos() - _firstLine >= _flushNanos){
+      writeBuffer();
+    }
+  }
 
+  void
+  FileTraceAppender::traceInfo(const TraceMsg& msg)
+  {
     char msgbuf[MAX_BUFFER_SIZE + 1] =
       { 0 };
 
     buildTraceMsg(msgbuf, MAX_BUFFER_SIZE, msg);
+    unsigned int len = strlen(msgbuf);
+    msgbuf[len++] = '\n';
 
-    write(_fd, msgbuf, strlen(msgbuf)); //file io is always 'blocking'
-    write(_fd, "\n", 1);
+    pthread_mutex_lock(&_lock);
+    append(msgbuf, len);
+    pthread_mutex_unlock(&_lock);
     return;
   }
+
+  void
+  FileTraceAppender::traceRecord(const TraceRecord&, const char* line,
+                                 unsigned int len)
+  {
+    pthread_mutex_lock(&_lock);
+    append(line, len);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  FileTraceAppender::flush()
+  {
+    pthread_mutex_lock(&_lock);
+    writeBuffer();
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  FileTraceAppender::endBatch()
+  {
+    //lines were copied, only write once the oldest is due.
+    pthread_mutex_lock(&_lock);
+    if(_used > 0 && monotonicNanos() - _firstLine >= _flushNanos){
+      writeBuffer();
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+  #define WPR_TRACING_RING_MIN_SIZE (64 * 1024)
+
+  MmapRingTraceAppender::MmapRingTraceAppender(const char * filename,
+                                               unsigned long long size)
+  :_fd(-1), _header(NULL), _data(NULL), _capacity(0), _mapSize(0)
+  {
+    pthread_mutex_init(&_lock, NULL);
+    if(size < WPR_TRACING_RING_MIN_SIZE){
+      size = WPR_TRACING_RING_MIN_SIZE;
+    }
+    unsigned long long capacity = (size + 4095) & ~4095ULL; //whole pages.
+    _fd = open(filename, O_RDWR|O_CREAT|O_CLOEXEC, 0644);
+    if(_fd == -1){
+      return;
+    }
+    size_t mapSize = WPR_TRACE_RING_HEADER_SIZE + capacity;
+    struct stat st;
+    bool reuse = fstat(_fd, &st) == 0 && (size_t)st.st_size == mapSize;
+    if(!reuse && (ftruncate(_fd, 0) != 0 || ftruncate(_fd, mapSize) != 0)){
+      close(_fd);
+      _fd = -1;
+      return;
+    }
+    void * map = mmap(NULL, mapSize, PROT_READ|PROT_WRITE, MAP_SHARED, _fd, 0);
+    if(map == MAP_FAILED){
+      close(_fd);
+      _fd = -1;
+      return;
+    }
+    RingHeader * header = (RingHeader *)map;
+    if(reuse){
+      //continue the ring of an earlier run if it is intact.
+      reuse = 0 == memcmp(header->magic, WPR_TRACE_RING_MAGIC, sizeof(header->magic))
+              && header->version == WPR_TRACE_RING_VERSION
+              && header->headerSize == WPR_TRACE_RING_HEADER_SIZE
+              && header->capacity == capacity
+              && header->tail <= header->head
+              && header->head - header->tail <= capacity;
+    }
+    if(!reuse){
+      memset(header, 0, sizeof(*header));
+      header->version = WPR_TRACE_RING_VERSION;
+      header->headerSize = WPR_TRACE_RING_HEADER_SIZE;
+      header->capacity = capacity;
+      memcpy(header->magic, WPR_TRACE_RING_MAGIC, sizeof(header->magic));
+    }
+    _header = header;
+    _data = (char *)map + WPR_TRACE_RING_HEADER_SIZE;
+    _capacity = capacity;
+    _mapSize = mapSize;
+  }
+
+  MmapRingTraceAppender::~MmapRingTraceAppender()
+  {
+    if(NULL != _header){
+      munmap(_header, _mapSize);
+    }
+    if(_fd != -1){
+      close(_fd);
+    }
+    pthread_mutex_destroy(&_lock);
+  }
+
+  int
+  MmapRingTraceAppender::getFd() const
+  {
+    return _fd;
+  }
+
+  void
+  MmapRingTraceAppender::makeRoom(unsigned long long head, unsigned int len)
+  {
+    //drop the oldest entries until [head, head + len) is free.
+    unsigned long long tail = _header->tail;
+    while(head + len - tail > _capacity){
+      unsigned long long pos = tail % _capacity;
+      uint32_t length = *(uint32_t *)(_data + pos);
+      tail += length == WPR_TRACE_RING_WRAP ? _capacity - pos : ringEntrySize(length);
+    }
+    __atomic_store_n(&_header->tail, tail, __ATOMIC_RELEASE);
+  }
+
+  void
+  MmapRingTraceAppender::append(const char * line, unsigned int len)
+  {
+    if(NULL == _header){
+      return;
+    }
+    unsigned long long head = _header->head;
+    unsigned long long pos = head % _capacity;
+    uint32_t size = ringEntrySize(len);
+    if(_capacity - pos < size){
+      //no room before the end of the data area, continue at its start.
+      makeRoom(head, _capacity - pos);
+      *(uint32_t *)(_data + pos) = WPR_TRACE_RING_WRAP;
+      head += _capacity - pos;
+      __atomic_store_n(&_header->head, head, __ATOMIC_RELEASE);
+      pos = 0;
+    }
+    makeRoom(head, size);
+    memcpy(_data + pos + sizeof(uint32_t), line, len);
+    *(uint32_t *)(_data + pos) = len;
+    __atomic_store_n(&_header->head, head + size, __ATOMIC_RELEASE);
+  }
+
+  void
+  MmapRingTraceAppender::traceInfo(const TraceMsg& msg)
+  {
+    char msgbuf[MAX_BUFFER_SIZE + 1] =
+      { 0 };
+
+    buildTraceMsg(msgbuf, MAX_BUFFER_SIZE, msg);
+    unsigned int len = strlen(msgbuf);
+    msgbuf[len++] = '\n';
+
+    pthread_mutex_lock(&_lock);
+    append(msgbuf, len);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  MmapRingTraceAppender::traceRecord(const TraceRecord&, const char* line,
+                                     unsigned int len)
+  {
+    pthread_mutex_lock(&_lock);
+    append(line, len);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  MmapRingTraceAppender::flush()
+  {
+    //the kernel writes the pages back even if the process dies, only
+    //nudge it (a crash of the machine still loses the latest lines).
+    if(NULL != _header){
+      msync(_header, _mapSize, MS_ASYNC);
+    }
+  }
+
+  void
+  MmapRingTraceAppender::endBatch()
+  {
+    //lines are in the ring already, nothing to write.
+  }
+
+  #define WPR_TRACING_BINARY_BUFFER_SIZE (64 * 1024)
+  #define WPR_TRACING_BINARY_CALLSITES   256 //initial callsite table size.
+
+  static __thread unsigned int traceThreadId = 0;
+
+  static
+  inline
+  unsigned int
+  currentThreadId()
+  {
+    if(0 == traceThreadId){
+      traceThreadId = syscall(SYS_gettid);
+    }
+    return traceThreadId;
+  }
+
+  BinaryTraceAppender::BinaryTraceAppender(const char * filename)
+  :_fd(-1), _callsites(WPR_TRACING_BINARY_CALLSITES), _callsiteCount(0),
+   _buf(NULL), _used(0)
+  {
+    pthread_mutex_init(&_lock, NULL);
+    _fd = open(filename, O_WRONLY|O_APPEND|O_CREAT, 0644);
+    if(_fd == -1){
+      return;
+    }
+    _buf = (char *)malloc(WPR_TRACING_BINARY_BUFFER_SIZE);
+
+    //start a session, it carries the clock calibration for the decoder.
+    const TraceClockInfo& clock = traceClockInfo();
+    BinarySession session;
+    memset(&session, 0, sizeof(session));
+    memcpy(session.magic, WPR_TRACE_BINARY_MAGIC, sizeof(session.magic));
+    session.version = WPR_TRACE_BINARY_VERSION;
+    session.hz = clock.hz;
+    session.baseTicks = clock.baseTicks;
+    session.baseSec = clock.baseTime.tv_sec;
+    session.baseUsec = clock.baseTime.tv_usec;
+    append(ENTRY_SESSION, 0, 0, clock.baseTicks, (const char *)&session,
+           sizeof(session));
+  }
+
+  BinaryTraceAppender::~BinaryTraceAppender()
+  {
+    if(_fd != -1){
+      flush();
+      close(_fd);
+    }
+    free(_buf);
+    pthread_mutex_destroy(&_lock);
+  }
+
+  int
+  BinaryTraceAppender::getFd() const
+  {
+    return _fd;
+  }
+
+  bool
+  BinaryTraceAppender::isBinary() const
+  {
+    return true;
+  }
+
+  void
+  BinaryTraceAppender::traceInfo(const TraceMsg& msg)
+  {
+    if(_fd == -1){
+      return;
+    }
+    unsigned long long ticks = traceClockNow();
+    char payload[MAX_BUFFER_SIZE];
+    va_list args;
+    va_copy(args, *((va_list *)msg.ap));
+    int len = encodeTraceArgs(payload, sizeof(payload), msg.format, args);
+    va_end(args);
+    unsigned int type = ENTRY_RECORD;
+    if(len < 0){
+      //not encodable, store the formatted message instead.
+      va_copy(args, *((va_list *)msg.ap));
+      len = vsnprintf(payload, sizeof(payload), msg.format, args);
+      va_end(args);
+      if(len < 0){
+        len = 0;
+      }else if(len >= (int)sizeof(payload)){
+        len = sizeof(payload) - 1;
+      }
+      type = ENTRY_TEXT;
+    }
+    pthread_mutex_lock(&_lock);
+    unsigned int callsite = getCallsite(msg.format, msg.srcfile, msg.function,
+                                        msg.line);
+    append(type, callsite, currentThreadId(), ticks, payload, len);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  BinaryTraceAppender::traceRecord(const TraceRecord& rec, const char*,
+                                   unsigned int)
+  {
+    if(_fd == -1){
+      return;
+    }
+    pthread_mutex_lock(&_lock);
+    unsigned int callsite = getCallsite(rec.format, rec.srcfile, rec.function,
+                                        rec.line);
+    append(rec.kind == TraceRecord::RECORD_ARGS ? ENTRY_RECORD : ENTRY_TEXT,
+           callsite, rec.tid, rec.ticks, rec.payload, rec.length);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  static
+  inline
+  unsigned int
+  hashCallsite(const char * format, const char * srcfile, int line)
+  {
+    //log statements pass string literals, so their addresses identify them.
+    unsigned long h = ((unsigned long)format * 31 + (unsigned long)srcfile) * 31
+                      + (unsigned long)line;
+    return h ^ (h >> 17);
+  }
+
+  //append s (NUL terminated, at most max bytes of it) to buf.
+  static
+  inline
+  void
+  appendString(std::vector<char>& buf, const char * s, unsigned int max)
+  {
+    if(s == NULL){
+      s = "";
+    }
+    unsigned int len = strlen(s);
+    buf.insert(buf.end(), s, s + (len < max ? len : max));
+    buf.push_back('\0');
+  }
+
+  unsigned int
+  BinaryTraceAppender::getCallsite(const char * format, const char * srcfile,
+                                   const char * function, int line)
+  {
+    unsigned int h = hashCallsite(format, srcfile, line);
+    unsigned int mask = _callsites.size() - 1;
+    unsigned int i = h & mask;
+    for(; _callsites[i].id != 0; i = (i + 1) & mask){
+      const Callsite& c = _callsites[i];
+      if(c.format == format && c.srcfile == srcfile && c.line == line
+         && c.function == function){
+        return c.id;
+      }
+    }
+
+    //first hit: keep the table at most half full.
+    if(2 * (_callsiteCount + 1) > _callsites.size()){
+      std::vector<Callsite> old(2 * _callsites.size());
+      old.swap(_callsites);
+      mask = _callsites.size() - 1;
+      for(unsigned int j = 0; j < old.size(); ++j){
+        if(old[j].id != 0){
+          unsigned int k = hashCallsite(old[j].format, old[j].srcfile,
+                                        old[j].line) & mask;
+          while(_callsites[k].id != 0){
+            k = (k + 1) & mask;
+          }
+          _callsites[k] = old[j];
+        }
+      }
+      for(i = h & mask; _callsites[i].id != 0; i = (i + 1) & mask){
+      }
+    }
+    Callsite& c = _callsites[i];
+    c.format = format;
+    c.srcfile = srcfile;
+    c.function = function;
+    c.line = line;
+    c.id = ++_callsiteCount;
+
+    //and describe it once in the file.
+    std::vector<char> desc(sizeof(int32_t));
+    int32_t line32 = line;
+    memcpy(&desc[0], &line32, sizeof(line32));
+    appendString(desc, srcfile, MAX_BUFFER_SIZE);
+    appendString(desc, function, MAX_BUFFER_SIZE);
+    appendString(desc, format, MAX_BUFFER_SIZE);
+    append(ENTRY_CALLSITE, c.id, 0, 0, &desc[0], desc.size());
+    return c.id;
+  }
+
+  void
+  BinaryTraceAppender::append(unsigned int type, unsigned int callsite,
+                              unsigned int tid, unsigned long long ticks,
+                              const char * payload, unsigned int len)
+  {
+    if(_buf == NULL){
+      return;
+    }
+    if(len > 0xffff){
+      len = 0xffff;
+    }
+    if(_used + sizeof(BinaryEntry) + len > WPR_TRACING_BINARY_BUFFER_SIZE){
+      writeBuffer();
+    }
+    BinaryEntry entry;
+    entry.type = type;
+    entry.length = len;
+    entry.callsite = callsite;
+    entry.tid = tid;
+    entry.reserved = 0;
+    entry.ticks = ticks;
+    memcpy(_buf + _used, &entry, sizeof(entry));
+    memcpy(_buf + _used + sizeof(entry), payload, len);
+    _used += sizeof(entry) + len;
+  }
+
+  void
+  BinaryTraceAppender::writeBuffer()
+  {
+    unsigned int done = 0;
+    while(done < _used){
+      ssize_t n = write(_fd, _buf + done, _used - done);
+      if(n < 0){
+        if(errno == EINTR){
+          continue;
+        }
+        break; //give up on this buffer.
+      }
+      done += n;
+    }
+    _used = 0;
+  }
+
+  void
+  BinaryTraceAppender::flush()
+  {
+    pthread_mutex_lock(&_lock);
+    if(_used > 0){
+      writeBuffer();
+    }
+    pthread_mutex_unlock(&_lock);
+  }
 }
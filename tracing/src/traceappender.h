@@ -1,18 +1,77 @@
 #ifndef __WPR_TRACEAPPENDER_H__
 #define __WPR_TRACEAPPENDER_H__
 
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include "tracing.h"
+
 #define MAX_BUFFER_SIZE 1024
+#define WPR_TRACING_MAX_IOV 1024
 namespace wpr_tracing
 {
   class TraceMsg;
+  struct TraceRecord;
+  struct RingHeader;
+
+  //format "<timestamp> (<srcfile>:<line>): " into buf, returns its length.
+  int
+  buildTraceHeader(char* buf, int buf_size, const struct timeval& now,
+                   const char* srcfile, const int line);
+
   class TraceAppender
   {
   public:
-    virtual ~TraceAppender(){}; //a trival virtual destrcutor to make sure 
-                                //decendant class can be properly destrcuted.
+    TraceAppender();
+    virtual ~TraceAppender(); //virtual to make sure decendant class can be
+                              //properly destrcuted.
     virtual
     void
     traceInfo(const TraceMsg& msg) = 0;
+
+    //async path: take a record drained by the writer thread. text
+    //appenders queue its formatted line (see queueLine()).
+    virtual
+    void
+    traceRecord(const TraceRecord& rec, const char* line, unsigned int len);
+
+    //binary appenders do not need the formatted line of a record.
+    virtual
+    bool
+    isBinary() const;
+
+    //async path: queue an already formatted line (including the newline).
+    //the line must stay valid until flush() is called.
+    void
+    queueLine(const char* line, unsigned int len);
+
+    //write all queued lines with as few writev() calls as possible.
+    virtual
+    void
+    flush();
+
+    //async path: the writer is about to reuse the buffer of its batch.
+    //appenders which keep pointers into it (queueLine()) must write now,
+    //appenders with their own buffer may wait. defaults to flush().
+    virtual
+    void
+    endBatch();
+
+  protected:
+    virtual
+    int
+    getFd() const = 0;
+
+  private:
+    //caller holds _pendingLock.
+    void
+    writePending();
+
+    //the writer thread queues lines while wpr_log_flush() may flush them.
+    pthread_mutex_t _pendingLock;   //protects _pending.
+    std::vector<struct iovec> _pending;
   };
 
   class ConsoleTraceAppender : public TraceAppender
@@ -20,17 +79,166 @@ namespace wpr_tracing
   public:
     void
     traceInfo(const TraceMsg& msg);
+  protected:
+    int
+    getFd() const;
   };
 
+  /**
+   * FileTraceAppender collects lines in a large buffer and writes it when
+   * it is full or its oldest line is older than flushMillis, so a busy
+   * peer costs one write() per buffer instead of one per message. The
+   * file is rotated by size and/or age (filename -> filename.1 -> ...),
+   * always between two buffer writes and so between two lines.
+   */
   class FileTraceAppender : public TraceAppender
   {
   public:
-    FileTraceAppender(const char * filename);
+    FileTraceAppender(const char * filename,
+                      const struct wpr_log_fileOptions * options = NULL);
     ~FileTraceAppender();
     void
     traceInfo(const TraceMsg& msg);
+
+    void
+    traceRecord(const TraceRecord& rec, const char* line, unsigned int len);
+
+    void
+    flush();
+
+    void
+    endBatch();
+  protected:
+    int
+    getFd() const;
   private:
+    //caller holds _lock for all of these.
+    void
+    append(const char * line, unsigned int len);
+
+    void
+    writeBuffer();
+
+    bool
+    openFile();
+
+    void
+    rotate();
+
+    std::string _filename;
+    unsigned int _bufferSize;
+    unsigned long long _flushNanos;
+    unsigned long long _rotateBytes;
+    unsigned long long _rotateNanos;
+    unsigned int _keepFiles;
+    unsigned long long _preallocate;
+
+    int _fd;
+    pthread_mutex_t _lock;           //protects all fields below.
+    char * _buf;
+    unsigned int _used;
+    unsigned long long _firstLine;   //monotonic ns of the oldest buffered line.
+    unsigned long long _opened;      //monotonic ns the file was opened.
+    unsigned long long _size;        //current size of the file.
+    unsigned long long _reserved;    //file space allocated up to here.
+  };
+
+  /**
+   * MmapRingTraceAppender is a flight recorder: it keeps the most recent
+   * formatted lines in a fixed size ring inside a memory mapped file.
+   * Logging is a memcpy (no syscall), and as the pages belong to the
+   * file, the ring survives a crash of the process. A restarted process
+   * continues the existing ring. Use wpr_ring_dump to read it, see
+   * tracering.h for the layout.
+   */
+  class MmapRingTraceAppender : public TraceAppender
+  {
+  public:
+    MmapRingTraceAppender(const char * filename, unsigned long long size);
+    ~MmapRingTraceAppender();
+    void
+    traceInfo(const TraceMsg& msg);
+
+    void
+    traceRecord(const TraceRecord& rec, const char* line, unsigned int len);
+
+    void
+    flush();
+
+    void
+    endBatch();
+  protected:
+    int
+    getFd() const;
+  private:
+    //caller holds _lock.
+    void
+    append(const char * line, unsigned int len);
+
+    void
+    makeRoom(unsigned long long head, unsigned int len);
+
+    int _fd;
+    pthread_mutex_t _lock;      //serialises writers.
+    struct RingHeader * _header;
+    char * _data;
+    unsigned long long _capacity;
+    size_t _mapSize;
+  };
+
+  /**
+   * BinaryTraceAppender writes records instead of text: each log
+   * statement is described once by a callsite entry (file, line, format),
+   * afterwards its records only carry the callsite id, a clock tick
+   * timestamp, the thread id and the raw arguments. Formatting is left to
+   * the wpr_trace_decode tool. See tracebinary.h for the file layout.
+   */
+  class BinaryTraceAppender : public TraceAppender
+  {
+  public:
+    BinaryTraceAppender(const char * filename);
+    ~BinaryTraceAppender();
+    void
+    traceInfo(const TraceMsg& msg);
+
+    void
+    traceRecord(const TraceRecord& rec, const char* line, unsigned int len);
+
+    bool
+    isBinary() const;
+
+    void
+    flush();
+  protected:
+    int
+    getFd() const;
+  private:
+    struct Callsite
+    {
+      const char * format;
+      const char * srcfile;
+      const char * function;
+      int line;
+      unsigned int id;      //0 for an empty slot.
+    };
+
+    unsigned int
+    getCallsite(const char * format, const char * srcfile,
+                const char * function, int line);
+
+    void
+    append(unsigned int type, unsigned int callsite, unsigned int tid,
+           unsigned long long ticks, const char * payload, unsigned int len);
+
+    void
+    writeBuffer();
+
     int _fd;
+    pthread_mutex_t _lock;            //protects all fields below.
+    std::vector<Callsite> _callsites; //open addressing, size is a power of 2.
+    unsigned int _callsiteCount;
+    char * _buf;
+    unsigned int _used;
   };
 }
 
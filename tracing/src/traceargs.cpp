@@ -0,0 +1,313 @@
+#include "traceargs.h"
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace wpr_tracing
+{
+  /*
+   * Argument encoding.
+   *
+   * The caller walks the printf format once and copies each argument
+   * value with its exact type into a buffer (strings by value, since they
+   * may be gone when the buffer is formatted). Formatting walks the format
+   * again and feeds each conversion with its value to snprintf(). Formats
+   * the encoder does not understand (%n, %m, wide strings, positional
+   * arguments) or arguments which do not fit into the buffer have to be
+   * formatted right away by the caller instead.
+   */
+  enum ArgType
+  {
+    ARG_BAD,
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_INTMAX,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_STRING,
+    ARG_POINTER
+  };
+
+  struct ConvSpec
+  {
+    unsigned int length; //length of the conversion including '%'.
+    int stars;           //number of '*' width/precision arguments.
+    int precision;       //-1 if none, -2 if taken from the last '*' argument.
+    ArgType type;
+  };
+
+  #define WPR_TRACING_MAX_CONV 32
+
+  //parse the conversion starting at p[0] == '%' (but not "%%").
+  static
+  bool
+  parseConv(const char * p, ConvSpec& spec)
+  {
+    const char * q = p + 1;
+    spec.stars = 0;
+    spec.precision = -1;
+    spec.type = ARG_BAD;
+    while(*q != '\0' && strchr("-+ #0'", *q) != NULL){
+      ++q;
+    }
+    if(*q == '*'){
+      ++spec.stars;
+      ++q;
+    }else{
+      while(*q >= '0' && *q <= '9') ++q;
+    }
+    if(*q == '.'){
+      ++q;
+      if(*q == '*'){
+        ++spec.stars;
+        spec.precision = -2;
+        ++q;
+      }else{
+        spec.precision = 0;
+        while(*q >= '0' && *q <= '9'){
+          if(spec.precision < 0xffff){
+            spec.precision = spec.precision * 10 + (*q - '0');
+          }
+          ++q;
+        }
+      }
+    }
+    char len = 0;
+    switch(*q){
+      case 'h': ++q; if(*q == 'h') ++q; len = 'h'; break;
+      case 'l': ++q; if(*q == 'l'){ ++q; len = 'q'; }else{ len = 'l'; } break;
+      case 'q': ++q; len = 'q'; break;
+      case 'L': ++q; len = 'L'; break;
+      case 'z': ++q; len = 'z'; break;
+      case 'j': ++q; len = 'j'; break;
+      case 't': ++q; len = 't'; break;
+      default: break;
+    }
+    switch(*q){
+      case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+        switch(len){
+          case 0: case 'h': spec.type = ARG_INT; break;
+          case 'l': spec.type = ARG_LONG; break;
+          case 'q': spec.type = ARG_LLONG; break;
+          case 'z': spec.type = ARG_SIZE; break;
+          case 'j': spec.type = ARG_INTMAX; break;
+          case 't': spec.type = ARG_PTRDIFF; break;
+          default: break;
+        }
+        break;
+      case 'c':
+        if(len == 0) spec.type = ARG_INT;
+        break;
+      case 'e': case 'E': case 'f': case 'F':
+      case 'g': case 'G': case 'a': case 'A':
+        if(len == 0 || len == 'l') spec.type = ARG_DOUBLE;
+        else if(len == 'L') spec.type = ARG_LDOUBLE;
+        break;
+      case 's':
+        if(len == 0) spec.type = ARG_STRING;
+        break;
+      case 'p':
+        if(len == 0) spec.type = ARG_POINTER;
+        break;
+      default:
+        break;
+    }
+    spec.length = q - p + 1;
+    return spec.type != ARG_BAD && spec.length < WPR_TRACING_MAX_CONV;
+  }
+
+  template <typename T>
+  static
+  inline
+  bool
+  putArg(char *& p, char * end, T value)
+  {
+    if(p + sizeof(T) > end){
+      return false;
+    }
+    memcpy(p, &value, sizeof(T));
+    p += sizeof(T);
+    return true;
+  }
+
+  template <typename T>
+  static
+  inline
+  bool
+  getArg(const char *& p, const char * end, T& value)
+  {
+    if(p + sizeof(T) > end){
+      return false;
+    }
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+  }
+
+  int
+  encodeTraceArgs(char * buf, unsigned int size, const char * format, va_list ap)
+  {
+    char * p = buf;
+    char * end = buf + size;
+    ConvSpec spec;
+    for(const char * f = format; *f != '\0'; ++f){
+      if(*f != '%'){
+        continue;
+      }
+      if(f[1] == '%'){
+        ++f;
+        continue;
+      }
+      if(!parseConv(f, spec)){
+        return -1;
+      }
+      f += spec.length - 1;
+      int star = 0;
+      for(int i = 0; i < spec.stars; ++i){
+        star = va_arg(ap, int);
+        if(!putArg(p, end, star)) return -1;
+      }
+      if(spec.precision == -2){
+        spec.precision = star < 0 ? -1 : star; //negative means none.
+      }
+      bool ok = false;
+      switch(spec.type){
+        case ARG_INT:     ok = putArg(p, end, va_arg(ap, int)); break;
+        case ARG_LONG:    ok = putArg(p, end, va_arg(ap, long)); break;
+        case ARG_LLONG:   ok = putArg(p, end, va_arg(ap, long long)); break;
+        case ARG_SIZE:    ok = putArg(p, end, va_arg(ap, size_t)); break;
+        case ARG_INTMAX:  ok = putArg(p, end, va_arg(ap, intmax_t)); break;
+        case ARG_PTRDIFF: ok = putArg(p, end, va_arg(ap, ptrdiff_t)); break;
+        case ARG_DOUBLE:  ok = putArg(p, end, va_arg(ap, double)); break;
+        case ARG_LDOUBLE: ok = putArg(p, end, va_arg(ap, long double)); break;
+        case ARG_POINTER: ok = putArg(p, end, va_arg(ap, void *)); break;
+        case ARG_STRING:
+          {
+            const char * s = va_arg(ap, const char *);
+            if(s == NULL){
+              s = "(null)";
+            }
+            //with a precision s need not be terminated (%.*s of a buffer).
+            size_t len = spec.precision < 0 ? strlen(s) :
+                         strnlen(s, spec.precision);
+            if(p + sizeof(unsigned short) + len + 1 > end){
+              return -1;
+            }
+            putArg(p, end, (unsigned short)len);
+            memcpy(p, s, len);
+            p[len] = '\0';
+            p += len + 1;
+            ok = true;
+          }
+          break;
+        default:
+          break;
+      }
+      if(!ok){
+        return -1;
+      }
+    }
+    return p - buf;
+  }
+
+  template <typename T>
+  static
+  inline
+  int
+  formatArg(char * out, size_t size, const char * conv, int stars,
+            const int * star, T value)
+  {
+    switch(stars){
+      case 0: return snprintf(out, size, conv, value);
+      case 1: return snprintf(out, size, conv, star[0], value);
+      default: return snprintf(out, size, conv, star[0], star[1], value);
+    }
+  }
+
+  //decode one value of type T and format it with the conversion conv.
+  template <typename T>
+  static
+  inline
+  bool
+  decodeArg(const char *& p, const char * end, char * out, size_t size,
+            const char * conv, int stars, const int * star, int& m)
+  {
+    T value;
+    if(!getArg(p, end, value)){
+      return false;
+    }
+    m = formatArg(out, size, conv, stars, star, value);
+    return true;
+  }
+
+  unsigned int
+  decodeTraceArgs(const char * format, const char * args, unsigned int length,
+                  char * out, unsigned int size)
+  {
+    const char * p = args;
+    const char * end = args + length;
+    unsigned int n = 0;
+    char conv[WPR_TRACING_MAX_CONV];
+    ConvSpec spec;
+    for(const char * f = format; *f != '\0' && n < size - 1; ++f){
+      if(*f != '%'){
+        out[n++] = *f;
+        continue;
+      }
+      if(f[1] == '%'){
+        out[n++] = '%';
+        ++f;
+        continue;
+      }
+      if(!parseConv(f, spec)){
+        break; //not produced by encodeTraceArgs().
+      }
+      memcpy(conv, f, spec.length);
+      conv[spec.length] = '\0';
+      f += spec.length - 1;
+      int star[2] = { 0, 0 };
+      bool ok = true;
+      for(int i = 0; i < spec.stars && ok; ++i){
+        ok = getArg(p, end, star[i]);
+      }
+      char * o = out + n;
+      size_t room = size - n;
+      int m = 0;
+      switch(spec.type){
+        case ARG_INT:     ok = ok && decodeArg<int>(p, end, o, room, conv, spec.stars, star, m); break;
+        case ARG_LONG:    ok = ok && decodeArg<long>(p, end, o, room, conv, spec.stars, star, m); break;
+        case ARG_LLONG:   ok = ok && decodeArg<long long>(p, end, o, room, conv, spec.stars, star, m); break;
+        case ARG_SIZE:    ok = ok && decodeArg<size_t>(p, end, o, room, conv, spec.stars, star, m); break;
+        case ARG_INTMAX:  ok = ok && decodeArg<intmax_t>(p, end, o, room, conv, spec.stars, star, m); break;
+        case ARG_PTRDIFF: ok = ok && decodeArg<ptrdiff_t>(p, end, o, room, conv, spec.stars, star, m); break;
+        case ARG_DOUBLE:  ok = ok && decodeArg<double>(p, end, o, room, conv, spec.stars, star, m); break;
+        case ARG_LDOUBLE: ok = ok && decodeArg<long double>(p, end, o, room, conv, spec.stars, star, m); break;
+        case ARG_POINTER: ok = ok && decodeArg<void *>(p, end, o, room, conv, spec.stars, star, m); break;
+        case ARG_STRING:
+          {
+            unsigned short len = 0;
+            ok = ok && getArg(p, end, len) && p + len + 1 <= end && p[len] == '\0';
+            if(ok){
+              m = formatArg(o, room, conv, spec.stars, star, p);
+              p += len + 1;
+            }
+          }
+          break;
+        default:
+          break;
+      }
+      if(!ok){
+        break; //truncated or corrupted arguments.
+      }
+      if(m > 0){
+        n += ((size_t)m < room) ? (unsigned int)m : (unsigned int)room - 1;
+      }
+    }
+    out[n] = '\0';
+    return n;
+  }
+}
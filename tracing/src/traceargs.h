@@ -0,0 +1,18 @@
+#ifndef __WPR_TRACEARGS_H__
+#define __WPR_TRACEARGS_H__
+#include <cstdarg>
+
+namespace wpr_tracing
+{
+  //copy the arguments of format from ap into buf, returns the used length
+  //or -1 if they can not be encoded (then format them right away).
+  int
+  encodeTraceArgs(char * buf, unsigned int size, const char * format, va_list ap);
+
+  //format the arguments encoded by encodeTraceArgs() with format into
+  //out (always NUL terminated), returns the length of the text.
+  unsigned int
+  decodeTraceArgs(const char * format, const char * args, unsigned int length,
+                  char * out, unsigned int size);
+}
+#endif
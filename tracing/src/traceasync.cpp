@@ -0,0 +1,372 @@
+#include "traceasync.h"
+#include "traceappender.h"
+#include "tracemanager.h"
+#include "tracepeer.h"
+#include "traceargs.h"
+#include "traceclock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace wpr_tracing
+{
+  AsyncTraceWriter* AsyncTraceWriter::_instance = NULL;
+  pthread_once_t AsyncTraceWriter::_once = PTHREAD_ONCE_INIT;
+  int AsyncTraceWriter::_enabled = 0;
+
+  TraceRing::TraceRing(unsigned int size)
+  :_head(0), _unreported(0), _droppedPeer(NULL), _tail(0), _dropped(0), _closed(0),
+   _mask(size - 1), _tid(syscall(SYS_gettid))
+  {
+    _records = new TraceRecord[size];
+  }
+
+  TraceRing::~TraceRing()
+  {
+    delete [] _records;
+  }
+
+  AsyncTraceWriter *
+  AsyncTraceWriter::getInstance()
+  {
+    pthread_once(&_once, createInstance);
+    return _instance;
+  }
+
+  void
+  AsyncTraceWriter::createInstance()
+  {
+    _instance = new AsyncTraceWriter();
+  }
+
+  AsyncTraceWriter::AsyncTraceWriter()
+  :_retiredDropped(0), _ringSize(WPR_TRACING_ASYNC_RING_SIZE),
+   _running(false), _stopRequested(false), _wakeRequested(false),
+   _flushRequested(0), _flushDone(0), _arena(NULL), _arenaUsed(0),
+   _unflushed(false)
+  {
+    pthread_key_create(&_ringKey, releaseRing);
+    pthread_mutex_init(&_ringsLock, NULL);
+    pthread_mutex_init(&_lock, NULL);
+    pthread_cond_init(&_wakeCond, NULL);
+    pthread_cond_init(&_flushedCond, NULL);
+  }
+
+  int
+  AsyncTraceWriter::start(unsigned int ringSize)
+  {
+    if(ringSize == 0){
+      ringSize = WPR_TRACING_ASYNC_RING_SIZE;
+    }
+    traceClockInfo(); //calibrate before the first record is pushed.
+    unsigned int size = 2;
+    while(size < ringSize){
+      size <<= 1; //rings are indexed by mask.
+    }
+    pthread_mutex_lock(&_lock);
+    _ringSize = size; //applies to rings created from now on.
+    if(_running){
+      pthread_mutex_unlock(&_lock);
+      return 0;
+    }
+    if(NULL == _arena){
+      _arena = (char *)malloc(WPR_TRACING_ASYNC_ARENA_SIZE);
+    }
+    _stopRequested = false;
+    if(NULL == _arena || 0 != pthread_create(&_thread, NULL, launch, this)){
+      pthread_mutex_unlock(&_lock);
+      return -1;
+    }
+    _running = true;
+    __atomic_store_n(&_enabled, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&_lock);
+    return 0;
+  }
+
+  void
+  AsyncTraceWriter::stop()
+  {
+    pthread_mutex_lock(&_lock);
+    if(!_running){
+      pthread_mutex_unlock(&_lock);
+      return;
+    }
+    __atomic_store_n(&_enabled, 0, __ATOMIC_RELEASE);
+    _stopRequested = true;
+    pthread_cond_signal(&_wakeCond);
+    pthread_mutex_unlock(&_lock);
+    pthread_join(_thread, NULL); //the writer drains all rings before it exits.
+    pthread_mutex_lock(&_lock);
+    _running = false;
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  AsyncTraceWriter::flush()
+  {
+    pthread_mutex_lock(&_lock);
+    if(_running){
+      unsigned long ticket = ++_flushRequested;
+      pthread_cond_signal(&_wakeCond);
+      while(_running && _flushDone < ticket){
+        pthread_cond_wait(&_flushedCond, &_lock);
+      }
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+  unsigned long
+  AsyncTraceWriter::getDroppedCount()
+  {
+    pthread_mutex_lock(&_ringsLock);
+    unsigned long dropped = _retiredDropped;
+    for(std::list<TraceRing *>::iterator it = _rings.begin();
+        it != _rings.end();
+        ++it){
+      dropped += __atomic_load_n(&(*it)->_dropped, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&_ringsLock);
+    return dropped;
+  }
+
+  TraceRing *
+  AsyncTraceWriter::getRing()
+  {
+    TraceRing * ring = (TraceRing *)pthread_getspecific(_ringKey);
+    if(NULL == ring){
+      ring = new TraceRing(_ringSize);
+      pthread_setspecific(_ringKey, ring);
+      pthread_mutex_lock(&_ringsLock);
+      _rings.push_back(ring);
+      pthread_mutex_unlock(&_ringsLock);
+    }
+    return ring;
+  }
+
+  void
+  AsyncTraceWriter::releaseRing(void * ring)
+  {
+    //the writer thread frees the ring once it has drained it.
+    __atomic_store_n(&((TraceRing *)ring)->_closed, 1, __ATOMIC_RELEASE);
+  }
+
+  void
+  AsyncTraceWriter::push(TracePeer * peer, const char * srcfile, const int line,
+                         const char * function, const char * format, va_list ap)
+  {
+    TraceRing * ring = getRing();
+    unsigned long head = ring->_head;
+    unsigned long used = head - __atomic_load_n(&ring->_tail, __ATOMIC_ACQUIRE);
+    if(used > ring->_mask){
+      //ring is full: drop instead of blocking the caller.
+      ++ring->_unreported;
+      ring->_droppedPeer = peer;
+      __atomic_store_n(&ring->_dropped, ring->_dropped + 1, __ATOMIC_RELAXED);
+      return;
+    }
+    TraceRecord& rec = ring->_records[head & ring->_mask];
+    rec.peer = peer;
+    rec.srcfile = srcfile;
+    rec.function = function;
+    rec.format = format;
+    rec.line = line;
+    rec.dropped = ring->_unreported;
+    rec.tid = ring->_tid;
+    rec.ticks = traceClockNow();
+    va_list args;
+    va_copy(args, ap);
+    int len = encodeTraceArgs(rec.payload, sizeof(rec.payload), format, args);
+    va_end(args);
+    if(len >= 0){
+      rec.kind = TraceRecord::RECORD_ARGS;
+      rec.length = len;
+    }else{
+      va_copy(args, ap);
+      int n = vsnprintf(rec.payload, sizeof(rec.payload), format, args);
+      va_end(args);
+      if(n < 0){
+        n = 0;
+      }else if((size_t)n >= sizeof(rec.payload)){
+        n = sizeof(rec.payload) - 1;
+      }
+      rec.kind = TraceRecord::RECORD_TEXT;
+      rec.length = n;
+    }
+    ring->_unreported = 0;
+    __atomic_store_n(&ring->_head, head + 1, __ATOMIC_RELEASE);
+    if(used == (ring->_mask + 1) / 2){
+      //just went past half full: don't let the writer sleep until it drops,
+      //and give it the cpu in case it shares ours.
+      wake();
+      sched_yield();
+    }
+  }
+
+  void
+  AsyncTraceWriter::wake()
+  {
+    pthread_mutex_lock(&_lock);
+    _wakeRequested = true;
+    pthread_cond_signal(&_wakeCond);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void *
+  AsyncTraceWriter::launch(void * writer)
+  {
+    ((AsyncTraceWriter *)writer)->run();
+    return NULL;
+  }
+
+  void
+  AsyncTraceWriter::run()
+  {
+    pthread_mutex_lock(&_lock);
+    for(;;){
+      unsigned long ticket = _flushRequested;
+      bool stopping = _stopRequested;
+      pthread_mutex_unlock(&_lock);
+
+      unsigned int drained = drain();
+      flushArena();
+
+      pthread_mutex_lock(&_lock);
+      _flushDone = ticket;
+      pthread_cond_broadcast(&_flushedCond);
+      if(stopping){
+        break;
+      }
+      //keep going while busy, else collect a batch for a while.
+      if(drained * 4 < _ringSize && !_wakeRequested
+         && _flushRequested == ticket && !_stopRequested){
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += WPR_TRACING_ASYNC_INTERVAL_MS * 1000000L;
+        if(until.tv_nsec >= 1000000000L){
+          until.tv_sec += 1;
+          until.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&_wakeCond, &_lock, &until);
+      }
+      _wakeRequested = false;
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+  unsigned int
+  AsyncTraceWriter::drain()
+  {
+    unsigned int drained = 0;
+    pthread_mutex_lock(&_ringsLock);
+    std::list<TraceRing *>::iterator it = _rings.begin();
+    while(it != _rings.end()){
+      TraceRing * ring = *it;
+      int closed = __atomic_load_n(&ring->_closed, __ATOMIC_ACQUIRE);
+      unsigned long head = __atomic_load_n(&ring->_head, __ATOMIC_ACQUIRE);
+      unsigned long tail = ring->_tail;
+      for(; tail != head; ++tail){
+        formatRecord(ring->_records[tail & ring->_mask]);
+        if((tail & 63) == 63){
+          //let the owner reuse records while a long backlog is formatted.
+          __atomic_store_n(&ring->_tail, tail + 1, __ATOMIC_RELEASE);
+        }
+        ++drained;
+      }
+      __atomic_store_n(&ring->_tail, tail, __ATOMIC_RELEASE);
+      if(closed){
+        if(ring->_unreported > 0){
+          //the thread exited right after dropping, report it here.
+          const TraceRecord& last = ring->_records[(tail - 1) & ring->_mask];
+          if(_arenaUsed + MAX_BUFFER_SIZE > WPR_TRACING_ASYNC_ARENA_SIZE){
+            flushArena();
+          }
+          formatDropped(ring->_droppedPeer, traceClockNow(), ring->_tid,
+                        last.srcfile, last.line, ring->_unreported);
+        }
+        _retiredDropped += ring->_dropped;
+        it = _rings.erase(it);
+        delete ring;
+      }else{
+        ++it;
+      }
+    }
+    pthread_mutex_unlock(&_ringsLock);
+    return drained;
+  }
+
+  void
+  AsyncTraceWriter::formatDropped(TracePeer * peer, unsigned long long ticks,
+                                  unsigned int tid, const char * srcfile,
+                                  const int line, unsigned int dropped)
+  {
+    TraceRecord notice;
+    notice.peer = peer;
+    notice.srcfile = srcfile;
+    notice.function = "";
+    notice.format = "";
+    notice.ticks = ticks;
+    notice.tid = tid;
+    notice.line = line;
+    notice.dropped = 0;
+    notice.kind = TraceRecord::RECORD_TEXT;
+    notice.length = snprintf(notice.payload, sizeof(notice.payload),
+                             "%u trace records dropped", dropped);
+    emitRecord(notice);
+  }
+
+  void
+  AsyncTraceWriter::formatRecord(const TraceRecord & rec)
+  {
+    //each record takes at most two lines of MAX_BUFFER_SIZE bytes.
+    if(_arenaUsed + 2 * MAX_BUFFER_SIZE > WPR_TRACING_ASYNC_ARENA_SIZE){
+      flushArena();
+    }
+    if(rec.dropped > 0){
+      formatDropped(rec.peer, rec.ticks, rec.tid, rec.srcfile, rec.line,
+                    rec.dropped);
+    }
+    emitRecord(rec);
+  }
+
+  void
+  AsyncTraceWriter::emitRecord(const TraceRecord & rec)
+  {
+    char * p = NULL;
+    unsigned int n = 0;
+    if(rec.peer->hasTextAppender()){
+      //format only when some appender wants text.
+      struct timeval timestamp;
+      traceClockToTimeval(traceClockInfo(), rec.ticks, timestamp);
+      p = _arena + _arenaUsed;
+      n = buildTraceHeader(p, MAX_BUFFER_SIZE, timestamp, rec.srcfile, rec.line);
+      if(rec.kind == TraceRecord::RECORD_TEXT){
+        unsigned int len = rec.length < MAX_BUFFER_SIZE - 1 - n ?
+                           rec.length : MAX_BUFFER_SIZE - 1 - n;
+        memcpy(p + n, rec.payload, len);
+        n += len;
+      }else{
+        n += decodeTraceArgs(rec.format, rec.payload, rec.length,
+                             p + n, MAX_BUFFER_SIZE - n);
+      }
+      p[n++] = '\n';
+      _arenaUsed += n;
+    }
+    rec.peer->traceRecord(rec, p, n);
+    _unflushed = true;
+  }
+
+  void
+  AsyncTraceWriter::flushArena()
+  {
+    if(_unflushed){
+      TraceManager::getInstance()->endBatch();
+      _arenaUsed = 0;
+      _unflushed = false;
+    }
+  }
+}
@@ -0,0 +1,170 @@
+#ifndef __WPR_TRACEASYNC_H__
+#define __WPR_TRACEASYNC_H__
+#include <cstdarg>
+#include <list>
+#include <pthread.h>
+
+#define WPR_TRACING_ASYNC_RING_SIZE       512  //default records per thread ring.
+#define WPR_TRACING_ASYNC_PAYLOAD_SIZE    448  //bytes for encoded arguments.
+#define WPR_TRACING_ASYNC_ARENA_SIZE      (64 * 1024) //writer batch buffer.
+#define WPR_TRACING_ASYNC_INTERVAL_MS     5    //writer sleep when idle.
+#define WPR_TRACING_CACHELINE             64
+
+namespace wpr_tracing
+{
+  class TracePeer;
+
+  /**
+   * TraceRecord is the compact form of one log call. Instead of the
+   * formatted message it keeps the raw argument values (strings are
+   * copied), the formatting is done later by the writer thread.
+   */
+  struct TraceRecord
+  {
+    enum
+    {
+      RECORD_ARGS = 0, //payload holds encoded arguments for format.
+      RECORD_TEXT = 1  //payload holds the already formatted message.
+    };
+    TracePeer * peer;
+    const char * srcfile;
+    const char * function;
+    const char * format;
+    unsigned long long ticks;   //see traceClockNow().
+    unsigned int tid;
+    int line;
+    unsigned int dropped;   //records dropped by this thread right before.
+    unsigned short kind;
+    unsigned short length;  //used payload bytes.
+    char payload[WPR_TRACING_ASYNC_PAYLOAD_SIZE];
+  };
+
+  /**
+   * TraceRing is a single producer/single consumer ring of records.
+   * The owning thread only moves _head, the writer thread only moves
+   * _tail, so neither side needs a lock.
+   */
+  struct TraceRing
+  {
+    TraceRing(unsigned int size);
+    ~TraceRing();
+
+    unsigned long _head;       //next record to fill, owner thread.
+    unsigned int _unreported;  //drops not yet attached to a record.
+    TracePeer * _droppedPeer;  //peer of the last dropped record.
+    char _pad0[WPR_TRACING_CACHELINE];
+    unsigned long _tail;       //next record to format, writer thread.
+    char _pad1[WPR_TRACING_CACHELINE];
+    unsigned long _dropped;    //total records dropped because ring was full.
+    int _closed;               //owner thread has exited.
+    unsigned int _mask;
+    unsigned int _tid;         //kernel thread id of the owner.
+    TraceRecord * _records;
+  };
+
+  /**
+   * AsyncTraceWriter moves formatting and I/O off the calling threads.
+   * wpr_log() pushes a TraceRecord into the ring of the calling thread
+   * and returns. A background thread drains all rings, formats the
+   * records into a batch buffer and hands them to the appenders, which
+   * write each batch with a single writev(). When a ring is full the
+   * record is dropped and counted (bounded memory, callers never block).
+   */
+  class AsyncTraceWriter
+  {
+  public:
+    static
+    AsyncTraceWriter *
+    getInstance();
+
+    static
+    inline
+    bool
+    isEnabled()
+    {
+      return __atomic_load_n(&_enabled, __ATOMIC_RELAXED) != 0;
+    }
+
+    int
+    start(unsigned int ringSize);
+
+    void
+    stop();
+
+    void
+    flush();
+
+    unsigned long
+    getDroppedCount();
+
+    void
+    push(TracePeer * peer, const char * srcfile, const int line,
+         const char * function, const char * format, va_list ap);
+
+  private:
+    AsyncTraceWriter(); //singleton
+
+    static
+    void
+    createInstance();
+
+    TraceRing *
+    getRing();
+
+    static
+    void
+    releaseRing(void * ring);
+
+    static
+    void *
+    launch(void * writer);
+
+    void
+    run();
+
+    //called by a producer whose ring is getting full.
+    void
+    wake();
+
+    unsigned int
+    drain();
+
+    void
+    formatRecord(const TraceRecord & rec);
+
+    void
+    formatDropped(TracePeer * peer, unsigned long long ticks, unsigned int tid,
+                  const char * srcfile, const int line, unsigned int dropped);
+
+    void
+    emitRecord(const TraceRecord & rec);
+
+    void
+    flushArena();
+
+    static AsyncTraceWriter * _instance;
+    static pthread_once_t _once;
+    static int _enabled;
+
+    pthread_key_t _ringKey;
+    pthread_mutex_t _ringsLock;      //protects _rings and _retiredDropped.
+    std::list<TraceRing *> _rings;
+    unsigned long _retiredDropped;   //drops of already released rings.
+    unsigned int _ringSize;
+
+    pthread_mutex_t _lock;           //protects the fields below.
+    pthread_cond_t _wakeCond;
+    pthread_cond_t _flushedCond;
+    pthread_t _thread;
+    bool _running;
+    bool _stopRequested;
+    bool _wakeRequested;             //a ring is more than half full.
+    unsigned long _flushRequested;
+    unsigned long _flushDone;
+
+    char * _arena;                   //writer thread only.
+    unsigned int _arenaUsed;
+    bool _unflushed;                 //appenders got records since last flush.
+  };
+}
+#endif
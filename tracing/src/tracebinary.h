@@ -0,0 +1,52 @@
+#ifndef __WPR_TRACEBINARY_H__
+#define __WPR_TRACEBINARY_H__
+#include <stdint.h>
+
+/*
+ * Binary trace file layout (native byte order).
+ *
+ * The file is a sequence of entries, each a BinaryEntry followed by
+ * `length` payload bytes. Every time a BinaryTraceAppender opens the file
+ * it starts a session with an ENTRY_SESSION entry; callsite ids are only
+ * valid within their session. ENTRY_CALLSITE introduces the next callsite
+ * id the first time a log statement is hit, its payload is the line
+ * (int32_t) followed by srcfile, function and format, each NUL terminated.
+ * ENTRY_RECORD payloads are arguments encoded by encodeTraceArgs() for
+ * the format of the callsite, ENTRY_TEXT payloads the formatted message
+ * for formats which can not be encoded.
+ */
+#define WPR_TRACE_BINARY_MAGIC   "WPRBTRC"
+#define WPR_TRACE_BINARY_VERSION 1
+
+namespace wpr_tracing
+{
+  enum BinaryEntryType
+  {
+    ENTRY_SESSION  = 1,
+    ENTRY_CALLSITE = 2,
+    ENTRY_RECORD   = 3,
+    ENTRY_TEXT     = 4
+  };
+
+  struct BinaryEntry
+  {
+    uint16_t type;
+    uint16_t length;    //payload bytes following the entry.
+    uint32_t callsite;
+    uint32_t tid;
+    uint32_t reserved;
+    uint64_t ticks;     //see traceClockNow().
+  };
+
+  struct BinarySession  //payload of ENTRY_SESSION.
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    double hz;          //clock calibration, see TraceClockInfo.
+    uint64_t baseTicks;
+    int64_t baseSec;
+    int64_t baseUsec;
+  };
+}
+#endif
@@ -0,0 +1,115 @@
+#include "traceclock.h"
+#include "tracing.h"
+#include <pthread.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <cpuid.h>
+#  include <x86intrin.h>
+#  define WPR_TRACING_HAVE_TSC 1
+#endif
+
+#define WPR_TRACING_CLOCK_CALIBRATION_NS 10000000LL //10ms
+
+namespace wpr_tracing
+{
+  static pthread_once_t traceClockOnce = PTHREAD_ONCE_INIT;
+  static TraceClockInfo traceClock;
+  static bool traceClockUseTsc = false;
+  static int traceTimeSource = WPR_LOG_CLOCK_REALTIME;
+
+  static
+  inline
+  long long
+  monotonicNs()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+
+  static
+  void
+  traceClockInit()
+  {
+#ifdef WPR_TRACING_HAVE_TSC
+    unsigned int eax, ebx, ecx, edx;
+    if(__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1 << 8))){
+      //invariant TSC: measure its rate against the monotonic clock.
+      long long m0 = monotonicNs();
+      unsigned long long t0 = __rdtsc();
+      long long m1;
+      do{
+        m1 = monotonicNs();
+      }while(m1 - m0 < WPR_TRACING_CLOCK_CALIBRATION_NS);
+      unsigned long long t1 = __rdtsc();
+      traceClock.hz = (double)(t1 - t0) * 1e9 / (double)(m1 - m0);
+      traceClockUseTsc = traceClock.hz > 0;
+    }
+#endif
+    if(!traceClockUseTsc){
+      traceClock.hz = 1e9;
+    }
+    traceClock.baseTicks = traceClockNow();
+    gettimeofday(&traceClock.baseTime, NULL);
+  }
+
+  unsigned long long
+  traceClockNow()
+  {
+#ifdef WPR_TRACING_HAVE_TSC
+    if(traceClockUseTsc){
+      return __rdtsc();
+    }
+#endif
+    return monotonicNs();
+  }
+
+  const TraceClockInfo&
+  traceClockInfo()
+  {
+    pthread_once(&traceClockOnce, traceClockInit);
+    return traceClock;
+  }
+
+  void
+  traceClockToTimeval(const TraceClockInfo& info, unsigned long long ticks,
+                      struct timeval& tv)
+  {
+    long long us = (long long)((double)(long long)(ticks - info.baseTicks)
+                               * 1e6 / info.hz);
+    long long t = info.baseTime.tv_sec * 1000000LL + info.baseTime.tv_usec + us;
+    tv.tv_sec = t / 1000000LL;
+    tv.tv_usec = t % 1000000LL;
+  }
+
+  void
+  traceTimeNow(struct timeval& tv)
+  {
+    switch(__atomic_load_n(&traceTimeSource, __ATOMIC_RELAXED)){
+      case WPR_LOG_CLOCK_COARSE:
+        {
+          struct timespec ts;
+          clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+          tv.tv_sec = ts.tv_sec;
+          tv.tv_usec = ts.tv_nsec / 1000;
+        }
+        break;
+      case WPR_LOG_CLOCK_TSC:
+        traceClockToTimeval(traceClock, traceClockNow(), tv);
+        break;
+      default:
+        gettimeofday(&tv, NULL);
+        break;
+    }
+  }
+
+  void
+  setTraceTimeSource(int source)
+  {
+    if(source == WPR_LOG_CLOCK_TSC){
+      traceClockInfo(); //calibrate before the first call uses it.
+    }
+    __atomic_store_n(&traceTimeSource, source, __ATOMIC_RELAXED);
+  }
+}
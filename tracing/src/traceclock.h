@@ -0,0 +1,39 @@
+#ifndef __WPR_TRACECLOCK_H__
+#define __WPR_TRACECLOCK_H__
+#include <sys/time.h>
+
+namespace wpr_tracing
+{
+  /**
+   * Cheap timestamps for records which are formatted later. Ticks come
+   * from the invariant TSC where available, else from the monotonic
+   * clock in nanoseconds. The calibration maps them back to wall time.
+   */
+  struct TraceClockInfo
+  {
+    double hz;                      //ticks per second.
+    unsigned long long baseTicks;   //ticks at baseTime.
+    struct timeval baseTime;        //wall time at baseTicks.
+  };
+
+  //calibrates the clock on first use, call it before traceClockNow().
+  const TraceClockInfo&
+  traceClockInfo();
+
+  unsigned long long
+  traceClockNow();
+
+  //convert ticks of a clock described by info to wall time.
+  void
+  traceClockToTimeval(const TraceClockInfo& info, unsigned long long ticks,
+                      struct timeval& tv);
+
+  //wall time of a synchronous log call from the clock selected by
+  //setTraceTimeSource() (one of WPR_LOG_CLOCK_*).
+  void
+  traceTimeNow(struct timeval& tv);
+
+  void
+  setTraceTimeSource(int source);
+}
+#endif
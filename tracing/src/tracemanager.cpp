@@ -1,87 +1,290 @@
 #include "tracemanager.h"
 #include "traceappender.h"
 #include "tracepeer.h"
+#include "traceclock.h"
 #include <stdio.h>
 #include <string.h>
 #include <memory.h>
 #include <algorithm>
+
+#define WPR_TRACING_SPARSE_PEERS 64 //initial size of the sparse peer table.
+
 namespace wpr_tracing
 {
 
   TraceManager* TraceManager::_instance = NULL;
+  pthread_once_t TraceManager::_once = PTHREAD_ONCE_INIT;
   
   TraceManager *
   TraceManager::getInstance()
   {
-    if(NULL == _instance){
-      _instance = new TraceManager();
-    }
+    pthread_once(&_once, createInstance);
     return _instance;
   }
+
+  void
+  TraceManager::createInstance()
+  {
+    _instance = new TraceManager();
+  }
  
   TraceManager::TraceManager()
-  :_peerHashTable(WPR_TRACING_PEER_HASHTBL_SIZE)
+  :_sparseCount(0)
   {
+    pthread_mutex_init(&_lock, NULL);
+    memset(_densePeers, 0, sizeof(_densePeers));
+    _sparsePeers = new PeerTable;
+    _sparsePeers->mask = WPR_TRACING_SPARSE_PEERS - 1;
+    _sparsePeers->slots = new TracePeer *[WPR_TRACING_SPARSE_PEERS]();
     _consoleAppender=new ConsoleTraceAppender();
-    _fileAppender=new FileTraceAppender("wpr.log");
+    _allAppenders.push_back(_consoleAppender);
+  }
+
+  TracePeer *
+  TraceManager::findSparsePeer(const unsigned int peerId)
+  {
+    PeerTable * table = __atomic_load_n(&_sparsePeers, __ATOMIC_ACQUIRE);
+    for(unsigned int i = peerId & table->mask;; i = (i + 1) & table->mask){
+      TracePeer * peer = __atomic_load_n(&table->slots[i], __ATOMIC_ACQUIRE);
+      if(NULL == peer || peer->_peerId == peerId){
+        return peer;
+      }
+    }
   }
   
   TracePeer *
   TraceManager::getTracePeer(const unsigned int peerId)
   {
-    int slotId = peerId % WPR_TRACING_PEER_HASHTBL_SIZE; 
-    for(PEER_HASH_TBL_SLOT::iterator it = _peerHashTable[slotId].begin(); 
-        it != _peerHashTable[slotId].end();
-        ++it){
-      if((*it)->_peerId==peerId){
-        return *it;
+    TracePeer * peer = findTracePeer(peerId);
+    if(NULL == peer){
+      pthread_mutex_lock(&_lock);
+      peer = getTracePeerLocked(peerId);
+      pthread_mutex_unlock(&_lock);
+    }
+    return peer;
+  }
+
+  TracePeer *
+  TraceManager::getTracePeerLocked(const unsigned int peerId)
+  {
+    TracePeer * peer = findTracePeer(peerId);
+    if(NULL != peer){
+      return peer;
+    }
+    //not exist, create one and publish it.
+    peer = new TracePeer(peerId);
+    if(peerId < WPR_LOG_DENSE_PEERS){
+      __atomic_store_n(&_densePeers[peerId], peer, __ATOMIC_RELEASE);
+      return peer;
+    }
+    PeerTable * table = _sparsePeers;
+    if(2 * (_sparseCount + 1) > table->mask + 1){
+      //keep the table at most half full: build a bigger copy and switch
+      //readers over, the old one stays valid for those still using it.
+      PeerTable * bigger = new PeerTable;
+      bigger->mask = 2 * (table->mask + 1) - 1;
+      bigger->slots = new TracePeer *[bigger->mask + 1]();
+      for(unsigned int i = 0; i <= table->mask; ++i){
+        if(NULL != table->slots[i]){
+          unsigned int j = table->slots[i]->_peerId & bigger->mask;
+          while(NULL != bigger->slots[j]){
+            j = (j + 1) & bigger->mask;
+          }
+          bigger->slots[j] = table->slots[i];
+        }
       }
-    } 
-    //not exist, create one and link into list.
-    TracePeer * newPeer = new TracePeer(peerId);
-    _peerHashTable[slotId].push_back(newPeer); 
-    return newPeer;
+      __atomic_store_n(&_sparsePeers, bigger, __ATOMIC_RELEASE);
+      _retiredTables.push_back(table);
+      table = bigger;
+    }
+    unsigned int i = peerId & table->mask;
+    while(NULL != table->slots[i]){
+      i = (i + 1) & table->mask;
+    }
+    __atomic_store_n(&table->slots[i], peer, __ATOMIC_RELEASE);
+    ++_sparseCount;
+    return peer;
   }
 
   void
-  TraceManager::addConsoleAppender(const unsigned int peerId)
+  TraceManager::addAppender(const unsigned int peerId, TraceAppender * appender)
+  {
+    //caller holds _lock.
+    TracePeer * peer = getTracePeerLocked(peerId);
+    const TracePeer::APPENDER_LIST & current = peer->getAppenders();
+    if(current.end()!=find(current.begin(), current.end(), appender)){
+      return; //already have this appender, return immediately.
+    }
+    TracePeer::APPENDER_LIST * updated = new TracePeer::APPENDER_LIST(current);
+    updated->push_back(appender);
+    _retiredAppenders.push_back(peer->_appenders);
+    __atomic_store_n(&peer->_appenders, updated, __ATOMIC_RELEASE);
+    updateEnabled(peer);
+  }
+
+  void
+  TraceManager::updateEnabled(TracePeer * peer)
+  {
+    //caller holds _lock. one bit per level at or above the peer's level.
+    unsigned char levels = 0;
+    if(!peer->_disabled && !peer->getAppenders().empty()){
+      for(int level = peer->_minLevel; level < WPR_LEVEL_OFF; ++level){
+        levels |= 1 << level;
+      }
+    }
+    __atomic_store_n(&peer->_levels, levels, __ATOMIC_RELAXED);
+    if(peer->_peerId < WPR_LOG_DENSE_PEERS){
+      __atomic_store_n(&wpr_log_peerLevels[peer->_peerId], levels,
+                       __ATOMIC_RELAXED);
+    }
+  }
+
+  void
+  TraceManager::setPeerLevel(const unsigned int peerId, const int level)
   {
-    TracePeer * peer = getTracePeer(peerId);
-    if(peer->_appenderList.end()!=find(peer->_appenderList.begin(),
-                                       peer->_appenderList.end(),
-                                       _consoleAppender)){
-      return; //already have console appender, return immediately.
+    pthread_mutex_lock(&_lock);
+    TracePeer * peer = getTracePeerLocked(peerId);
+    peer->_minLevel = level < WPR_LEVEL_TRACE ? WPR_LEVEL_TRACE :
+                      level > WPR_LEVEL_OFF ? WPR_LEVEL_OFF : level;
+    updateEnabled(peer);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  TraceManager::setFunctionSampling(const unsigned int peerId,
+                                    const unsigned int every,
+                                    const unsigned int minMicros)
+  {
+    unsigned long long minTicks = 0;
+    if(minMicros > 0){
+      minTicks = (unsigned long long)(traceClockInfo().hz * minMicros / 1e6);
+      if(minTicks == 0){
+        minTicks = 1;
+      }
     }
-    peer->_appenderList.push_back(_consoleAppender); 
+    pthread_mutex_lock(&_lock);
+    TracePeer * peer = getTracePeerLocked(peerId);
+    __atomic_store_n(&peer->_sampleEvery, every > 0 ? every : 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&peer->_sampleMinTicks, minTicks, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  TraceManager::setPeerEnabled(const unsigned int peerId, bool enabled)
+  {
+    pthread_mutex_lock(&_lock);
+    TracePeer * peer = getTracePeerLocked(peerId);
+    peer->_disabled = !enabled;
+    updateEnabled(peer);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  TraceManager::addConsoleAppender(const unsigned int peerId)
+  {
+    pthread_mutex_lock(&_lock);
+    addAppender(peerId, _consoleAppender);
+    pthread_mutex_unlock(&_lock);
   }
   
   void 
-  TraceManager::addFileAppender(const unsigned int peerId, const char * filename)
+  TraceManager::addFileAppender(const unsigned int peerId, const char * filename,
+                                const struct wpr_log_fileOptions * options)
   {
-    TracePeer * peer = getTracePeer(peerId);
-    if(peer->_appenderList.end()!=find(peer->_appenderList.begin(),
-                                       peer->_appenderList.end(),
-                                       _fileAppender)){
-      return;
+    pthread_mutex_lock(&_lock);
+    TraceAppender *& appender = _fileAppenders[filename];
+    if(NULL == appender){
+      appender = new FileTraceAppender(filename, options);
+      _allAppenders.push_back(appender);
     }
-    peer->_appenderList.push_back(_fileAppender);
+    addAppender(peerId, appender);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void 
+  TraceManager::addBinaryAppender(const unsigned int peerId, const char * filename)
+  {
+    pthread_mutex_lock(&_lock);
+    TraceAppender *& appender = _binaryAppenders[filename];
+    if(NULL == appender){
+      appender = new BinaryTraceAppender(filename);
+      _allAppenders.push_back(appender);
+    }
+    addAppender(peerId, appender);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void 
+  TraceManager::addMmapRingAppender(const unsigned int peerId, const char * filename,
+                                    unsigned long long size)
+  {
+    pthread_mutex_lock(&_lock);
+    TraceAppender *& appender = _ringAppenders[filename];
+    if(NULL == appender){
+      appender = new MmapRingTraceAppender(filename, size);
+      _allAppenders.push_back(appender);
+    }
+    addAppender(peerId, appender);
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  TraceManager::flushAppenders()
+  {
+    pthread_mutex_lock(&_lock);
+    for(std::vector<TraceAppender *>::iterator it=_allAppenders.begin();
+        it!=_allAppenders.end();
+        ++it){
+      (*it)->flush();
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+  void
+  TraceManager::endBatch()
+  {
+    pthread_mutex_lock(&_lock);
+    for(std::vector<TraceAppender *>::iterator it=_allAppenders.begin();
+        it!=_allAppenders.end();
+        ++it){
+      (*it)->endBatch();
+    }
+    pthread_mutex_unlock(&_lock);
   }
 
   TraceManager::~TraceManager()
   {
     //reclaim all peers.
-    for(PEER_HASH_TBL::iterator it=_peerHashTable.begin();
-        it!=_peerHashTable.end();
-        ++it){
-      for(PEER_HASH_TBL_SLOT::iterator it1=(*it).begin();
-          it1!=(*it).end();
-          ++it1){
-        delete (*it1);
+    for(unsigned int i = 0; i < WPR_LOG_DENSE_PEERS; ++i){
+      if(NULL != _densePeers[i]){
+        delete _densePeers[i]->_appenders;
+        delete _densePeers[i];
+      }
+    }
+    for(unsigned int i = 0; i <= _sparsePeers->mask; ++i){
+      if(NULL != _sparsePeers->slots[i]){
+        delete _sparsePeers->slots[i]->_appenders;
+        delete _sparsePeers->slots[i];
       }
     }
+    _retiredTables.push_back(_sparsePeers);
+    for(std::vector<PeerTable *>::iterator it=_retiredTables.begin();
+        it!=_retiredTables.end();
+        ++it){
+      delete [] (*it)->slots;
+      delete (*it);
+    }
+    for(std::vector<std::vector<TraceAppender *> *>::iterator it=_retiredAppenders.begin();
+        it!=_retiredAppenders.end();
+        ++it){
+      delete (*it);
+    }
     //reclaim all appenders;
-    delete _consoleAppender;
-    delete _fileAppender;
+    for(std::vector<TraceAppender *>::iterator it=_allAppenders.begin();
+        it!=_allAppenders.end();
+        ++it){
+      delete (*it);
+    }
+    pthread_mutex_destroy(&_lock);
   }
 }
-
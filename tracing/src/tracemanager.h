@@ -1,40 +1,119 @@
 #ifndef __WPR_TRACEMANAGER_H__
 #define __WPR_TRACEMANAGER_H__
-#include <list>
+#include <map>
+#include <string>
 #include <vector>
-#define WPR_TRACING_PEER_HASHTBL_SIZE 100
+#include <pthread.h>
+#include "tracing.h"
 namespace wpr_tracing
 {
   class TracePeer;
   class TraceAppender;
+  /**
+   * TraceManager owns all peers and appenders.
+   *
+   * Looking up a peer never takes a lock: peers with ids below
+   * WPR_LOG_DENSE_PEERS sit in a directly indexed array, the others in an
+   * open addressing table which is only ever extended in place or
+   * replaced as a whole (readers keep using the old copy until they are
+   * done). Peers, replaced tables and replaced appender lists are only
+   * freed with the manager. Registration is serialised by _lock.
+   */
   class TraceManager
   {
   public:
-    typedef std::list<TracePeer *> PEER_HASH_TBL_SLOT;
-    typedef std::vector<PEER_HASH_TBL_SLOT> PEER_HASH_TBL; 
-
     static 
     TraceManager *
     getInstance();
     
     void
-    addFileAppender(const unsigned int peerId, const char * filename );
+    addFileAppender(const unsigned int peerId, const char * filename,
+                    const struct wpr_log_fileOptions * options = NULL);
 
     void
     addConsoleAppender(const unsigned int peerId);
+
+    void
+    addBinaryAppender(const unsigned int peerId, const char * filename);
+
+    void
+    addMmapRingAppender(const unsigned int peerId, const char * filename,
+                        unsigned long long size);
+
+    //wait-free, NULL if the peer was never registered.
+    inline
+    TracePeer *
+    findTracePeer(const unsigned int peerId)
+    {
+      if(peerId < WPR_LOG_DENSE_PEERS){
+        return __atomic_load_n(&_densePeers[peerId], __ATOMIC_ACQUIRE);
+      }
+      return findSparsePeer(peerId);
+    }
  
+    //find or register a peer.
     TracePeer *
     getTracePeer(const unsigned int peerId);
 
+    void
+    setPeerEnabled(const unsigned int peerId, bool enabled);
+
+    void
+    setPeerLevel(const unsigned int peerId, const int level);
+
+    void
+    setFunctionSampling(const unsigned int peerId, const unsigned int every,
+                        const unsigned int minMicros);
+
+    //write out everything buffered or queued on all appenders.
+    void
+    flushAppenders();
+
+    //async path: the writer thread is done with its current batch.
+    void
+    endBatch();
+
     virtual
     ~TraceManager();
 
   private:
     TraceManager(); //singleton
+
+    struct PeerTable
+    {
+      unsigned int mask;
+      TracePeer ** slots;
+    };
+
+    static
+    void
+    createInstance();
+
+    TracePeer *
+    findSparsePeer(const unsigned int peerId);
+
+    TracePeer *
+    getTracePeerLocked(const unsigned int peerId);
+
+    void
+    addAppender(const unsigned int peerId, TraceAppender * appender);
+
+    void
+    updateEnabled(TracePeer * peer);
+
     static TraceManager * _instance;
-    PEER_HASH_TBL _peerHashTable;
+    static pthread_once_t _once;
+    pthread_mutex_t _lock;  //serialises registration.
+    TracePeer * _densePeers[WPR_LOG_DENSE_PEERS];
+    PeerTable * _sparsePeers;
+    unsigned int _sparseCount;
+    std::vector<PeerTable *> _retiredTables;
+    std::vector<std::vector<TraceAppender *> *> _retiredAppenders;
+    std::vector<TraceAppender *> _allAppenders; //owned, for flush and delete.
     TraceAppender * _consoleAppender;
-    TraceAppender * _fileAppender;
+    std::map<std::string, TraceAppender *> _fileAppenders;   //by file name.
+    std::map<std::string, TraceAppender *> _binaryAppenders; //by file name.
+    std::map<std::string, TraceAppender *> _ringAppenders;   //by file name.
   };
 }
 #endif
@@ -1,6 +1,7 @@
 #include "tracepeer.h"
 #include "traceappender.h"
 #include "tracemsg.h"
+#include "traceasync.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -13,7 +14,8 @@ namespace wpr_tracing
 {
 
   TracePeer::TracePeer(const unsigned int peerId)
-  :_peerId(peerId)
+  :_peerId(peerId), _levels(0), _disabled(false),
+   _minLevel(WPR_LEVEL_TRACE), _sampleEvery(1), _sampleMinTicks(0), _appenders(new APPENDER_LIST())
   {
   }
 
@@ -21,6 +23,14 @@ namespace wpr_tracing
   TracePeer::traceInfo(const char * srcfile,
       const int line, const char * function, const char * format, va_list ap)
   {
+    const APPENDER_LIST & appenders = getAppenders();
+    if(appenders.empty()){
+      return;
+    }
+    if(AsyncTraceWriter::isEnabled()){
+      AsyncTraceWriter::getInstance()->push(this, srcfile, line, function, format, ap);
+      return;
+    }
     TraceMsg traceMsg = {
                          _peerId,
                          srcfile,
@@ -29,13 +39,38 @@ namespace wpr_tracing
                          format,
                          ap
                         };
-    for(std::list<TraceAppender *>::iterator it=_appenderList.begin();
-        it!=_appenderList.end();
+    for(APPENDER_LIST::const_iterator it=appenders.begin();
+        it!=appenders.end();
         ++it){
         (*it)->traceInfo(traceMsg);
     }
     va_end(ap);
   }
 
+  void
+  TracePeer::traceRecord(const TraceRecord & rec, const char * line, unsigned int len)
+  {
+    const APPENDER_LIST & appenders = getAppenders();
+    for(APPENDER_LIST::const_iterator it=appenders.begin();
+        it!=appenders.end();
+        ++it){
+        (*it)->traceRecord(rec, line, len);
+    }
+  }
+
+  bool
+  TracePeer::hasTextAppender() const
+  {
+    const APPENDER_LIST & appenders = getAppenders();
+    for(APPENDER_LIST::const_iterator it=appenders.begin();
+        it!=appenders.end();
+        ++it){
+      if(!(*it)->isBinary()){
+        return true;
+      }
+    }
+    return false;
+  }
+
 }
 
@@ -1,11 +1,13 @@
 #ifndef __WPR_TRACEPEER_H__
 #define __WPR_TRACEPEER_H__
 #include <cstdarg>
-#include <list>
+#include <vector>
+#include "tracing.h"
 
 namespace wpr_tracing 
 {
   class TraceAppender;
+  struct TraceRecord;
   /**
    * TracePeer is logic container to collect log messages from
    * business modules. 
@@ -21,10 +23,68 @@ namespace wpr_tracing
     void
     traceInfo(const char * srcfile, const int line,
               const char * function, const char * format, va_list ap);
+
+    //async path: hand a record drained by the writer thread to all
+    //appenders. line is its formatted text, only set if hasTextAppender().
+    void
+    traceRecord(const TraceRecord & rec, const char * line, unsigned int len);
+
+    bool
+    hasTextAppender() const;
+
+    //true if the peer has appenders and was not disabled.
+    inline
+    bool
+    isEnabled() const
+    {
+      return __atomic_load_n(&_levels, __ATOMIC_RELAXED) != 0;
+    }
+
+    //true if statements of level would be written.
+    inline
+    bool
+    isLevelEnabled(const int level) const
+    {
+      return level >= 0 && level < WPR_LEVEL_OFF &&
+             0 != (__atomic_load_n(&_levels, __ATOMIC_RELAXED) & (1 << level));
+    }
+
+    //function tracing samples every n-th call, see
+    //wpr_log_setFunctionSampling().
+    inline
+    unsigned int
+    getSampleEvery() const
+    {
+      return __atomic_load_n(&_sampleEvery, __ATOMIC_RELAXED);
+    }
+
+    //calls shorter than this many clock ticks are not traced, 0 for all.
+    inline
+    unsigned long long
+    getSampleMinTicks() const
+    {
+      return __atomic_load_n(&_sampleMinTicks, __ATOMIC_RELAXED);
+    }
+
+    typedef std::vector<TraceAppender *> APPENDER_LIST;
+
+    //the current appenders. lists are replaced, never modified, so the
+    //returned list can be walked while appenders are added concurrently.
+    inline
+    const APPENDER_LIST &
+    getAppenders() const
+    {
+      return *__atomic_load_n(&_appenders, __ATOMIC_ACQUIRE);
+    }
     
   private:
     unsigned int  _peerId;
-    std::list<TraceAppender *> _appenderList;
+    unsigned char _levels;      //bit (1 << level) set for each logged level.
+    bool _disabled;             //switched off by wpr_log_setEnabled().
+    int _minLevel;              //set by wpr_log_setLevel().
+    unsigned int _sampleEvery;
+    unsigned long long _sampleMinTicks;
+    APPENDER_LIST * _appenders; //published copy-on-write by TraceManager.
 
   friend class TraceManager;
   };
@@ -0,0 +1,44 @@
+#ifndef __WPR_TRACERING_H__
+#define __WPR_TRACERING_H__
+#include <stdint.h>
+
+/*
+ * Memory mapped trace ring layout (native byte order).
+ *
+ * The file is a RingHeader padded to WPR_TRACE_RING_HEADER_SIZE bytes,
+ * followed by `capacity` data bytes used as a ring. head and tail count
+ * bytes since the ring was created, their position in the data area is
+ * the count modulo capacity. [tail, head) holds complete entries, oldest
+ * first. An entry is a uint32_t length followed by the formatted line,
+ * padded to 4 bytes; entries never wrap, the rest of the data area is
+ * skipped with a WPR_TRACE_RING_WRAP length instead.
+ *
+ * The writer moves tail before it overwrites old entries and head only
+ * after an entry is complete, so the file is consistent whenever the
+ * process dies.
+ */
+#define WPR_TRACE_RING_MAGIC       "WPRRING"
+#define WPR_TRACE_RING_VERSION     1
+#define WPR_TRACE_RING_HEADER_SIZE 4096
+#define WPR_TRACE_RING_WRAP        0xffffffffu
+
+namespace wpr_tracing
+{
+  struct RingHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t capacity;  //data bytes, a multiple of 4.
+    uint64_t head;      //end of the newest entry.
+    uint64_t tail;      //start of the oldest entry.
+  };
+
+  inline
+  uint32_t
+  ringEntrySize(uint32_t length)
+  {
+    return sizeof(uint32_t) + ((length + 3) & ~3u);
+  }
+}
+#endif
@@ -0,0 +1,230 @@
+#include "tracespan.h"
+#include "traceclock.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+int wpr_span_enabled = 0;
+
+namespace wpr_tracing
+{
+  SpanRecorder* SpanRecorder::_instance = NULL;
+  pthread_once_t SpanRecorder::_once = PTHREAD_ONCE_INIT;
+
+  SpanBuffer::SpanBuffer(unsigned int capacity)
+  :_tid(syscall(SYS_gettid)), _capacity(capacity), _count(0), _dropped(0)
+  {
+    _events = new SpanEvent[capacity];
+  }
+
+  SpanBuffer::~SpanBuffer()
+  {
+    delete [] _events;
+  }
+
+  SpanRecorder *
+  SpanRecorder::getInstance()
+  {
+    pthread_once(&_once, createInstance);
+    return _instance;
+  }
+
+  void
+  SpanRecorder::createInstance()
+  {
+    _instance = new SpanRecorder();
+  }
+
+  SpanRecorder::SpanRecorder()
+  :_capacity(WPR_TRACING_SPAN_EVENTS)
+  {
+    pthread_key_create(&_bufferKey, NULL); //buffers outlive their threads.
+    pthread_mutex_init(&_lock, NULL);
+  }
+
+  int
+  SpanRecorder::start(unsigned int eventsPerThread)
+  {
+    traceClockInfo(); //calibrate before the first span.
+    pthread_mutex_lock(&_lock);
+    _capacity = eventsPerThread > 0 ? eventsPerThread : WPR_TRACING_SPAN_EVENTS;
+    pthread_mutex_unlock(&_lock);
+    __atomic_store_n(&wpr_span_enabled, 1, __ATOMIC_RELEASE);
+    return 0;
+  }
+
+  void
+  SpanRecorder::stop()
+  {
+    __atomic_store_n(&wpr_span_enabled, 0, __ATOMIC_RELEASE);
+  }
+
+  SpanBuffer *
+  SpanRecorder::getBuffer()
+  {
+    SpanBuffer * buffer = (SpanBuffer *)pthread_getspecific(_bufferKey);
+    if(NULL == buffer){
+      pthread_mutex_lock(&_lock);
+      buffer = new SpanBuffer(_capacity);
+      _buffers.push_back(buffer);
+      pthread_mutex_unlock(&_lock);
+      pthread_setspecific(_bufferKey, buffer);
+    }
+    return buffer;
+  }
+
+  void
+  SpanRecorder::record(const char * name, const char * category,
+                       unsigned long long start, unsigned long long end,
+                       const TraceSpanArg * args, unsigned int argCount)
+  {
+    SpanBuffer * buffer = getBuffer();
+    unsigned long count = buffer->_count;
+    if(count >= buffer->_capacity){
+      __atomic_store_n(&buffer->_dropped, buffer->_dropped + 1, __ATOMIC_RELAXED);
+      return;
+    }
+    SpanEvent& event = buffer->_events[count];
+    event.name = name;
+    event.category = category;
+    event.start = start;
+    event.end = end;
+    event.argCount = argCount;
+    for(unsigned int i = 0; i < argCount; ++i){
+      event.args[i] = args[i];
+    }
+    __atomic_store_n(&buffer->_count, count + 1, __ATOMIC_RELEASE);
+  }
+
+  //write s as a JSON string.
+  static
+  void
+  writeJsonString(FILE * out, const char * s)
+  {
+    fputc('"', out);
+    for(; *s != '\0'; ++s){
+      unsigned char c = *s;
+      if(c == '"' || c == '\\'){
+        fputc('\\', out);
+        fputc(c, out);
+      }else if(c < 0x20){
+        fprintf(out, "\\u%04x", c);
+      }else{
+        fputc(c, out);
+      }
+    }
+    fputc('"', out);
+  }
+
+  int
+  SpanRecorder::exportChrome(const char * filename)
+  {
+    FILE * out = fopen(filename, "w");
+    if(NULL == out){
+      return -1;
+    }
+    const TraceClockInfo& clock = traceClockInfo();
+    int pid = getpid();
+    bool first = true;
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    pthread_mutex_lock(&_lock);
+    for(std::list<SpanBuffer *>::iterator it = _buffers.begin();
+        it != _buffers.end();
+        ++it){
+      SpanBuffer * buffer = *it;
+      unsigned long count = __atomic_load_n(&buffer->_count, __ATOMIC_ACQUIRE);
+      for(unsigned long i = 0; i < count; ++i){
+        const SpanEvent& event = buffer->_events[i];
+        //timestamps in microseconds since the clock was calibrated.
+        double ts = (double)(long long)(event.start - clock.baseTicks) * 1e6 / clock.hz;
+        double dur = (double)(event.end - event.start) * 1e6 / clock.hz;
+        fprintf(out, "%s\n{\"name\":", first ? "" : ",");
+        writeJsonString(out, event.name);
+        fprintf(out, ",\"cat\":");
+        writeJsonString(out, event.category);
+        fprintf(out, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u",
+                ts, dur, pid, buffer->_tid);
+        if(event.argCount > 0){
+          fprintf(out, ",\"args\":{");
+          for(unsigned int a = 0; a < event.argCount; ++a){
+            const TraceSpanArg& arg = event.args[a];
+            fprintf(out, "%s", a > 0 ? "," : "");
+            writeJsonString(out, arg.key);
+            fputc(':', out);
+            if(arg.isText){
+              writeJsonString(out, arg.text);
+            }else{
+              fprintf(out, "%lld", arg.value);
+            }
+          }
+          fputc('}', out);
+        }
+        fputc('}', out);
+        first = false;
+      }
+    }
+    pthread_mutex_unlock(&_lock);
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0 ? 0 : -1;
+  }
+
+  void
+  SpanRecorder::reset()
+  {
+    pthread_mutex_lock(&_lock);
+    for(std::list<SpanBuffer *>::iterator it = _buffers.begin();
+        it != _buffers.end();
+        ++it){
+      __atomic_store_n(&(*it)->_count, 0, __ATOMIC_RELEASE);
+      __atomic_store_n(&(*it)->_dropped, 0, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&_lock);
+  }
+
+  unsigned long
+  SpanRecorder::getDroppedCount()
+  {
+    unsigned long dropped = 0;
+    pthread_mutex_lock(&_lock);
+    for(std::list<SpanBuffer *>::iterator it = _buffers.begin();
+        it != _buffers.end();
+        ++it){
+      dropped += __atomic_load_n(&(*it)->_dropped, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&_lock);
+    return dropped;
+  }
+
+  TraceSpan&
+  TraceSpan::arg(const char * key, long long value)
+  {
+    if(_start != 0 && _argCount < WPR_SPAN_MAX_ARGS){
+      TraceSpanArg& a = _args[_argCount++];
+      a.key = key;
+      a.isText = false;
+      a.value = value;
+    }
+    return *this;
+  }
+
+  TraceSpan&
+  TraceSpan::arg(const char * key, const char * value)
+  {
+    if(_start != 0 && _argCount < WPR_SPAN_MAX_ARGS){
+      TraceSpanArg& a = _args[_argCount++];
+      a.key = key;
+      a.isText = true;
+      strncpy(a.text, value, sizeof(a.text) - 1);
+      a.text[sizeof(a.text) - 1] = '\0';
+    }
+    return *this;
+  }
+
+  void
+  TraceSpan::end()
+  {
+    SpanRecorder::getInstance()->record(_name, _category, _start,
+                                        traceClockNow(), _args, _argCount);
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef __WPR_TRACESPAN_H__
+#define __WPR_TRACESPAN_H__
+#include <list>
+#include <pthread.h>
+#include "tracing.h"
+
+#define WPR_TRACING_SPAN_EVENTS 65536  //default spans per thread buffer.
+
+namespace wpr_tracing
+{
+  struct SpanEvent
+  {
+    const char * name;
+    const char * category;
+    unsigned long long start;   //see traceClockNow().
+    unsigned long long end;
+    unsigned int argCount;
+    TraceSpanArg args[WPR_SPAN_MAX_ARGS];
+  };
+
+  /**
+   * SpanBuffer holds the spans of one thread. Only the owner appends,
+   * the exporter reads the first `count` events, so no lock is needed.
+   * Buffers are kept after their thread exits until the recorder dies.
+   */
+  struct SpanBuffer
+  {
+    SpanBuffer(unsigned int capacity);
+    ~SpanBuffer();
+
+    unsigned int _tid;          //kernel thread id of the owner.
+    unsigned int _capacity;
+    unsigned long _count;       //published with release.
+    unsigned long _dropped;
+    SpanEvent * _events;
+  };
+
+  /**
+   * SpanRecorder collects the spans of all threads and writes them in
+   * the Chrome trace event format ("X" complete events).
+   */
+  class SpanRecorder
+  {
+  public:
+    static
+    SpanRecorder *
+    getInstance();
+
+    int
+    start(unsigned int eventsPerThread);
+
+    void
+    stop();
+
+    void
+    record(const char * name, const char * category,
+           unsigned long long start, unsigned long long end,
+           const TraceSpanArg * args, unsigned int argCount);
+
+    int
+    exportChrome(const char * filename);
+
+    void
+    reset();
+
+    unsigned long
+    getDroppedCount();
+
+  private:
+    SpanRecorder(); //singleton
+
+    static
+    void
+    createInstance();
+
+    SpanBuffer *
+    getBuffer();
+
+    static SpanRecorder * _instance;
+    static pthread_once_t _once;
+
+    pthread_key_t _bufferKey;
+    pthread_mutex_t _lock;           //protects _buffers and _capacity.
+    std::list<SpanBuffer *> _buffers;
+    unsigned int _capacity;
+  };
+}
+#endif
@@ -1,19 +1,30 @@
 #include "tracing.h"
 #include "tracemanager.h"
 #include "tracepeer.h"
+#include "traceasync.h"
+#include "traceclock.h"
+#include "tracespan.h"
 #include <cstdarg>
+#include <stdlib.h>
+#include <string.h>
 
 using namespace wpr_tracing;
 
+unsigned char wpr_log_peerLevels[WPR_LOG_DENSE_PEERS];
+
 //main interface to log info.
 void 
 wpr_log(const unsigned int peerId, 
         const char * srcfile, const int line,
         const char * function, const char * format, ...)
 {
+  TracePeer * peer = TraceManager::getInstance()->findTracePeer(peerId);
+  if(NULL == peer || !peer->isEnabled()){
+    return; //nothing to write to, skip the argument handling.
+  }
   va_list ap;
   va_start(ap,format);
-  TraceManager::getInstance()->getTracePeer(peerId)->traceInfo(srcfile, line, function, format, ap);
+  peer->traceInfo(srcfile, line, function, format, ap);
   va_end(ap);
 }
 
@@ -22,3 +33,170 @@ wpr_log_addConsoleAppender(const unsigned int peerId)
 {
   TraceManager::getInstance()->addConsoleAppender(peerId);
 }
+
+static void
+wpr_log_atexit(void)
+{
+  //do not lose pending or buffered records.
+  AsyncTraceWriter::getInstance()->stop();
+  TraceManager::getInstance()->flushAppenders();
+}
+
+static void
+wpr_log_registerAtexit(void)
+{
+  static bool atexitRegistered = false;
+  if(!atexitRegistered){
+    atexit(wpr_log_atexit);
+    atexitRegistered = true;
+  }
+}
+
+int
+wpr_log_isEnabled(const unsigned int peerId)
+{
+  TracePeer * peer = TraceManager::getInstance()->findTracePeer(peerId);
+  return NULL != peer && peer->isEnabled();
+}
+
+void
+wpr_log_setEnabled(const unsigned int peerId, const int enabled)
+{
+  TraceManager::getInstance()->setPeerEnabled(peerId, 0 != enabled);
+}
+
+void
+wpr_log_setLevel(const unsigned int peerId, const int level)
+{
+  TraceManager::getInstance()->setPeerLevel(peerId, level);
+}
+
+int
+wpr_log_isLevelEnabled(const unsigned int peerId, const int level)
+{
+  TracePeer * peer = TraceManager::getInstance()->findTracePeer(peerId);
+  return NULL != peer && peer->isLevelEnabled(level);
+}
+
+void
+wpr_log_setFunctionSampling(const unsigned int peerId, const unsigned int n,
+                            const unsigned int minMicros)
+{
+  TraceManager::getInstance()->setFunctionSampling(peerId, n, minMicros);
+}
+
+void
+wpr_log_addFileAppender(const unsigned int peerId, const char * filename,
+                        const struct wpr_log_fileOptions * options)
+{
+  TraceManager::getInstance()->addFileAppender(peerId, filename, options);
+  wpr_log_registerAtexit();
+}
+
+void
+wpr_log_addBinaryAppender(const unsigned int peerId, const char * filename)
+{
+  TraceManager::getInstance()->addBinaryAppender(peerId, filename);
+  wpr_log_registerAtexit();
+}
+
+void
+wpr_log_setClock(const int clock)
+{
+  setTraceTimeSource(clock);
+}
+
+void
+wpr_log_addMmapRingAppender(const unsigned int peerId, const char * filename,
+                            unsigned long long size)
+{
+  TraceManager::getInstance()->addMmapRingAppender(peerId, filename, size);
+}
+
+int
+wpr_log_enableAsync(const unsigned int ringSize)
+{
+  TraceManager::getInstance(); //make sure the writer finds it.
+  wpr_log_registerAtexit();
+  return AsyncTraceWriter::getInstance()->start(ringSize);
+}
+
+void
+wpr_log_disableAsync(void)
+{
+  AsyncTraceWriter::getInstance()->stop();
+}
+
+void
+wpr_log_flush(void)
+{
+  if(AsyncTraceWriter::isEnabled()){
+    AsyncTraceWriter::getInstance()->flush();
+  }
+  TraceManager::getInstance()->flushAppenders();
+}
+
+unsigned long
+wpr_log_getDroppedCount(void)
+{
+  return AsyncTraceWriter::getInstance()->getDroppedCount();
+}
+
+int
+wpr_span_start(const unsigned int eventsPerThread)
+{
+  return SpanRecorder::getInstance()->start(eventsPerThread);
+}
+
+void
+wpr_span_stop(void)
+{
+  SpanRecorder::getInstance()->stop();
+}
+
+unsigned long long
+wpr_span_begin(void)
+{
+  if(!__atomic_load_n(&wpr_span_enabled, __ATOMIC_RELAXED)){
+    return 0;
+  }
+  return traceClockNow();
+}
+
+void
+wpr_span_end(const char * name, const char * category,
+             unsigned long long start, const char * key, const char * value)
+{
+  if(0 == start){
+    return;
+  }
+  unsigned long long end = traceClockNow();
+  TraceSpanArg arg;
+  unsigned int argCount = 0;
+  if(NULL != key && NULL != value){
+    arg.key = key;
+    arg.isText = true;
+    strncpy(arg.text, value, sizeof(arg.text) - 1);
+    arg.text[sizeof(arg.text) - 1] = '\0';
+    argCount = 1;
+  }
+  SpanRecorder::getInstance()->record(name, category, start, end, &arg, argCount);
+}
+
+int
+wpr_span_exportChrome(const char * filename)
+{
+  return SpanRecorder::getInstance()->exportChrome(filename);
+}
+
+void
+wpr_span_reset(void)
+{
+  SpanRecorder::getInstance()->reset();
+}
+
+unsigned long
+wpr_span_getDroppedCount(void)
+{
+  return SpanRecorder::getInstance()->getDroppedCount();
+}
@@ -0,0 +1,91 @@
+/*
+ * timestamp_bench: cost of the timestamp part of a log call, the way it
+ * was done before (localtime_r + strftime per message) against the
+ * cached header, and of a whole wpr_log() with each clock.
+ */
+#include <tracing.h>
+#include <traceappender.h>
+#include <traceclock.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/time.h>
+
+using namespace wpr_tracing;
+
+#define BENCH_CALLS 1000000
+
+static double
+cpuNanos()
+{
+  //cpu time of this thread, wall time is too noisy on loaded machines.
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int
+legacyHeader(char * p, int max_len)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  struct tm local_now;
+  localtime_r(&now.tv_sec, &local_now);
+  int n = strftime(p, max_len, "%x %X", &local_now);
+  n += snprintf(p + n, max_len - n, ".%ld", (long) (now.tv_usec) / 1000);
+  n += snprintf(p + n, max_len - n, " (%s:%d): ", __FILE__, __LINE__);
+  return n;
+}
+
+static int
+cachedHeader(char * p, int max_len)
+{
+  struct timeval now;
+  traceTimeNow(now);
+  return buildTraceHeader(p, max_len, now, __FILE__, __LINE__);
+}
+
+static void
+benchHeader(const char * name, int (*header)(char *, int))
+{
+  char buf[MAX_BUFFER_SIZE];
+  int sum = 0;
+  double start = cpuNanos();
+  for(int i = 0; i < BENCH_CALLS; ++i){
+    sum += header(buf, sizeof(buf));
+  }
+  double ns = (cpuNanos() - start) / BENCH_CALLS;
+  printf("%-28s %8.1f ns/call (%d)\n", name, ns, sum / BENCH_CALLS);
+}
+
+static void
+benchLog(const char * name, int clock)
+{
+  wpr_log_setClock(clock);
+  double start = cpuNanos();
+  for(int i = 0; i < BENCH_CALLS; ++i){
+    WPR_LOG(300, "benchmark message %d %s", i, "text");
+  }
+  double ns = (cpuNanos() - start) / BENCH_CALLS;
+  printf("%-28s %8.1f ns/call\n", name, ns);
+}
+
+int
+main()
+{
+  struct wpr_log_fileOptions options = { 0 };
+  options.flushMillis = 1000;
+  wpr_log_addFileAppender(300, "/dev/null", &options);
+
+  benchHeader("header, strftime per call", legacyHeader);
+  wpr_log_setClock(WPR_LOG_CLOCK_REALTIME);
+  benchHeader("header, cached, realtime", cachedHeader);
+  wpr_log_setClock(WPR_LOG_CLOCK_COARSE);
+  benchHeader("header, cached, coarse", cachedHeader);
+  wpr_log_setClock(WPR_LOG_CLOCK_TSC);
+  benchHeader("header, cached, tsc", cachedHeader);
+
+  benchLog("wpr_log file, realtime", WPR_LOG_CLOCK_REALTIME);
+  benchLog("wpr_log file, coarse", WPR_LOG_CLOCK_COARSE);
+  benchLog("wpr_log file, tsc", WPR_LOG_CLOCK_TSC);
+  return 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * trace_bench: caller side cost of wpr_log() per appender and mode, for
+ * 1 to N threads and small or large messages.
+ *
+ * usage: trace_bench [max threads [calls per thread [async ring size]]]
+ *
+ * prints one CSV line per run: average and p50/p99 latency of a call as
+ * seen by the caller, calls/sec of all threads together and the bytes
+ * the appender wrote, and records dropped by async modes because a
+ * thread ring was full. console output goes to a scratch file.
+ */
+#include <tracing.h>
+#include <traceclock.h>
+#include <tracering.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+using namespace wpr_tracing;
+
+enum Sink
+{
+  SINK_NONE,
+  SINK_CONSOLE,
+  SINK_FILE,
+  SINK_BINARY,
+  SINK_RING
+};
+
+struct Mode
+{
+  const char * name;
+  Sink sink;
+  bool async;
+  const char * file;
+};
+
+static const Mode modes[] = {
+  { "disabled",      SINK_NONE,    false, NULL },
+  { "console",       SINK_CONSOLE, false, "trace_bench.out" },
+  { "file",          SINK_FILE,    false, "trace_bench.log" },
+  { "binary",        SINK_BINARY,  false, "trace_bench.wprb" },
+  { "ring",          SINK_RING,    false, "trace_bench.ring" },
+  { "async_console", SINK_CONSOLE, true,  "trace_bench.out" },
+  { "async_file",    SINK_FILE,    true,  "trace_bench_async.log" },
+  { "async_binary",  SINK_BINARY,  true,  "trace_bench_async.wprb" }
+};
+
+#define BENCH_RING_SIZE (4 * 1024 * 1024)
+
+static char largeText[257];
+static unsigned int asyncRingSize = 0;
+
+struct Run
+{
+  unsigned int peer;
+  bool large;
+  unsigned int calls;
+  pthread_barrier_t * barrier;
+  std::vector<unsigned int> latencies;  //ticks per call.
+  double start;                         //wallSeconds() around the calls.
+  double end;
+};
+
+static double
+wallSeconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *
+runThread(void * arg)
+{
+  Run * run = (Run *)arg;
+  run->latencies.resize(run->calls);
+  pthread_barrier_wait(run->barrier);
+  run->start = wallSeconds();
+  for(unsigned int i = 0; i < run->calls; ++i){
+    unsigned long long t0 = traceClockNow();
+    if(run->large){
+      WPR_LOG(run->peer, "large message %u %s", i, largeText);
+    }else{
+      WPR_LOG(run->peer, "small message %u", i);
+    }
+    run->latencies[i] = traceClockNow() - t0;
+  }
+  run->end = wallSeconds();
+  return NULL;
+}
+
+//bytes the appender of mode has written so far.
+static unsigned long long
+bytesWritten(const Mode& mode)
+{
+  if(NULL == mode.file){
+    return 0;
+  }
+  if(mode.sink == SINK_RING){
+    RingHeader header;
+    int fd = open(mode.file, O_RDONLY);
+    bool ok = fd != -1 && pread(fd, &header, sizeof(header), 0) == sizeof(header);
+    if(fd != -1){
+      close(fd);
+    }
+    return ok ? header.head : 0;
+  }
+  struct stat st;
+  return stat(mode.file, &st) == 0 ? st.st_size : 0;
+}
+
+static void
+bench(FILE * out, const Mode& mode, unsigned int peer, unsigned int threads,
+      bool large, unsigned int calls)
+{
+  if(mode.async){
+    wpr_log_enableAsync(asyncRingSize);
+  }
+  unsigned long droppedBefore = wpr_log_getDroppedCount();
+  unsigned long long bytesBefore = bytesWritten(mode);
+
+  pthread_barrier_t barrier;
+  pthread_barrier_init(&barrier, NULL, threads + 1);
+  std::vector<Run> runs(threads);
+  std::vector<pthread_t> ids(threads);
+  for(unsigned int t = 0; t < threads; ++t){
+    runs[t].peer = peer;
+    runs[t].large = large;
+    runs[t].calls = calls;
+    runs[t].barrier = &barrier;
+    pthread_create(&ids[t], NULL, runThread, &runs[t]);
+  }
+  pthread_barrier_wait(&barrier);
+  for(unsigned int t = 0; t < threads; ++t){
+    pthread_join(ids[t], NULL);
+  }
+  pthread_barrier_destroy(&barrier);
+  //the workers time themselves, they may be done before we run again.
+  double start = runs[0].start;
+  double end = runs[0].end;
+  for(unsigned int t = 1; t < threads; ++t){
+    start = std::min(start, runs[t].start);
+    end = std::max(end, runs[t].end);
+  }
+  double seconds = end - start;
+
+  wpr_log_flush();
+  if(mode.async){
+    wpr_log_disableAsync();
+  }
+  unsigned long dropped = wpr_log_getDroppedCount() - droppedBefore;
+  unsigned long long bytes = bytesWritten(mode) - bytesBefore;
+
+  std::vector<unsigned int> all;
+  all.reserve((size_t)threads * calls);
+  for(unsigned int t = 0; t < threads; ++t){
+    all.insert(all.end(), runs[t].latencies.begin(), runs[t].latencies.end());
+  }
+  std::sort(all.begin(), all.end());
+  double sum = 0;
+  for(size_t i = 0; i < all.size(); ++i){
+    sum += all[i];
+  }
+  double nsPerTick = 1e9 / traceClockInfo().hz;
+  double total = (double)threads * calls;
+  fprintf(out, "%s,%u,%s,%.0f,%.1f,%.0f,%.1f,%.1f,%llu,%lu\n",
+          mode.name, threads, large ? "large" : "small", total,
+          sum / total * nsPerTick, total / seconds,
+          all[all.size() / 2] * nsPerTick,
+          all[(size_t)(all.size() * 0.99)] * nsPerTick,
+          bytes, dropped);
+  fflush(out);
+}
+
+int
+main(int argc, char * argv[])
+{
+  unsigned int maxThreads = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int calls = argc > 2 ? atoi(argv[2]) : 20000;
+  asyncRingSize = argc > 3 ? atoi(argv[3]) : 0;
+  if(maxThreads == 0 || calls == 0){
+    fprintf(stderr, "usage: %s [max threads [calls per thread [async ring size]]]\n", argv[0]);
+    return 2;
+  }
+  memset(largeText, 'x', sizeof(largeText) - 1);
+  traceClockInfo();
+
+  //keep the results on the real stdout, console appenders write to a file.
+  FILE * out = fdopen(dup(STDOUT_FILENO), "w");
+  const int modeCount = sizeof(modes) / sizeof(modes[0]);
+  for(int m = 0; m < modeCount; ++m){
+    if(NULL != modes[m].file){
+      unlink(modes[m].file);
+    }
+  }
+  int console = open("trace_bench.out", O_WRONLY|O_CREAT|O_TRUNC, 0644);
+  dup2(console, STDOUT_FILENO);
+  close(console);
+
+  fprintf(out, "mode,threads,message,calls,ns_per_call,calls_per_sec,"
+               "p50_ns,p99_ns,bytes,dropped\n");
+  for(int m = 0; m < modeCount; ++m){
+    const Mode& mode = modes[m];
+    unsigned int peer = 500 + m;
+    switch(mode.sink){
+      case SINK_CONSOLE:
+        wpr_log_addConsoleAppender(peer);
+        break;
+      case SINK_FILE:
+        wpr_log_addFileAppender(peer, mode.file, NULL);
+        break;
+      case SINK_BINARY:
+        wpr_log_addBinaryAppender(peer, mode.file);
+        break;
+      case SINK_RING:
+        wpr_log_addMmapRingAppender(peer, mode.file, BENCH_RING_SIZE);
+        break;
+      default:
+        break; //no appender, the peer stays disabled.
+    }
+    for(unsigned int threads = 1; threads <= maxThreads; threads *= 2){
+      bench(out, mode, peer, threads, false, calls);
+      bench(out, mode, peer, threads, true, calls);
+    }
+  }
+  for(int m = 0; m < modeCount; ++m){
+    if(NULL != modes[m].file){
+      unlink(modes[m].file);
+    }
+  }
+  fclose(out);
+  return 0;
+}
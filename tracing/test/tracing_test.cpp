@@ -1,6 +1,10 @@
 #include <tracing.h>
 #include <cstdarg>
 #include <stdio.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
 using namespace wpr_tracing;
 
 void
@@ -18,9 +22,227 @@ log_test()
   WPR_LOG(100,"hello world 100");
 }
 
+void *
+async_log_thread(void * arg)
+{
+  long id = (long)arg;
+  for(int i = 0; i < 1000; ++i){
+    WPR_LOG(140, "async thread %ld message %d %s %.2f", id, i, "text", i / 3.0);
+  }
+  return NULL;
+}
+
+void
+async_log_test()
+{
+  wpr_log_addConsoleAppender(140);
+  wpr_log_enableAsync(64);
+  WPR_LOG(140, "async %s %5d|%-5d|%*d|%.*s|%c|%lu|%zu|%p|%%",
+          "hello", 1, 2, 4, 3, 2, "abc", 'x', 4UL, (size_t)5, (void *)0x10);
+  char view[4] = { 'v', 'i', 'e', 'w' }; //not terminated.
+  WPR_LOG(140, "async %.4s|%.*s", view, 2, view);
+  pthread_t threads[4];
+  for(long i = 0; i < 4; ++i){
+    pthread_create(&threads[i], NULL, async_log_thread, (void *)i);
+  }
+  for(int i = 0; i < 4; ++i){
+    pthread_join(threads[i], NULL);
+  }
+  wpr_log_flush();
+  printf("async dropped records: %lu\n", wpr_log_getDroppedCount());
+  wpr_log_disableAsync();
+  WPR_LOG(140, "back to sync");
+}
+
+void
+binary_log_test()
+{
+  unlink("tracing_test.wprb");
+  wpr_log_addConsoleAppender(160);
+  wpr_log_addBinaryAppender(160, "tracing_test.wprb");
+  for(int i = 0; i < 3; ++i){
+    WPR_LOG(160, "binary %d %s %.3f %p", i, "text", i / 7.0, (void *)0x20);
+  }
+  WPR_LOG(160, "not encodable %m");
+  wpr_log_flush();
+  printf("decoded:\n");
+  fflush(stdout);
+  system("../wpr_trace_decode tracing_test.wprb");
+  unlink("tracing_test.wprb");
+}
+
+static long
+file_size(const char * name)
+{
+  struct stat st;
+  return stat(name, &st) == 0 ? (long)st.st_size : -1;
+}
+
+void
+file_log_test()
+{
+  const char * names[] = { "tracing_test.log", "tracing_test.log.1",
+                           "tracing_test.log.2", "tracing_test.log.3",
+                           "tracing_test_other.log" };
+  for(int i = 0; i < 5; ++i){
+    unlink(names[i]);
+  }
+  struct wpr_log_fileOptions options = { 0 };
+  options.bufferSize = 4096;
+  options.rotateBytes = 8192;
+  options.keepFiles = 2;
+  options.preallocate = 65536;
+  wpr_log_addFileAppender(220, "tracing_test.log", &options);
+  wpr_log_addFileAppender(221, "tracing_test_other.log", NULL);
+  for(int i = 0; i < 1000; ++i){
+    WPR_LOG(220, "rotated line %d", i);
+  }
+  WPR_LOG(221, "other file");
+  wpr_log_flush();
+  for(int i = 0; i < 5; ++i){
+    long size = file_size(names[i]);
+    printf("%s: %s\n", names[i], size < 0 ? "missing" :
+           size == 0 ? "empty" : size <= 8192 ? "ok" : "too large");
+    unlink(names[i]);
+  }
+}
+
+void
+ring_log_test()
+{
+  unlink("tracing_test.ring");
+  wpr_log_addMmapRingAppender(240, "tracing_test.ring", 65536);
+  for(int i = 0; i < 5000; ++i){
+    WPR_LOG(240, "ring line %d", i);
+  }
+  printf("ring tail:\n");
+  fflush(stdout);
+  system("../wpr_ring_dump tracing_test.ring | tail -2 | sed 's/.*: //'");
+  system("../wpr_ring_dump tracing_test.ring | wc -l | "
+         "awk '{ print ($1 > 500 && $1 < 5000) ? \"ring wrapped\" : \"ring broken\" }'");
+  unlink("tracing_test.ring");
+}
+
+void *
+span_thread(void * arg)
+{
+  for(long i = 0; i < 10; ++i){
+    TraceSpan span("worker step", "test");
+    span.arg("step", i).arg("thread", "worker");
+  }
+  return NULL;
+}
+
+void
+span_test()
+{
+  WPR_SPAN("never recorded, spans are stopped");
+  wpr_span_start(16);
+  {
+    WPR_SPAN("outer");
+    WPR_SPAN("inner \"quoted\"");
+    unsigned long long start = wpr_span_begin();
+    wpr_span_end("c span", "test", start, "co", "a name longer than the copied text");
+  }
+  pthread_t thread;
+  pthread_create(&thread, NULL, span_thread, NULL);
+  pthread_join(thread, NULL);
+  for(int i = 0; i < 20; ++i){
+    WPR_SPAN("overflow");
+  }
+  wpr_span_stop();
+  unlink("tracing_test.json");
+  wpr_span_exportChrome("tracing_test.json");
+  printf("spans dropped: %lu\n", wpr_span_getDroppedCount());
+  fflush(stdout);
+  system("grep -c '\"ph\":\"X\"' tracing_test.json");
+  system("grep -m1 'c span' tracing_test.json | sed 's/\"ts.*tid[^,]*//'");
+  unlink("tracing_test.json");
+}
+
+void *
+register_thread(void * arg)
+{
+  //register peers concurrently, partly beyond the directly indexed ones.
+  long id = (long)arg;
+  for(unsigned int peer = 0; peer < 200; ++peer){
+    wpr_log_addConsoleAppender(2000 + peer * 7 + id);
+    WPR_LOG(2000 + peer * 7 + id, "peer %u", peer);
+  }
+  return NULL;
+}
+
+void
+peer_test()
+{
+  WPR_LOG(180, "never printed, peer has no appenders");
+  wpr_log_addConsoleAppender(180);
+  wpr_log_setEnabled(180, 0);
+  WPR_LOG(180, "never printed, peer is disabled");
+  wpr_log_setEnabled(180, 1);
+  WPR_LOG(180, "peer 180 enabled again");
+
+  pthread_t threads[4];
+  for(long i = 0; i < 4; ++i){
+    pthread_create(&threads[i], NULL, register_thread, (void *)i);
+  }
+  for(int i = 0; i < 4; ++i){
+    pthread_join(threads[i], NULL);
+  }
+  int enabled = 0;
+  for(unsigned int peer = 0; peer < 200; ++peer){
+    for(unsigned int id = 0; id < 4; ++id){
+      enabled += wpr_log_isEnabled(2000 + peer * 7 + id);
+    }
+  }
+  printf("enabled peers: %d of 800\n", enabled);
+}
+
+static int evaluated = 0;
+
+static int
+evaluate()
+{
+  return ++evaluated;
+}
+
+void
+traced_call()
+{
+  WPR_LOG_FUNCTION(200);
+}
+
+void
+level_test()
+{
+  wpr_log_addConsoleAppender(200);
+  wpr_log_setLevel(200, WPR_LEVEL_WARN);
+  WPR_LOG_DEBUG(200, "never printed, below level %d", evaluate());
+  WPR_LOG(200, "never printed, below level %d", evaluate());
+  WPR_LOG_WARN(200, "warning printed");
+  WPR_LOG_ERROR(200, "error printed");
+  printf("arguments evaluated: %d\n", evaluated);
+
+  wpr_log_setLevel(200, WPR_LEVEL_TRACE);
+  wpr_log_setFunctionSampling(200, 4, 0);
+  for(int i = 0; i < 8; ++i){
+    traced_call(); //two calls are traced.
+  }
+  wpr_log_setFunctionSampling(200, 1, 1000000);
+  traced_call(); //returns too fast to be traced.
+  wpr_log_setFunctionSampling(200, 1, 0);
+}
+
 int
 main()
 {
   log_test();
   func_log_test();
+  async_log_test();
+  binary_log_test();
+  peer_test();
+  level_test();
+  file_log_test();
+  ring_log_test();
+  span_test();
 } 
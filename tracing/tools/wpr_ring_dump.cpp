@@ -0,0 +1,95 @@
+/*
+ * wpr_ring_dump: print the lines kept in a ring written by
+ * MmapRingTraceAppender, oldest first. The file may come from a process
+ * which is still running or has crashed.
+ *
+ * usage: wpr_ring_dump file...
+ */
+#include "../src/tracering.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace wpr_tracing;
+
+static
+bool
+dumpFile(const char * filename, FILE * out)
+{
+  int fd = open(filename, O_RDONLY);
+  if(fd == -1){
+    perror(filename);
+    return false;
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (size_t)st.st_size < WPR_TRACE_RING_HEADER_SIZE){
+    fprintf(stderr, "%s: not a trace ring\n", filename);
+    close(fd);
+    return false;
+  }
+  void * map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED){
+    perror(filename);
+    return false;
+  }
+
+  bool ok = true;
+  const RingHeader * header = (const RingHeader *)map;
+  const char * data = (const char *)map + WPR_TRACE_RING_HEADER_SIZE;
+  uint64_t capacity = header->capacity;
+  //a writer may still be running: take tail first, entries before head
+  //which it overwrites meanwhile are detected by re-reading tail.
+  uint64_t head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+  uint64_t pos = __atomic_load_n(&header->tail, __ATOMIC_ACQUIRE);
+  if(0 != memcmp(header->magic, WPR_TRACE_RING_MAGIC, sizeof(header->magic))
+     || header->version != WPR_TRACE_RING_VERSION
+     || header->headerSize != WPR_TRACE_RING_HEADER_SIZE
+     || (uint64_t)st.st_size != WPR_TRACE_RING_HEADER_SIZE + capacity
+     || pos > head || head - pos > capacity){
+    fprintf(stderr, "%s: not a trace ring\n", filename);
+    ok = false;
+    head = pos;
+  }
+  while(pos < head){
+    uint64_t offset = pos % capacity;
+    uint32_t length = *(const uint32_t *)(data + offset);
+    if(length == WPR_TRACE_RING_WRAP){
+      pos += capacity - offset;
+      continue;
+    }
+    if(ringEntrySize(length) > capacity - offset){
+      fprintf(stderr, "%s: corrupt entry at %llu\n", filename,
+              (unsigned long long)pos);
+      ok = false;
+      break;
+    }
+    if(pos < __atomic_load_n(&header->tail, __ATOMIC_ACQUIRE)){
+      pos = header->tail; //overwritten while we were reading.
+      continue;
+    }
+    fwrite(data + offset + sizeof(uint32_t), 1, length, out);
+    pos += ringEntrySize(length);
+  }
+  munmap(map, st.st_size);
+  return ok;
+}
+
+int
+main(int argc, char * argv[])
+{
+  if(argc < 2){
+    fprintf(stderr, "usage: %s file...\n", argv[0]);
+    return 2;
+  }
+  int rc = 0;
+  for(int i = 1; i < argc; ++i){
+    if(!dumpFile(argv[i], stdout)){
+      rc = 1;
+    }
+  }
+  return rc;
+}
@@ -0,0 +1,157 @@
+/*
+ * wpr_trace_decode: render files written by BinaryTraceAppender as the
+ * text FileTraceAppender would have written.
+ *
+ * usage: wpr_trace_decode file...
+ */
+#include "../src/traceappender.h"
+#include "../src/traceargs.h"
+#include "../src/traceclock.h"
+#include "../src/tracebinary.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace wpr_tracing;
+
+struct Callsite
+{
+  int line;
+  std::string srcfile;
+  std::string function;
+  std::string format;
+};
+
+static
+bool
+decodeFile(const char * filename, FILE * out)
+{
+  FILE * in = (0 == strcmp(filename, "-")) ? stdin : fopen(filename, "rb");
+  if(NULL == in){
+    perror(filename);
+    return false;
+  }
+
+  TraceClockInfo clock;
+  memset(&clock, 0, sizeof(clock));
+  std::vector<Callsite> callsites;
+  std::vector<char> payload;
+  char msgbuf[MAX_BUFFER_SIZE + 1];
+  bool ok = true;
+  bool session = false;
+  BinaryEntry entry;
+  while(1 == fread(&entry, sizeof(entry), 1, in)){
+    payload.resize(entry.length + 1);
+    if(entry.length > 0 && 1 != fread(&payload[0], entry.length, 1, in)){
+      fprintf(stderr, "%s: truncated entry\n", filename);
+      ok = false;
+      break;
+    }
+    payload[entry.length] = '\0';
+
+    switch(entry.type){
+      case ENTRY_SESSION:
+        {
+          BinarySession s;
+          if(entry.length < sizeof(s)
+             || 0 != memcmp(&payload[0], WPR_TRACE_BINARY_MAGIC, sizeof(s.magic))){
+            fprintf(stderr, "%s: not a binary trace file\n", filename);
+            ok = false;
+            break;
+          }
+          memcpy(&s, &payload[0], sizeof(s));
+          if(s.version != WPR_TRACE_BINARY_VERSION){
+            fprintf(stderr, "%s: unsupported version %u\n", filename, s.version);
+            ok = false;
+            break;
+          }
+          clock.hz = s.hz;
+          clock.baseTicks = s.baseTicks;
+          clock.baseTime.tv_sec = s.baseSec;
+          clock.baseTime.tv_usec = s.baseUsec;
+          callsites.clear(); //ids start again with each session.
+          session = true;
+        }
+        break;
+
+      case ENTRY_CALLSITE:
+        {
+          Callsite c;
+          int32_t line = 0;
+          if(entry.length >= sizeof(line)){
+            memcpy(&line, &payload[0], sizeof(line));
+          }
+          c.line = line;
+          //three NUL terminated strings follow the line.
+          const char * p = &payload[0] + sizeof(line);
+          const char * end = &payload[0] + entry.length;
+          std::string * fields[3] = { &c.srcfile, &c.function, &c.format };
+          for(int i = 0; i < 3 && p < end; ++i){
+            *fields[i] = p;
+            p += fields[i]->size() + 1;
+          }
+          if(entry.callsite >= callsites.size()){
+            callsites.resize(entry.callsite + 1);
+          }
+          callsites[entry.callsite] = c;
+        }
+        break;
+
+      case ENTRY_RECORD:
+      case ENTRY_TEXT:
+        {
+          if(!session || entry.callsite >= callsites.size()){
+            fprintf(stderr, "%s: record of unknown callsite %u\n",
+                    filename, entry.callsite);
+            ok = false;
+            break;
+          }
+          const Callsite& c = callsites[entry.callsite];
+          struct timeval timestamp;
+          traceClockToTimeval(clock, entry.ticks, timestamp);
+          unsigned int n = buildTraceHeader(msgbuf, MAX_BUFFER_SIZE, timestamp,
+                                            c.srcfile.c_str(), c.line);
+          if(entry.type == ENTRY_RECORD){
+            n += decodeTraceArgs(c.format.c_str(), &payload[0], entry.length,
+                                 msgbuf + n, MAX_BUFFER_SIZE - n);
+          }else{
+            n += snprintf(msgbuf + n, MAX_BUFFER_SIZE - n, "%s", &payload[0]);
+            if(n > MAX_BUFFER_SIZE - 1){
+              n = MAX_BUFFER_SIZE - 1;
+            }
+          }
+          msgbuf[n++] = '\n';
+          fwrite(msgbuf, 1, n, out);
+        }
+        break;
+
+      default:
+        break; //skip entries of newer writers.
+    }
+    if(!ok){
+      break;
+    }
+  }
+
+  if(in != stdin){
+    fclose(in);
+  }
+  return ok;
+}
+
+int
+main(int argc, char * argv[])
+{
+  if(argc < 2){
+    fprintf(stderr, "usage: %s file...\n", argv[0]);
+    return 2;
+  }
+  int rc = 0;
+  for(int i = 1; i < argc; ++i){
+    if(!decodeFile(argv[i], stdout)){
+      rc = 1;
+    }
+  }
+  return rc;
+}
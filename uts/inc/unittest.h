@@ -30,6 +30,8 @@ namespace uts
   class TestContext;     // Context information for test cases
   class TestVisitor;     // Base class for objects that can visit all nodes
                          // in a test hierarchy.
+  class Benchmark;       // Test cases which measure the time of a body
+  class BenchmarkState;  // Iteration control for benchmark bodies
   class XTestFailure;    // Exception object indicating test case failure.
   class RootTestSuite;   // Hidden class for root suite.
 
@@ -163,6 +165,72 @@ namespace uts
 
   };
 
+  /*
+    BenchmarkState is handed to the body of a benchmark. The body repeats
+    the code to measure while keepRunning() returns true; the time from
+    the first call to keepRunning() until it returns false is taken as
+    the time of iterations() repetitions, so setup code before the loop
+    is not measured. pauseTiming() and resumeTiming() exclude work inside
+    the loop.
+  */
+  class BenchmarkState
+  {
+  public:
+    UTS_EXPORT BenchmarkState(TestContext& context, unsigned long iterations);
+
+    bool keepRunning()
+    {
+      if (m_remaining > 0) {
+        if (m_remaining-- == m_iterations)
+          resumeTiming();
+        return true;
+      }
+      pauseTiming();
+      return false;
+    }
+
+    UTS_EXPORT void pauseTiming();
+    UTS_EXPORT void resumeTiming();
+
+    unsigned long iterations() const {return m_iterations;}
+    TestContext& context() const {return m_context;}
+
+    // Measured nanoseconds, and whether the body ran all iterations.
+    double elapsedNs() const {return m_elapsedNs;}
+    bool finished() const {return m_remaining == 0 && !m_running;}
+
+  private:
+    TestContext&  m_context;
+    unsigned long m_iterations;
+    unsigned long m_remaining;
+    bool          m_running;
+    double        m_startNs;
+    double        m_elapsedNs;
+  };
+
+  /*
+    A benchmark is a test case whose body is run in a timed loop by a
+    BenchmarkRunner. Run by other visitors (e.g. TestRunner), it runs the
+    body for a single iteration, so benchmarks are checked along with
+    the tests.
+  */
+  class Benchmark : public TestCase
+  {
+  public:
+    UTS_EXPORT virtual void run(TestContext&);
+
+    /*
+      measure() runs the body for the given number of iterations and
+      returns the measured nanoseconds. It throws XTestFailure if the
+      body does not loop on keepRunning().
+    */
+    UTS_EXPORT virtual double measure(TestContext&, unsigned long iterations);
+
+  protected:
+    UTS_EXPORT Benchmark(const std::string& name, TestSuite& parent);
+    UTS_EXPORT virtual void runBody(BenchmarkState&) = 0;
+  };
+
   /*
     A test suite is a composite test.
   */
@@ -34,6 +34,23 @@
 #define DefineTestCase(_name_, _suite_) \
   static uts::IndirectTestCase _name_##TestCase(#_name_, _suite_, &_name_); \
 
+// DefineBenchmark defines a benchmark whose body is a function taking a
+// uts::BenchmarkState&. The body must loop on state.keepRunning():
+//
+//   void StringAppend(uts::BenchmarkState& state)
+//   {
+//     std::string s;
+//     while (state.keepRunning())
+//       s += 'x';
+//     uts::doNotOptimize(s);
+//   }
+//   DefineBenchmark(StringAppend, StringTests);
+//
+// Benchmarks are measured when the test program runs with --bench,
+// otherwise they run once along with the test cases.
+#define DefineBenchmark(_name_, _suite_) \
+  static uts::IndirectBenchmark _name_##Benchmark(#_name_, _suite_, &_name_); \
+
 ///////////////////////////////////////////////////////////////////////////////
 // Macros to help define the bodies of test case functions.
 // If you use these macros, test runner objects should be able to print out
@@ -119,5 +136,49 @@ namespace uts
     void (*m_func)(TestContext&);
   };
 
+  // The benchmark counterpart of IndirectTestCase.
+  class IndirectBenchmark : public Benchmark
+  {
+  public:
+    UTS_EXPORT IndirectBenchmark(const char*, TestSuite&,
+                                 void (*func)(BenchmarkState&));
+  protected:
+    UTS_EXPORT void runBody (BenchmarkState&);
+  private:
+    void (*m_func)(BenchmarkState&);
+  };
+
+  /*
+    doNotOptimize() makes the compiler assume that value is read, so a
+    benchmark body computing it is not optimized away. clobberMemory()
+    makes it assume that all memory is read and written, forcing pending
+    stores to be done.
+  */
+#if defined(__GNUC__)
+  template <class T>
+  inline void doNotOptimize(const T& value)
+  {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  inline void clobberMemory()
+  {
+    asm volatile("" : : : "memory");
+  }
+#else
+  UTS_EXPORT void useCharPointer(const volatile char*);
+
+  template <class T>
+  inline void doNotOptimize(const T& value)
+  {
+    useCharPointer(&reinterpret_cast<const volatile char&>(value));
+  }
+
+  inline void clobberMemory()
+  {
+    useCharPointer(0);
+  }
+#endif
+
 }
 #endif
@@ -1,6 +1,8 @@
 #ifdef _WIN32
 #include "TestRunner.h"
+#include "allocations.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <sstream>
@@ -9,14 +11,108 @@
 namespace uts
 {
   TestRunner::TestRunner(TestContext* context)
-    : m_context(context), m_tests(0), m_failures(0), m_errors(0)
+    : m_context(context), m_tests(0), m_failures(0), m_errors(0),
+      m_jobs(0), m_timeout(0), m_counters(false), m_budgetNs(0),
+      m_leakLimit(-1), m_slowest(0),
+      m_filter(0), m_shardIndex(0), m_shardCount(1), m_selected(0),
+      m_repeat(1), m_shuffle(false), m_seed(0)
   {
     assert(context);
   }
 
+  void TestRunner::setParallel(unsigned int jobs, double timeout)
+  {
+    // every test already runs in its own process here.
+    m_jobs = jobs;
+    m_timeout = timeout;
+  }
+
+  // splitmix64, the same order for a seed as in testrunner.cpp.
+  static unsigned long long nextRandom(unsigned long long& state)
+  {
+    unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  void TestRunner::finishTests()
+  {
+    for (unsigned int round = 0; round < m_repeat && !m_queue.empty(); ++round) {
+      if (m_context->shouldStop())
+        break;
+      std::vector<Queued> order(m_queue);
+      if (m_shuffle) {
+        unsigned long long state = m_seed + round;
+        for (size_t i = order.size() - 1; i > 0; --i)
+          std::swap(order[i], order[nextRandom(state) % (i + 1)]);
+      }
+      logS() << "Round " << round + 1 << " of " << m_repeat;
+      if (m_shuffle)
+        logS() << ", shuffled with seed " << m_seed + round;
+      logS() << std::endl;
+      for (size_t i = 0; i < order.size() && !m_context->shouldStop(); ++i)
+        runTest(*order[i].test, order[i].path);
+    }
+    m_queue.clear();
+  }
+
+  // The tests are not measured here (TestMeter has no counters on
+  // Windows), so the settings are only remembered.
+  void TestRunner::setCounters(bool enabled)
+  {
+    m_counters = enabled;
+    if (enabled && !m_meter.enableCounters())
+      logS() << "hardware counters are not available\n";
+  }
+
+  void TestRunner::setTimeBudget(double seconds)
+  {
+    m_budgetNs = seconds * 1e9;
+  }
+
+  // Allocations are not counted on Windows, so no test fails for its
+  // leaks.
+  void TestRunner::setLeakLimit(long long blocks)
+  {
+    m_leakLimit = blocks;
+    if (blocks >= 0 && !canCountAllocations())
+      logS() << "allocations can not be counted\n";
+  }
+
+  void TestRunner::setSlowestReport(unsigned int count)
+  {
+    m_slowest = count;
+  }
+
   bool TestRunner::shouldVisit(const std::string& path) const
   {
-    return true;
+    if (path.empty() || path[path.size() - 1] == SEPCHAR)
+      return true;
+    return m_filter == 0 || m_filter->matches(path);
+  }
+
+  void TestRunner::setFilter(const TestFilter* filter)
+  {
+    m_filter = filter;
+  }
+
+  void TestRunner::setShard(unsigned int index, unsigned int count)
+  {
+    assert(count > 0 && index < count);
+    m_shardIndex = index;
+    m_shardCount = count;
+  }
+
+  void TestRunner::setRepeat(unsigned int count)
+  {
+    m_repeat = count > 0 ? count : 1;
+  }
+
+  void TestRunner::setShuffle(bool shuffle, unsigned long seed)
+  {
+    m_shuffle = shuffle;
+    m_seed = seed;
   }
 
   void TestRunner::printSummary() const
@@ -88,8 +184,28 @@ namespace uts
     if (m_context->shouldStop())
       return false;
     if (!shouldVisit(currentPath() + test.name()))
-      return false;
+      return true;  // skip it, but go on with its siblings
+
+    if (m_selected++ % m_shardCount != m_shardIndex)
+      return true;
 
+    std::string path = currentPath() + test.name();
+    if (m_repeat > 1 || m_shuffle) {
+      Queued queued;
+      queued.test = &test;
+      queued.path = path;
+      m_queue.push_back(queued);
+      return true;
+    }
+
+    runTest(test, path);
+    // Always continue, regardless of test result, unless the context
+    // object says otherwise.
+    return !m_context->shouldStop();
+  }
+
+  void TestRunner::runTest(TestCase& test, const std::string& path)
+  {
     int fd[2] = {0};
     pipe(fd);
     int pid = fork();
@@ -97,8 +213,8 @@ namespace uts
     {
       //child process
       close(fd[0]);
-      int rst = runTestCase(test, *m_context, logS());
-      logS() << currentPath() << test.name() << std::endl;
+      int rst = uts::runTestCase(test, *m_context, logS());
+      logS() << path << std::endl;
       write(fd[1],&rst, sizeof(rst));
       close(fd[1]);
       exit(0);
@@ -113,13 +229,10 @@ namespace uts
         m_failures++;
     }else{
       //test core dumped.
-      logS()<<"CORE-DUMPED:" << currentPath() << test.name() << std::endl;
+      logS()<<"CORE-DUMPED:" << path << std::endl;
       m_errors++;
     }
     m_tests++;
-    // Always continue, regardless of test result, unless the context
-    // object says otherwise.
-    return !m_context->shouldStop();
   }
 }
 #endif
\ No newline at end of file
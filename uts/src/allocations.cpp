@@ -0,0 +1,172 @@
+#ifndef _WIN32
+#include "allocations.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <unistd.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+
+extern "C"
+{
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* p, size_t size);
+  void* __libc_memalign(size_t alignment, size_t size);
+  void  __libc_free(void* p);
+}
+#endif
+
+namespace uts
+{
+  static int counting = 0;
+  static AllocationCounts counts;
+
+  static inline bool isCounting()
+  {
+    return __atomic_load_n(&counting, __ATOMIC_RELAXED) > 0;
+  }
+
+  static inline void add(long long& counter, long long value)
+  {
+    __atomic_fetch_add(&counter, value, __ATOMIC_RELAXED);
+  }
+
+  void countAllocations(bool on)
+  {
+    __atomic_fetch_add(&counting, on ? 1 : -1, __ATOMIC_SEQ_CST);
+  }
+
+  void readAllocationCounts(AllocationCounts& result)
+  {
+    result.allocations = __atomic_load_n(&counts.allocations, __ATOMIC_RELAXED);
+    result.allocatedBytes = __atomic_load_n(&counts.allocatedBytes,
+                                            __ATOMIC_RELAXED);
+    result.liveBlocks = __atomic_load_n(&counts.liveBlocks, __ATOMIC_RELAXED);
+    result.liveBytes = __atomic_load_n(&counts.liveBytes, __ATOMIC_RELAXED);
+  }
+
+#if defined(__GLIBC__)
+  bool canCountAllocations()
+  {
+    return true;
+  }
+
+  static inline void allocated(void* p, size_t size)
+  {
+    if (p == 0 || !isCounting())
+      return;
+    add(counts.allocations, 1);
+    add(counts.allocatedBytes, size);
+    add(counts.liveBlocks, 1);
+    add(counts.liveBytes, malloc_usable_size(p));
+  }
+
+  static inline void freed(size_t usableSize)
+  {
+    if (!isCounting())
+      return;
+    add(counts.liveBlocks, -1);
+    add(counts.liveBytes, -(long long)usableSize);
+  }
+#else
+  bool canCountAllocations()
+  {
+    return false;
+  }
+#endif
+}
+
+#if defined(__GLIBC__)
+using uts::allocated;
+using uts::freed;
+using uts::isCounting;
+
+extern "C"
+{
+  void* malloc(size_t size)
+  {
+    void* p = __libc_malloc(size);
+    allocated(p, size);
+    return p;
+  }
+
+  void* calloc(size_t count, size_t size)
+  {
+    void* p = __libc_calloc(count, size);
+    allocated(p, count * size);
+    return p;
+  }
+
+  void* realloc(void* old, size_t size)
+  {
+    size_t oldSize = old != 0 && isCounting() ? malloc_usable_size(old) : 0;
+    void* p = __libc_realloc(old, size);
+    // the old block is gone unless realloc failed (size 0 frees it).
+    if (old != 0 && (p != 0 || size == 0))
+      freed(oldSize);
+    allocated(p, size);
+    return p;
+  }
+
+  void free(void* p)
+  {
+    if (p != 0 && isCounting())
+      freed(malloc_usable_size(p));
+    __libc_free(p);
+  }
+
+  void* memalign(size_t alignment, size_t size)
+  {
+    void* p = __libc_memalign(alignment, size);
+    allocated(p, size);
+    return p;
+  }
+
+  void* aligned_alloc(size_t alignment, size_t size)
+  {
+    return memalign(alignment, size);
+  }
+
+  int posix_memalign(void** result, size_t alignment, size_t size)
+  {
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+      return EINVAL;
+    void* p = memalign(alignment, size);
+    if (p == 0)
+      return ENOMEM;
+    *result = p;
+    return 0;
+  }
+
+  void* valloc(size_t size)
+  {
+    return memalign(sysconf(_SC_PAGESIZE), size);
+  }
+}
+#endif
+#else
+#include "allocations.h"
+
+namespace uts
+{
+  // There is no malloc() to interpose on Windows, so nothing is counted.
+  void countAllocations(bool)
+  {
+  }
+
+  void readAllocationCounts(AllocationCounts& result)
+  {
+    result.allocations = 0;
+    result.allocatedBytes = 0;
+    result.liveBlocks = 0;
+    result.liveBytes = 0;
+  }
+
+  bool canCountAllocations()
+  {
+    return false;
+  }
+}
+#endif
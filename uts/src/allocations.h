@@ -0,0 +1,38 @@
+#if !defined(ALLOCATIONS_HPP_INCLUDED)
+#define ALLOCATIONS_HPP_INCLUDED
+
+#include "utsdefs.h"
+
+namespace uts
+{
+
+  /*
+    libuts interposes on malloc, calloc, realloc, free and the aligned
+    allocators of the C library, which also catches operator new and
+    delete, as libstdc++ implements them with malloc and free. While
+    counting is on, every call from any thread is counted here.
+
+    Live blocks and bytes are net changes: a block allocated before
+    counting started and freed while it is on counts as -1. Bytes of
+    live blocks are the usable sizes of the blocks, allocated bytes the
+    requested ones.
+  */
+
+  struct AllocationCounts
+  {
+    long long allocations;     // calls of malloc, calloc, realloc, ...
+    long long allocatedBytes;
+    long long liveBlocks;      // allocated minus freed blocks
+    long long liveBytes;
+  };
+
+  ////
+  // Counting is on between as many calls with true as with false. The
+  // counts keep their values while it is off.
+  UTS_EXPORT void countAllocations(bool on);
+  UTS_EXPORT void readAllocationCounts(AllocationCounts& counts);
+  ////
+  // Returns false if this build of libuts can not count allocations.
+  UTS_EXPORT bool canCountAllocations();
+}
+#endif
@@ -0,0 +1,286 @@
+#include "benchrunner.h"
+#include "allocations.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace uts
+{
+  // Upper bound of the calibrated iterations per sample.
+  static const unsigned long MaxIterations = 1000000000UL;
+
+  BenchmarkRunner::BenchmarkRunner(TestContext* context)
+    : m_context(context), m_minSampleNs(10e6), m_samples(10),
+      m_warmupSamples(1), m_filter(0)
+  {
+    assert(context);
+  }
+
+  bool BenchmarkRunner::shouldVisit(const std::string& path) const
+  {
+    if (path.empty() || path[path.size() - 1] == SEPCHAR)
+      return true;
+    return m_filter == 0 || m_filter->matches(path);
+  }
+
+  void BenchmarkRunner::setFilter(const TestFilter* filter)
+  {
+    m_filter = filter;
+  }
+
+  void BenchmarkRunner::setMinSampleTime(double seconds)
+  {
+    m_minSampleNs = seconds * 1e9;
+  }
+
+  void BenchmarkRunner::setSamples(unsigned int samples)
+  {
+    m_samples = samples > 0 ? samples : 1;
+  }
+
+  void BenchmarkRunner::setWarmupSamples(unsigned int samples)
+  {
+    m_warmupSamples = samples;
+  }
+
+  bool BenchmarkRunner::visitEnter(TestSuite& suite)
+  {
+    if (m_context->shouldStop())
+      return false;
+
+    if (!TestQualifier::visitEnter(suite))
+      return false;
+
+    if (shouldVisit(currentPath()))
+      return true;
+
+    TestQualifier::visitLeave(suite);
+    return false;
+  }
+
+  bool BenchmarkRunner::visitLeave(TestSuite& suite)
+  {
+    return TestQualifier::visitLeave(suite) && !m_context->shouldStop();
+  }
+
+  bool BenchmarkRunner::visit(TestCase& test)
+  {
+    if (m_context->shouldStop())
+      return false;
+    Benchmark* benchmark = dynamic_cast<Benchmark*>(&test);
+    if (benchmark == 0 || !shouldVisit(currentPath() + test.name()))
+      return true;
+
+    Result result;
+    result.path = currentPath() + test.name();
+    result.iterations = 0;
+    result.samples = 0;
+    result.minNs = result.medianNs = result.p99Ns = 0;
+    result.meanNs = result.stddevNs = 0;
+    result.allocations = result.allocatedBytes = 0;
+    std::map<std::string, double>::const_iterator base =
+      m_baseline.find(result.path);
+    result.baselineNs = base != m_baseline.end() ? base->second : 0;
+    result.failed = false;
+    try {
+      measure(*benchmark, result);
+    }
+    catch (XTestFailure& e) {
+      result.failed = true;
+      result.error = e.what();
+    }
+    catch (std::exception& e) {
+      result.failed = true;
+      result.error = std::string("caught standard exception - ") + e.what();
+    }
+    m_results.push_back(result);
+    return !m_context->shouldStop();
+  }
+
+  void BenchmarkRunner::measure(Benchmark& benchmark, Result& result)
+  {
+    // Calibrate: grow the iterations until one sample is long enough.
+    unsigned long iterations = 1;
+    for (;;) {
+      double ns = benchmark.measure(*m_context, iterations);
+      if (ns >= m_minSampleNs || iterations >= MaxIterations)
+        break;
+      double factor = ns > 0 ? m_minSampleNs * 1.2 / ns : 10;
+      if (factor > 10)
+        factor = 10;
+      else if (factor < 2)
+        factor = 2;
+      iterations = (unsigned long)std::min((double)MaxIterations,
+                                           iterations * factor);
+    }
+
+    for (unsigned int i = 0; i < m_warmupSamples; ++i)
+      benchmark.measure(*m_context, iterations);
+
+    std::vector<double> perIteration;
+    perIteration.reserve(m_samples); // not to count its allocations
+    AllocationCounts before, after;
+    countAllocations(true);
+    readAllocationCounts(before);
+    for (unsigned int i = 0; i < m_samples && !m_context->shouldStop(); ++i)
+      perIteration.push_back(benchmark.measure(*m_context, iterations)
+                             / iterations);
+    readAllocationCounts(after);
+    countAllocations(false);
+    if (perIteration.empty())
+      return;
+    double total = (double)iterations * perIteration.size();
+    result.allocations = (after.allocations - before.allocations) / total;
+    result.allocatedBytes = (after.allocatedBytes - before.allocatedBytes)
+                            / total;
+
+    std::sort(perIteration.begin(), perIteration.end());
+    size_t n = perIteration.size();
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i)
+      sum += perIteration[i];
+    double mean = sum / n;
+    double squares = 0;
+    for (size_t i = 0; i < n; ++i)
+      squares += (perIteration[i] - mean) * (perIteration[i] - mean);
+
+    result.iterations = iterations;
+    result.samples = n;
+    result.minNs = perIteration[0];
+    result.medianNs = n % 2 ? perIteration[n / 2]
+                            : (perIteration[n / 2 - 1] + perIteration[n / 2]) / 2;
+    result.p99Ns = perIteration[(size_t)std::ceil(n * 0.99) - 1];
+    result.meanNs = mean;
+    result.stddevNs = n > 1 ? std::sqrt(squares / (n - 1)) : 0;
+  }
+
+  bool BenchmarkRunner::loadBaseline(const std::string& filename)
+  {
+    std::ifstream in(filename.c_str());
+    if (!in)
+      return false;
+    std::string line;
+    std::getline(in, line); // header
+    while (std::getline(in, line)) {
+      // path,iterations,samples,min_ns,median_ns,...
+      std::vector<std::string> fields;
+      std::stringstream ss(line);
+      std::string field;
+      while (std::getline(ss, field, ','))
+        fields.push_back(field);
+      if (fields.size() >= 5 && !fields[4].empty())
+        m_baseline[fields[0]] = std::strtod(fields[4].c_str(), 0);
+    }
+    return true;
+  }
+
+  static std::string change(const BenchmarkRunner::Result& r)
+  {
+    if (r.baselineNs <= 0 || r.failed)
+      return "";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%+.1f%%",
+                  (r.medianNs - r.baselineNs) * 100 / r.baselineNs);
+    return buf;
+  }
+
+  void BenchmarkRunner::printReport() const
+  {
+    char line[256];
+    logS()
+      << "\n"
+      << "============================================================\n"
+      << "Benchmark Summary (ns per iteration):\n";
+    std::snprintf(line, sizeof(line), "%12s %12s %12s %12s %10s %9s %8s  %s\n",
+                  "min", "median", "p99", "stddev", "iters", "allocs/it",
+                  "change", "benchmark");
+    logS() << line;
+    for (size_t i = 0; i < m_results.size(); ++i) {
+      const Result& r = m_results[i];
+      if (r.failed) {
+        logS() << "FAILED: " << r.path << ": " << r.error << '\n';
+        continue;
+      }
+      std::snprintf(line, sizeof(line),
+                    "%12.1f %12.1f %12.1f %12.1f %10lu %9.2f %8s  %s\n",
+                    r.minNs, r.medianNs, r.p99Ns, r.stddevNs, r.iterations,
+                    r.allocations, change(r).c_str(), r.path.c_str());
+      logS() << line;
+    }
+    logS()
+      << "============================================================\n"
+      << std::endl;
+  }
+
+  void BenchmarkRunner::writeCsv(std::ostream& out) const
+  {
+    out << "benchmark,iterations,samples,min_ns,median_ns,p99_ns,mean_ns,"
+           "stddev_ns,baseline_ns,allocs_per_iter,bytes_per_iter\n";
+    char line[512];
+    for (size_t i = 0; i < m_results.size(); ++i) {
+      const Result& r = m_results[i];
+      if (r.failed)
+        continue;
+      std::snprintf(line, sizeof(line),
+                    "%s,%lu,%u,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f,%.1f\n",
+                    r.path.c_str(), r.iterations, r.samples, r.minNs,
+                    r.medianNs, r.p99Ns, r.meanNs, r.stddevNs, r.baselineNs,
+                    r.allocations, r.allocatedBytes);
+      out << line;
+    }
+  }
+
+  static std::string jsonString(const std::string& s)
+  {
+    std::string quoted("\"");
+    for (size_t i = 0; i < s.size(); ++i) {
+      unsigned char c = s[i];
+      if (c == '"' || c == '\\') {
+        quoted += '\\';
+        quoted += c;
+      }
+      else if (c < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        quoted += buf;
+      }
+      else
+        quoted += c;
+    }
+    return quoted + "\"";
+  }
+
+  void BenchmarkRunner::writeJson(std::ostream& out) const
+  {
+    out << "{\"benchmarks\":[";
+    char line[512];
+    for (size_t i = 0; i < m_results.size(); ++i) {
+      const Result& r = m_results[i];
+      out << (i > 0 ? ",\n" : "\n") << "{\"name\":" << jsonString(r.path);
+      if (r.failed) {
+        out << ",\"error\":" << jsonString(r.error) << "}";
+        continue;
+      }
+      std::snprintf(line, sizeof(line),
+                    ",\"iterations\":%lu,\"samples\":%u,\"min_ns\":%.2f,"
+                    "\"median_ns\":%.2f,\"p99_ns\":%.2f,\"mean_ns\":%.2f,"
+                    "\"stddev_ns\":%.2f,\"allocs_per_iter\":%.3f,"
+                    "\"bytes_per_iter\":%.1f",
+                    r.iterations, r.samples, r.minNs, r.medianNs, r.p99Ns,
+                    r.meanNs, r.stddevNs, r.allocations, r.allocatedBytes);
+      out << line;
+      if (r.baselineNs > 0) {
+        std::snprintf(line, sizeof(line), ",\"baseline_ns\":%.2f,\"change\":%.4f",
+                      r.baselineNs, (r.medianNs - r.baselineNs) / r.baselineNs);
+        out << line;
+      }
+      out << "}";
+    }
+    out << "\n]}\n";
+  }
+}
@@ -0,0 +1,107 @@
+#if !defined(BENCHRUNNER_HPP_INCLUDED)
+#define BENCHRUNNER_HPP_INCLUDED
+
+#include "testqualifier.h"
+#include "testfilter.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "utsdefs.h"
+
+namespace uts
+{
+
+  /*
+    BenchmarkRunner is a visitor which measures the benchmarks of the
+    test hierarchy and skips all other test cases.
+
+    For each benchmark it first calibrates the iteration count, doubling
+    it (or more, from the time taken) until one sample takes at least the
+    minimum sample time. Then it runs the warmup samples, which are not
+    counted, and the measured samples, and computes min, median, p99,
+    mean and standard deviation of the time per iteration. The memory
+    allocations of the measured samples are counted too.
+
+    Results can be written as CSV or JSON. A CSV file written earlier
+    can be loaded as baseline, the report then shows the change of the
+    median against it.
+
+    The visit*() routines honor the context's shouldStop() method.
+  */
+
+  class BenchmarkRunner: public TestQualifier
+  {
+  public:
+    struct Result
+    {
+      std::string   path;          // suite path and name
+      unsigned long iterations;    // per sample
+      unsigned int  samples;
+      double        minNs;         // all times are per iteration
+      double        medianNs;
+      double        p99Ns;
+      double        meanNs;
+      double        stddevNs;
+      double        baselineNs;    // median of the baseline, 0 if none
+      double        allocations;   // per iteration, see AllocationCounts
+      double        allocatedBytes;
+      bool          failed;
+      std::string   error;
+    };
+
+    UTS_EXPORT BenchmarkRunner(TestContext*);
+
+    UTS_EXPORT virtual bool visitEnter(TestSuite&);
+    UTS_EXPORT virtual bool visitLeave(TestSuite&);
+    UTS_EXPORT virtual bool visit(TestCase&);
+
+    ////
+    // Default implementation returns true. Derived classes
+    // may override. This is called once before visiting each
+    // suite or benchmark.
+    UTS_EXPORT virtual bool shouldVisit(const std::string& path) const;
+
+    ////
+    // Measures only the benchmarks whose path the filter matches, 0 for
+    // all of them.
+    UTS_EXPORT void setFilter(const TestFilter* filter);
+
+    ////
+    // Measurement parameters, see class comment.
+    UTS_EXPORT void setMinSampleTime(double seconds);
+    UTS_EXPORT void setSamples(unsigned int samples);
+    UTS_EXPORT void setWarmupSamples(unsigned int samples);
+
+    ////
+    // Loads a CSV file written by writeCsv(). Returns false if the file
+    // can not be read.
+    UTS_EXPORT bool loadBaseline(const std::string& filename);
+
+    ////
+    // Prints a table of the results on the log stream.
+    UTS_EXPORT void printReport() const;
+
+    UTS_EXPORT void writeCsv(std::ostream&) const;
+    UTS_EXPORT void writeJson(std::ostream&) const;
+
+    const std::vector<Result>& results() const {return m_results;}
+
+  protected:
+    std::ostream& logS() const {return m_context->logStream();}
+
+    UTS_EXPORT virtual void measure(Benchmark& benchmark, Result& result);
+
+    TestContext* m_context;
+    double m_minSampleNs;
+    unsigned int m_samples;
+    unsigned int m_warmupSamples;
+    std::map<std::string, double> m_baseline;  // path -> median ns
+    std::vector<Result> m_results;
+    const TestFilter* m_filter;
+  };
+}
+
+#endif
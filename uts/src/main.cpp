@@ -1,14 +1,191 @@
 #include "unittestdef.h"
 #include "testrunner.h"
 #include "testqualifier.h"
+#include "benchrunner.h"
+#include "testfilter.h"
 
-int main()
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+static void usage(const char* program)
+{
+  std::cerr
+    << "usage: " << program << " [options]\n"
+    << "  --jobs=N              run each test in a child process, N at a time\n"
+    << "                        (0 for one per cpu)\n"
+    << "  --timeout=SECONDS     kill a test running longer, implies --jobs=1\n"
+    << "  --time-budget=SECONDS fail a test running longer\n"
+    << "  --slowest=N           list the N slowest tests with their metrics\n"
+    << "  --counters            count instructions and cache misses per test\n"
+    << "  --max-leaks=N         fail a test leaving more than N blocks allocated\n"
+    << "  --filter=GLOB         run the tests whose path matches, '-GLOB' skips\n"
+    << "                        them; may be repeated\n"
+    << "  --filter-regex=RE     run the tests whose path contains a match of RE\n"
+    << "  --shard=I/N           run the I-th (0 based) of N parts of the tests\n"
+    << "  --repeat=N            run the tests N times\n"
+    << "  --shuffle[=SEED]      run the tests in random order\n"
+    << "  --bench               measure the benchmarks instead of running tests\n"
+    << "  --bench-format=F      write results as csv or json (to stdout)\n"
+    << "  --bench-out=FILE      write the results to FILE instead\n"
+    << "  --bench-baseline=FILE compare with a csv written earlier\n"
+    << "  --bench-time=SECONDS  minimum time of one sample (default 0.01)\n"
+    << "  --bench-samples=N     measured samples (default 10)\n";
+}
+
+// Returns true and sets value if arg is "name=value".
+static bool option(const std::string& arg, const char* name, std::string& value)
+{
+  std::string prefix = std::string(name) + "=";
+  if (arg.compare(0, prefix.size(), prefix) != 0)
+    return false;
+  value = arg.substr(prefix.size());
+  return true;
+}
+
+static int runBenchmarks(uts::TestContext& context,
+                         const uts::TestFilter& filter, const std::string& format,
+                         const std::string& output, const std::string& baseline,
+                         double sampleTime, unsigned int samples)
 {
   using namespace uts;
-  
+
+  BenchmarkRunner runner(&context);
+  runner.setFilter(&filter);
+  if (sampleTime > 0)
+    runner.setMinSampleTime(sampleTime);
+  if (samples > 0)
+    runner.setSamples(samples);
+  if (!baseline.empty() && !runner.loadBaseline(baseline))
+    context.logStream() << "can not read baseline " << baseline << std::endl;
+  uts::root().accept(runner);
+  runner.printReport();
+
+  if (format.empty())
+    return 0;
+  std::ofstream file;
+  if (!output.empty()) {
+    file.open(output.c_str());
+    if (!file) {
+      context.logStream() << "can not write " << output << std::endl;
+      return 1;
+    }
+  }
+  std::ostream& out = output.empty() ? std::cout : file;
+  if (format == "json")
+    runner.writeJson(out);
+  else
+    runner.writeCsv(out);
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  using namespace uts;
+
+  bool bench = false;
+  std::string format, output, baseline, value;
+  double sampleTime = 0;
+  unsigned int samples = 0;
+  int jobs = -1;
+  double timeout = 0;
+  double budget = 0;
+  unsigned int slowest = 0;
+  bool counters = false;
+  long long maxLeaks = -1;
+  TestFilter filter;
+  unsigned int shardIndex = 0, shardCount = 1, repeat = 1;
+  bool shuffle = false;
+  unsigned long seed = (unsigned long)time(0);
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--bench")
+      bench = true;
+    else if (option(arg, "--bench-format", format)) {
+      if (format != "csv" && format != "json") {
+        usage(argv[0]);
+        return 2;
+      }
+    }
+    else if (option(arg, "--bench-out", output)) {
+      if (format.empty())
+        format = "csv";
+    }
+    else if (option(arg, "--bench-baseline", baseline))
+      ;
+    else if (option(arg, "--bench-time", value))
+      sampleTime = std::atof(value.c_str());
+    else if (option(arg, "--bench-samples", value))
+      samples = std::atoi(value.c_str());
+    else if (option(arg, "--jobs", value)) {
+      jobs = std::atoi(value.c_str());
+      if (jobs <= 0)
+        jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    else if (option(arg, "--timeout", value))
+      timeout = std::atof(value.c_str());
+    else if (option(arg, "--time-budget", value))
+      budget = std::atof(value.c_str());
+    else if (option(arg, "--slowest", value))
+      slowest = std::atoi(value.c_str());
+    else if (arg == "--counters")
+      counters = true;
+    else if (option(arg, "--max-leaks", value))
+      maxLeaks = std::atoll(value.c_str());
+    else if (option(arg, "--filter", value))
+      filter.addGlob(value);
+    else if (option(arg, "--filter-regex", value)) {
+      if (!filter.addRegex(value)) {
+        std::cerr << "invalid regular expression " << value << std::endl;
+        return 2;
+      }
+    }
+    else if (option(arg, "--shard", value)) {
+      if (std::sscanf(value.c_str(), "%u/%u", &shardIndex, &shardCount) != 2
+          || shardIndex >= shardCount) {
+        usage(argv[0]);
+        return 2;
+      }
+    }
+    else if (option(arg, "--repeat", value))
+      repeat = std::atoi(value.c_str());
+    else if (arg == "--shuffle")
+      shuffle = true;
+    else if (option(arg, "--shuffle", value)) {
+      shuffle = true;
+      seed = std::strtoul(value.c_str(), 0, 10);
+    }
+    else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
   TestContext context;
+  if (bench)
+    return runBenchmarks(context, filter, format, output, baseline, sampleTime,
+                         samples);
+
   TestRunner runner(&context);
+  if (jobs < 0 && timeout > 0)
+    jobs = 1;
+  if (jobs > 0)
+    runner.setParallel(jobs, timeout);
+  runner.setFilter(&filter);
+  runner.setShard(shardIndex, shardCount);
+  runner.setRepeat(repeat);
+  runner.setShuffle(shuffle, seed);
+  runner.setTimeBudget(budget);
+  runner.setLeakLimit(maxLeaks);
+  runner.setSlowestReport(slowest);
+  if (counters)
+    runner.setCounters(true);
   uts::root().accept(runner);
+  runner.finishTests();
   runner.printSummary();
   
   return 0;
@@ -0,0 +1,120 @@
+#include "testfilter.h"
+
+#ifndef _WIN32
+#include <fnmatch.h>
+#include <regex.h>
+#endif
+
+namespace uts
+{
+#ifdef _WIN32
+  // fnmatch() without flags: '*' and '?' also match '/', '[...]' is a
+  // set of characters or ranges, negated by a leading '!'.
+  static bool globMatches(const char* glob, const char* text)
+  {
+    for (; *glob != '\0'; ++glob, ++text) {
+      if (*glob == '*') {
+        for (const char* rest = text; ; ++rest) {
+          if (globMatches(glob + 1, rest))
+            return true;
+          if (*rest == '\0')
+            return false;
+        }
+      }
+      if (*text == '\0')
+        return false;
+      if (*glob == '[') {
+        const char* set = glob + 1;
+        bool negated = *set == '!';
+        if (negated)
+          ++set;
+        bool found = false;
+        const char* end = set;
+        do {
+          if (end[1] == '-' && end[2] != ']' && end[2] != '\0') {
+            if (*text >= end[0] && *text <= end[2])
+              found = true;
+            end += 3;
+          }
+          else if (*text == *end++)
+            found = true;
+        } while (*end != ']' && *end != '\0');
+        if (*end == ']') {
+          if (found == negated)
+            return false;
+          glob = end;
+          continue;
+        }
+        // no closing bracket, so the '[' is an ordinary character.
+      }
+      if (*glob != '?' && *glob != *text)
+        return false;
+    }
+    return *text == '\0';
+  }
+#else
+  static bool globMatches(const char* glob, const char* text)
+  {
+    return fnmatch(glob, text, 0) == 0;
+  }
+#endif
+
+  TestFilter::TestFilter()
+  {
+  }
+
+  TestFilter::~TestFilter()
+  {
+#ifndef _WIN32
+    for (size_t i = 0; i < m_regexes.size(); ++i) {
+      regex_t* regex = static_cast<regex_t*>(m_regexes[i]);
+      regfree(regex);
+      delete regex;
+    }
+#endif
+  }
+
+  void TestFilter::addGlob(const std::string& glob)
+  {
+    if (!glob.empty() && glob[0] == '-')
+      m_excludes.push_back(glob.substr(1));
+    else
+      m_globs.push_back(glob);
+  }
+
+  bool TestFilter::addRegex(const std::string& expression)
+  {
+#ifdef _WIN32
+    // there is no regcomp() on Windows.
+    return false;
+#else
+    regex_t* regex = new regex_t;
+    if (regcomp(regex, expression.c_str(), REG_EXTENDED | REG_NOSUB) != 0) {
+      delete regex;
+      return false;
+    }
+    m_regexes.push_back(regex);
+    return true;
+#endif
+  }
+
+  bool TestFilter::matches(const std::string& path) const
+  {
+    for (size_t i = 0; i < m_excludes.size(); ++i)
+      if (globMatches(m_excludes[i].c_str(), path.c_str()))
+        return false;
+
+    if (m_globs.empty() && m_regexes.empty())
+      return true;
+    for (size_t i = 0; i < m_globs.size(); ++i)
+      if (globMatches(m_globs[i].c_str(), path.c_str()))
+        return true;
+#ifndef _WIN32
+    for (size_t i = 0; i < m_regexes.size(); ++i)
+      if (regexec(static_cast<regex_t*>(m_regexes[i]), path.c_str(),
+                  0, 0, 0) == 0)
+        return true;
+#endif
+    return false;
+  }
+}
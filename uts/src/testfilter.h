@@ -0,0 +1,46 @@
+#if !defined(TESTFILTER_HPP_INCLUDED)
+#define TESTFILTER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "utsdefs.h"
+
+namespace uts
+{
+
+  /*
+    TestFilter selects test cases by their path, as maintained by
+    TestQualifier (e.g. "/ExampleTests/BasicTests/SimpleStuff_1").
+
+    Globs match the whole path, '*' also matches the '/' separators. A
+    glob starting with '-' excludes the paths it matches. Regular
+    expressions (POSIX extended) select a path if they match any part of
+    it. Without any including pattern every path not excluded is
+    selected.
+  */
+
+  class TestFilter
+  {
+  public:
+    UTS_EXPORT TestFilter();
+    UTS_EXPORT ~TestFilter();
+
+    UTS_EXPORT void addGlob(const std::string& glob);
+    ////
+    // Returns false if the expression does not compile, and always on
+    // Windows, which has no POSIX regular expressions.
+    UTS_EXPORT bool addRegex(const std::string& regex);
+
+    UTS_EXPORT bool matches(const std::string& path) const;
+
+  private:
+    TestFilter(const TestFilter&);
+    TestFilter& operator=(const TestFilter&);
+
+    std::vector<std::string> m_globs;
+    std::vector<std::string> m_excludes;
+    std::vector<void*> m_regexes;  // compiled regex_t
+  };
+}
+#endif
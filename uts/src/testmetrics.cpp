@@ -0,0 +1,154 @@
+#ifndef _WIN32
+#include "testmetrics.h"
+
+#include <cstring>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+namespace uts
+{
+  static double clockNs(clockid_t clock)
+  {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+  }
+
+  static int openCounter(unsigned int type, unsigned long long config)
+  {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;  // allowed with perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  TestMeter::TestMeter()
+    : m_wallStart(0), m_cpuStart(0), m_rssStart(0), m_switchesStart(0)
+  {
+    for (int i = 0; i < COUNTERS; ++i)
+      m_fds[i] = -1;
+  }
+
+  TestMeter::~TestMeter()
+  {
+    for (int i = 0; i < COUNTERS; ++i)
+      if (m_fds[i] >= 0)
+        close(m_fds[i]);
+  }
+
+  bool TestMeter::enableCounters()
+  {
+    if (m_fds[0] >= 0)
+      return true;
+    m_fds[INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE,
+                                      PERF_COUNT_HW_INSTRUCTIONS);
+    m_fds[CACHE_MISSES] = openCounter(PERF_TYPE_HARDWARE,
+                                      PERF_COUNT_HW_CACHE_MISSES);
+    for (int i = 0; i < COUNTERS; ++i) {
+      if (m_fds[i] < 0) {
+        for (int j = 0; j < COUNTERS; ++j) {
+          if (m_fds[j] >= 0)
+            close(m_fds[j]);
+          m_fds[j] = -1;
+        }
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void TestMeter::start()
+  {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    m_rssStart = usage.ru_maxrss;
+    m_switchesStart = usage.ru_nvcsw + usage.ru_nivcsw;
+    for (int i = 0; i < COUNTERS; ++i) {
+      if (m_fds[i] >= 0) {
+        ioctl(m_fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+    countAllocations(true);
+    readAllocationCounts(m_allocationsStart);
+    m_cpuStart = clockNs(CLOCK_PROCESS_CPUTIME_ID);
+    m_wallStart = clockNs(CLOCK_MONOTONIC);
+  }
+
+  void TestMeter::stop(TestMetrics& metrics)
+  {
+    metrics.wallNs = clockNs(CLOCK_MONOTONIC) - m_wallStart;
+    metrics.cpuNs = clockNs(CLOCK_PROCESS_CPUTIME_ID) - m_cpuStart;
+    AllocationCounts allocations;
+    readAllocationCounts(allocations);
+    countAllocations(false);
+    metrics.allocations = allocations.allocations
+                          - m_allocationsStart.allocations;
+    metrics.allocatedBytes = allocations.allocatedBytes
+                             - m_allocationsStart.allocatedBytes;
+    metrics.leakedBlocks = allocations.liveBlocks
+                           - m_allocationsStart.liveBlocks;
+    metrics.leakedBytes = allocations.liveBytes - m_allocationsStart.liveBytes;
+
+    unsigned long long counts[COUNTERS];
+    metrics.hasCounters = m_fds[0] >= 0;
+    for (int i = 0; i < COUNTERS; ++i) {
+      counts[i] = 0;
+      if (m_fds[i] < 0)
+        continue;
+      ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(m_fds[i], &counts[i], sizeof(counts[i])) != sizeof(counts[i]))
+        metrics.hasCounters = false;
+    }
+    metrics.instructions = counts[INSTRUCTIONS];
+    metrics.cacheMisses = counts[CACHE_MISSES];
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    metrics.peakRssDeltaKb = usage.ru_maxrss - m_rssStart;
+    metrics.contextSwitches = usage.ru_nvcsw + usage.ru_nivcsw - m_switchesStart;
+  }
+}
+#else
+#include "testmetrics.h"
+
+namespace uts
+{
+  // Windows has no perf_event_open() and the runner does not measure
+  // the tests there, so the meter only reports zeros.
+  TestMeter::TestMeter()
+    : m_wallStart(0), m_cpuStart(0), m_rssStart(0), m_switchesStart(0)
+  {
+    for (int i = 0; i < COUNTERS; ++i)
+      m_fds[i] = -1;
+  }
+
+  TestMeter::~TestMeter()
+  {
+  }
+
+  bool TestMeter::enableCounters()
+  {
+    return false;
+  }
+
+  void TestMeter::start()
+  {
+  }
+
+  void TestMeter::stop(TestMetrics& metrics)
+  {
+    metrics = TestMetrics();
+  }
+}
+#endif
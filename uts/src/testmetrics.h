@@ -0,0 +1,68 @@
+#if !defined(TESTMETRICS_HPP_INCLUDED)
+#define TESTMETRICS_HPP_INCLUDED
+
+#include "allocations.h"
+#include "utsdefs.h"
+
+namespace uts
+{
+
+  /*
+    TestMetrics is what the runner measured around one test case. The
+    peak RSS delta is how much the test raised the high water mark of
+    the process, which is 0 for a test staying below what was used
+    before. Instructions and cache misses are only set when hasCounters
+    is true. The allocations are counted as described with
+    AllocationCounts.
+  */
+
+  struct TestMetrics
+  {
+    double             wallNs;
+    double             cpuNs;            // user and system, all threads
+    long               peakRssDeltaKb;
+    long               contextSwitches;  // voluntary and involuntary
+    bool               hasCounters;
+    unsigned long long instructions;
+    unsigned long long cacheMisses;
+    long long          allocations;      // see AllocationCounts
+    long long          allocatedBytes;
+    long long          leakedBlocks;     // allocated and not freed
+    long long          leakedBytes;
+  };
+
+  /*
+    TestMeter takes the measurements of TestMetrics between start() and
+    stop(). The hardware counters come from perf_event_open(), for user
+    space of this process and the threads it creates afterwards.
+  */
+
+  class TestMeter
+  {
+  public:
+    UTS_EXPORT TestMeter();
+    UTS_EXPORT ~TestMeter();
+
+    ////
+    // Opens the hardware counters. Returns false if the kernel or its
+    // perf_event_paranoid setting does not allow them.
+    UTS_EXPORT bool enableCounters();
+
+    UTS_EXPORT void start();
+    UTS_EXPORT void stop(TestMetrics& metrics);
+
+  private:
+    TestMeter(const TestMeter&);
+    TestMeter& operator=(const TestMeter&);
+
+    enum {INSTRUCTIONS, CACHE_MISSES, COUNTERS};
+
+    int    m_fds[COUNTERS];
+    double m_wallStart;
+    double m_cpuStart;
+    long   m_rssStart;
+    long   m_switchesStart;
+    AllocationCounts m_allocationsStart;
+  };
+}
+#endif
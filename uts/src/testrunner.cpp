@@ -1,22 +1,89 @@
 #ifndef _WIN32
 #include "testrunner.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <sstream>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
 
 
 namespace uts
 {
   TestRunner::TestRunner(TestContext* context)
-    : m_context(context), m_tests(0), m_failures(0), m_errors(0)
+    : m_context(context), m_tests(0), m_failures(0), m_errors(0),
+      m_jobs(0), m_timeout(0), m_counters(false), m_budgetNs(0),
+      m_leakLimit(-1), m_slowest(0),
+      m_filter(0), m_shardIndex(0), m_shardCount(1), m_selected(0),
+      m_repeat(1), m_shuffle(false), m_seed(0)
   {
     assert(context);
   }
 
+  void TestRunner::setParallel(unsigned int jobs, double timeout)
+  {
+    m_jobs = jobs;
+    m_timeout = timeout;
+  }
+
+  void TestRunner::setCounters(bool enabled)
+  {
+    m_counters = enabled;
+    if (enabled && !m_meter.enableCounters())
+      logS() << "hardware counters are not available\n";
+  }
+
+  void TestRunner::setTimeBudget(double seconds)
+  {
+    m_budgetNs = seconds * 1e9;
+  }
+
+  void TestRunner::setLeakLimit(long long blocks)
+  {
+    m_leakLimit = blocks;
+  }
+
+  void TestRunner::setSlowestReport(unsigned int count)
+  {
+    m_slowest = count;
+  }
+
   bool TestRunner::shouldVisit(const std::string& path) const
   {
-    return true;
+    if (path.empty() || path[path.size() - 1] == SEPCHAR)
+      return true;
+    return m_filter == 0 || m_filter->matches(path);
+  }
+
+  void TestRunner::setFilter(const TestFilter* filter)
+  {
+    m_filter = filter;
+  }
+
+  void TestRunner::setShard(unsigned int index, unsigned int count)
+  {
+    assert(count > 0 && index < count);
+    m_shardIndex = index;
+    m_shardCount = count;
+  }
+
+  void TestRunner::setRepeat(unsigned int count)
+  {
+    m_repeat = count > 0 ? count : 1;
+  }
+
+  void TestRunner::setShuffle(bool shuffle, unsigned long seed)
+  {
+    m_shuffle = shuffle;
+    m_seed = seed;
   }
 
   void TestRunner::printSummary() const
@@ -30,6 +97,47 @@ namespace uts
             << m_errors << " error(s)\n"
       << "============================================================\n"
       << std::endl;
+    if (m_slowest > 0)
+      printSlowest();
+  }
+
+  static bool slower(const TestRunner::Result* a, const TestRunner::Result* b)
+  {
+    return a->metrics.wallNs > b->metrics.wallNs;
+  }
+
+  void TestRunner::printSlowest() const
+  {
+    std::vector<const Result*> results;
+    for (size_t i = 0; i < m_results.size(); ++i)
+      results.push_back(&m_results[i]);
+    size_t count = std::min<size_t>(m_slowest, results.size());
+    std::partial_sort(results.begin(), results.begin() + count, results.end(),
+                      slower);
+
+    char line[512];
+    logS() << "Slowest " << count << " test(s):\n";
+    snprintf(line, sizeof(line), "%12s %12s %9s %7s %9s %7s %14s %12s  %s\n",
+             "wall ms", "cpu ms", "rss KiB", "ctx sw", "allocs", "leaked",
+             "instructions", "cache misses", "test");
+    logS() << line;
+    for (size_t i = 0; i < count; ++i) {
+      const TestMetrics& m = results[i]->metrics;
+      char instructions[32] = "-";
+      char misses[32] = "-";
+      if (m.hasCounters) {
+        snprintf(instructions, sizeof(instructions), "%llu", m.instructions);
+        snprintf(misses, sizeof(misses), "%llu", m.cacheMisses);
+      }
+      snprintf(line, sizeof(line),
+               "%12.3f %12.3f %9ld %7ld %9lld %7lld %14s %12s  %s%s\n",
+               m.wallNs / 1e6, m.cpuNs / 1e6, m.peakRssDeltaKb,
+               m.contextSwitches, m.allocations, m.leakedBlocks,
+               instructions, misses,
+               results[i]->path.c_str(), results[i]->failed ? " (failed)" : "");
+      logS() << line;
+    }
+    logS() << std::endl;
   }
 
   inline std::string outputLine(const std::string& file, long line)
@@ -58,16 +166,45 @@ namespace uts
   {
     return TestQualifier::visitLeave(suite) && !m_context->shouldStop();
   }
+  inline std::string formatMs(double ns)
+  {
+    char text[32];
+    snprintf(text, sizeof(text), "%.3f ms", ns / 1e6);
+    return text;
+  }
+
   /*
-   * run the test case
-   * return 0 for pass. -1 for fail.
+   * run the test case, measuring it with meter.
+   * return 0 for pass. -1 for fail, also when it took longer than the
+   * time budget or leaked more blocks than the leak limit.
    */
-  inline int runTestCase( TestCase & test, TestContext & context, std::ostream & log)
+  int TestRunner::runTestCase(TestCase& test, const std::string& path,
+                              TestContext& context, std::ostream& log,
+                              TestMeter& meter, TestMetrics& metrics) const
   {
     int rst = 0;
+    meter.start();
     try {
       test.run(context);
-      log << test.name() << " Passed " << std::endl;
+      meter.stop(metrics);
+      if (m_budgetNs > 0 && metrics.wallNs > m_budgetNs) {
+        log << path << ": took " << formatMs(metrics.wallNs)
+            << ", over the budget of " << formatMs(m_budgetNs) << '\n'
+            << "FAILED: ";
+        return -1;
+      }
+      if (m_leakLimit >= 0 && metrics.leakedBlocks > m_leakLimit) {
+        log << path << ": leaked " << metrics.leakedBlocks << " block(s) of "
+            << metrics.leakedBytes << " bytes, over the limit of "
+            << m_leakLimit << '\n'
+            << "FAILED: ";
+        return -1;
+      }
+      log << test.name() << " Passed " << formatMs(metrics.wallNs);
+      if (metrics.leakedBlocks > 0)
+        log << ", " << metrics.leakedBlocks << " block(s) of "
+            << metrics.leakedBytes << " bytes not freed";
+      log << std::endl;
       rst = 0;
     }
     catch (XTestFailure& e) {
@@ -80,6 +217,8 @@ namespace uts
           << "FAILED: ";
       rst = -1;
     }
+    if (rst != 0)
+      meter.stop(metrics);
     return rst;
   }
 
@@ -88,16 +227,252 @@ namespace uts
     if (m_context->shouldStop())
       return false;
     if (!shouldVisit(currentPath() + test.name()))
-      return false;
+      return true;  // skip it, but go on with its siblings
 
-    int rst = runTestCase(test, *m_context, logS());
+    if (m_selected++ % m_shardCount != m_shardIndex)
+      return true;
+
+    std::string path = currentPath() + test.name();
+    if (m_repeat > 1 || m_shuffle) {
+      Queued queued;
+      queued.test = &test;
+      queued.path = path;
+      m_queue.push_back(queued);
+      return true;
+    }
+    runTest(test, path);
+    // Always continue, regardless of test result, unless the context
+    // object says otherwise.
+    return !m_context->shouldStop();
+  }
+
+  void TestRunner::runTest(TestCase& test, const std::string& path)
+  {
+    if (m_jobs > 0) {
+      forkTest(test, path);
+      return;
+    }
+
+    Result result;
+    result.path = path;
+    int rst = runTestCase(test, path, *m_context, logS(), m_meter,
+                          result.metrics);
     if( 0 != rst )
         m_failures++;
+    result.failed = rst != 0;
+    m_results.push_back(result);
     
     m_tests++;
-    // Always continue, regardless of test result, unless the context
-    // object says otherwise.
-    return !m_context->shouldStop();
+  }
+
+  static double monotonicSeconds()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  // Exit codes of a forked test.
+  enum {CHILD_PASSED = 0, CHILD_FAILED = 1, CHILD_FAILED_STOP = 2};
+
+  void TestRunner::forkTest(TestCase& test, const std::string& path)
+  {
+    while (m_children.size() >= m_jobs)
+      reapChild();
+    if (m_context->shouldStop())
+      return;
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+      logS() << path << ": can not create pipe: " << strerror(errno) << '\n';
+      m_errors++;
+      return;
+    }
+    // Do not let the child flush what the parent has buffered.
+    logS().flush();
+    std::cout.flush();
+    fflush(0);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      std::ostringstream log;
+      TestContext context(&log);
+      TestMeter meter;
+      if (m_counters)
+        meter.enableCounters();
+      TestMetrics metrics;
+      int rst = runTestCase(test, path, context, log, meter, metrics);
+      // The metrics go first, then the log output.
+      std::string text(reinterpret_cast<const char*>(&metrics),
+                       sizeof(metrics));
+      text += log.str();
+      const char* p = text.data();
+      size_t left = text.size();
+      while (left > 0) {
+        ssize_t n = write(fds[1], p, left);
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n <= 0)
+          break;
+        p += n;
+        left -= n;
+      }
+      std::cout.flush();
+      fflush(0);
+      _exit(rst == 0 ? CHILD_PASSED :
+            context.shouldStop() ? CHILD_FAILED_STOP : CHILD_FAILED);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+      close(fds[0]);
+      logS() << path << ": can not fork: " << strerror(errno) << '\n';
+      m_errors++;
+      return;
+    }
+
+    Child child;
+    child.pid = pid;
+    child.fd = fds[0];
+    child.path = path;
+    child.started = monotonicSeconds();
+    child.deadline = m_timeout > 0 ? child.started + m_timeout : 0;
+    child.timedOut = false;
+    m_children.push_back(child);
+  }
+
+  void TestRunner::reapChild()
+  {
+    for (;;) {
+      double now = monotonicSeconds();
+      int wait = -1;
+      std::vector<struct pollfd> fds(m_children.size());
+      for (size_t i = 0; i < m_children.size(); ++i) {
+        Child& child = m_children[i];
+        if (child.deadline > 0 && !child.timedOut) {
+          if (now >= child.deadline) {
+            kill(child.pid, SIGKILL); // its pipe closes when it is gone
+            child.timedOut = true;
+          }
+          else {
+            int ms = (int)((child.deadline - now) * 1000) + 1;
+            if (wait < 0 || ms < wait)
+              wait = ms;
+          }
+        }
+        fds[i].fd = child.fd;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+      }
+      if (poll(&fds[0], fds.size(), wait) < 0 && errno != EINTR)
+        return;
+
+      for (size_t i = 0; i < m_children.size(); ++i) {
+        if (fds[i].revents == 0)
+          continue;
+        Child& child = m_children[i];
+        char buf[4096];
+        ssize_t n = read(child.fd, buf, sizeof(buf));
+        if (n > 0) {
+          child.output.append(buf, n);
+          continue;
+        }
+        if (n < 0 && errno == EINTR)
+          continue;
+        // End of output: the child has exited (or closed its pipe).
+        int status = 0;
+        struct rusage usage;
+        std::memset(&usage, 0, sizeof(usage));
+        while (wait4(child.pid, &status, 0, &usage) < 0 && errno == EINTR)
+          ;
+        close(child.fd);
+        Child done = child;
+        m_children.erase(m_children.begin() + i);
+
+        TestMetrics metrics;
+        if (WIFEXITED(status) && done.output.size() >= sizeof(metrics)) {
+          std::memcpy(&metrics, done.output.data(), sizeof(metrics));
+          done.output.erase(0, sizeof(metrics));
+        }
+        else {
+          // Crashed or killed: what can be told from outside.
+          std::memset(&metrics, 0, sizeof(metrics));
+          metrics.wallNs = (monotonicSeconds() - done.started) * 1e9;
+          metrics.cpuNs = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e9
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e3;
+          metrics.contextSwitches = usage.ru_nvcsw + usage.ru_nivcsw;
+        }
+        finishChild(done, status, metrics);
+        return;
+      }
+    }
+  }
+
+  void TestRunner::finishChild(Child& child, int status,
+                               const TestMetrics& metrics)
+  {
+    int failures = m_failures + m_errors;
+    m_tests++;
+    logS() << child.output;
+    if (child.timedOut) {
+      logS() << child.path << ": timed out after " << m_timeout << "s\n"
+             << "FAILED: ";
+      m_failures++;
+    }
+    else if (WIFSIGNALED(status)) {
+      logS() << child.path << ": crashed with signal " << WTERMSIG(status)
+             << " (" << strsignal(WTERMSIG(status)) << ")\n" << "ERROR: ";
+      m_errors++;
+    }
+    else if (WIFEXITED(status) && WEXITSTATUS(status) != CHILD_PASSED) {
+      m_failures++;
+      if (WEXITSTATUS(status) == CHILD_FAILED_STOP)
+        m_context->stopTests();
+    }
+
+    Result result;
+    result.path = child.path;
+    result.metrics = metrics;
+    result.failed = m_failures + m_errors != failures;
+    m_results.push_back(result);
+  }
+
+  // splitmix64, the same order for a seed on every platform.
+  static unsigned long long nextRandom(unsigned long long& state)
+  {
+    unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  void TestRunner::finishTests()
+  {
+    for (unsigned int round = 0; round < m_repeat && !m_queue.empty(); ++round) {
+      if (m_context->shouldStop())
+        break;
+      std::vector<Queued> order(m_queue);
+      if (m_shuffle) {
+        unsigned long long state = m_seed + round;
+        for (size_t i = order.size() - 1; i > 0; --i)
+          std::swap(order[i], order[nextRandom(state) % (i + 1)]);
+      }
+      if (m_repeat > 1 || m_shuffle) {
+        logS() << "Round " << round + 1 << " of " << m_repeat;
+        if (m_shuffle)
+          logS() << ", shuffled with seed " << m_seed + round;
+        logS() << std::endl;
+      }
+      for (size_t i = 0; i < order.size() && !m_context->shouldStop(); ++i)
+        runTest(*order[i].test, order[i].path);
+      // finish the round before the next one starts.
+      while (!m_children.empty())
+        reapChild();
+    }
+    m_queue.clear();
+
+    while (!m_children.empty())
+      reapChild();
   }
 }
 #endif
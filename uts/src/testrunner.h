@@ -2,8 +2,11 @@
 #define TESTRUNNER_HPP_INCLUDED
 
 #include "testqualifier.h"
+#include "testmetrics.h"
+#include "testfilter.h"
 
 #include <string>
+#include <vector>
 #include <iostream>
 
 #include "utsdefs.h"
@@ -24,6 +27,14 @@ namespace uts
   class TestRunner: public TestQualifier
   {
   public:
+    // What was measured of one test case, see setSlowestReport().
+    struct Result
+    {
+      std::string path;
+      TestMetrics metrics;
+      bool        failed;
+    };
+
     UTS_EXPORT TestRunner(TestContext*);
 
     // TestRunner::visitEnter returns false if TestContext.shouldStop() or
@@ -35,21 +46,120 @@ namespace uts
     UTS_EXPORT virtual bool visit(TestCase&);
 
     ////
-    // Default implementation returns true. Derived classes
+    // Default implementation returns true for suites and for the
+    // tests selected by the filter, see setFilter(). Derived classes
     // may override. This is called once before visiting each
     // suite or test.
     UTS_EXPORT virtual bool shouldVisit(const std::string& path) const;
 
+    ////
+    // Runs only the tests whose path the filter matches. The filter
+    // must stay valid while the runner visits, 0 runs all tests.
+    UTS_EXPORT void setFilter(const TestFilter* filter);
+
+    ////
+    // Runs only every count-th of the selected tests, starting with the
+    // index-th (0 based), to spread one test run over count machines.
+    UTS_EXPORT void setShard(unsigned int index, unsigned int count);
+
+    ////
+    // Runs the selected tests count times. With shuffle the order of
+    // each round is randomized from seed (rounds after the first use
+    // the following seeds), so a failing order can be replayed.
+    // Either makes visit() only collect the tests, finishTests() runs
+    // them.
+    UTS_EXPORT void setRepeat(unsigned int count);
+    UTS_EXPORT void setShuffle(bool shuffle, unsigned long seed);
+
+    ////
+    // Runs each test case in a forked child process, up to jobs of them
+    // at a time. A test which crashes counts as an error and does not
+    // take the run down. A test running longer than timeout seconds
+    // (0 for no limit) is killed and counts as a failure. The default,
+    // jobs 0, runs the tests in this process.
+    UTS_EXPORT void setParallel(unsigned int jobs, double timeout);
+
+    ////
+    // Runs the tests collected for repeating or shuffling and waits for
+    // the forked tests which are still running. Call it after the visit
+    // and before printSummary().
+    UTS_EXPORT void finishTests();
+
+    ////
+    // Also counts instructions and cache misses of each test, if the
+    // kernel allows it (see TestMeter).
+    UTS_EXPORT void setCounters(bool enabled);
+
+    ////
+    // Fails a test whose wall time exceeds seconds, 0 for no budget.
+    UTS_EXPORT void setTimeBudget(double seconds);
+
+    ////
+    // Fails a test which returns with more than blocks allocated blocks
+    // not freed (see AllocationCounts), -1 for no limit.
+    UTS_EXPORT void setLeakLimit(long long blocks);
+
+    ////
+    // Makes printSummary() list the count slowest tests with their
+    // metrics, 0 for no list.
+    UTS_EXPORT void setSlowestReport(unsigned int count);
+
     ////
     // Prints a summary of the test counts on the log stream.
     UTS_EXPORT void printSummary() const;
   protected:
     std::ostream& logS() const {return m_context->logStream();}
 
+    // A test running in a forked child process.
+    struct Child
+    {
+      int         pid;
+      int         fd;         // read end of the pipe with its log output
+      std::string path;
+      std::string output;
+      double      started;    // monotonic seconds
+      double      deadline;   // monotonic seconds, 0 for no limit
+      bool        timedOut;
+    };
+
+    // A test collected for repeating or shuffling.
+    struct Queued
+    {
+      TestCase*   test;
+      std::string path;
+    };
+
+    void runTest(TestCase& test, const std::string& path);
+    int runTestCase(TestCase& test, const std::string& path,
+                    TestContext& context, std::ostream& log,
+                    TestMeter& meter, TestMetrics& metrics) const;
+    void forkTest(TestCase& test, const std::string& path);
+    // Waits until a child finished (or timed out) and accounts for it.
+    void reapChild();
+    void finishChild(Child& child, int status, const TestMetrics& metrics);
+    void printSlowest() const;
+
     TestContext* m_context;
     int m_tests;
     int m_failures;
     int m_errors;
+    unsigned int m_jobs;
+    double m_timeout;
+    std::vector<Child> m_children;
+    bool m_counters;
+    double m_budgetNs;
+    long long m_leakLimit;
+    unsigned int m_slowest;
+    TestMeter m_meter;
+    std::vector<Result> m_results;
+    const TestFilter* m_filter;
+    unsigned int m_shardIndex;
+    unsigned int m_shardCount;
+    unsigned int m_selected;  // tests selected so far, before sharding
+    unsigned int m_repeat;
+    bool m_shuffle;
+    unsigned long m_seed;
+    std::vector<Queued> m_queue;
   };
 }
 
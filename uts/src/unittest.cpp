@@ -1,6 +1,7 @@
 #include "unittest.h"
 
 #include <algorithm>
+#include <ctime>
 
 #include "unittestdef.h"
 
@@ -86,6 +87,59 @@ namespace uts
     return v.visit(*this);
   }
 
+  static double monotonicNs()
+  {
+#if defined(_WIN32)
+    return (double)clock() * 1e9 / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+#endif
+  }
+
+  BenchmarkState::BenchmarkState(TestContext& context, unsigned long iterations)
+    : m_context(context), m_iterations(iterations), m_remaining(iterations),
+      m_running(false), m_startNs(0), m_elapsedNs(0)
+  {
+  }
+
+  void BenchmarkState::pauseTiming()
+  {
+    if (m_running) {
+      m_elapsedNs += monotonicNs() - m_startNs;
+      m_running = false;
+    }
+  }
+
+  void BenchmarkState::resumeTiming()
+  {
+    if (!m_running) {
+      m_running = true;
+      m_startNs = monotonicNs();
+    }
+  }
+
+  Benchmark::Benchmark(const std::string& name, TestSuite& parent)
+    : TestCase(name, parent)
+  {
+  }
+
+  void Benchmark::run(TestContext& context)
+  {
+    measure(context, 1);
+  }
+
+  double Benchmark::measure(TestContext& context, unsigned long iterations)
+  {
+    BenchmarkState state(context, iterations);
+    runBody(state);
+    if (!state.finished())
+      throw XTestFailure("benchmark body did not loop until keepRunning() "
+                         "returned false", name(), 0);
+    return state.elapsedNs();
+  }
+
   TestSuite::TestSuite(const std::string& name, TestSuite& parent)
     :Test(name, parent)
   {
@@ -38,4 +38,22 @@ namespace uts
     (*m_func)(context);
   }
 
+  IndirectBenchmark::IndirectBenchmark(const char* name, TestSuite& suite,
+                                       void (*func)(BenchmarkState&))
+    :Benchmark(name, suite), m_func(func)
+  {
+  }
+
+  void IndirectBenchmark::runBody (BenchmarkState& state)
+  {
+    (*m_func)(state);
+  }
+
+#if !defined(__GNUC__)
+  // Out of line, so the compiler can not see that it does nothing.
+  void useCharPointer(const volatile char*)
+  {
+  }
+#endif
+
 }
@@ -1,4 +1,5 @@
-#include <unittestdef.h>
+#include <unittestdef.h>
+#include <string>
 
 /*
  Some sample tests, with the following hierarchy:
@@ -39,3 +40,15 @@ DefineTestCase(SimpleStuff_1, BasicTests);
 //DefineTestCase(AdvancedStuff_1_fails, AdvancedTests);
 //DefineTestCase(SeparateSingleTest, uts::root());
 
+
+void StringAppend(uts::BenchmarkState& state)
+{
+  std::string s;
+  while (state.keepRunning()) {
+    s += 'x';
+    uts::doNotOptimize(s);
+  }
+}
+
+DefineTestSuite(ExampleBenchmarks, uts::root());
+DefineBenchmark(StringAppend, ExampleBenchmarks);